@@ -0,0 +1,372 @@
+#include "CookedMesh.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static size_t alignUp(size_t value)
+{
+	return (value + COOKED_MESH_ALIGNMENT - 1) & ~(size_t)(COOKED_MESH_ALIGNMENT - 1);
+}
+
+uint64_t CookedMeshHash(const void* pData, size_t size, uint64_t seed)
+{
+	// FNV-1a over 8 byte words, then the tail, then an avalanche so close keys spread out
+	const uint64_t Prime = 0x100000001b3ull;
+	uint64_t hash = (seed ^ 0xcbf29ce484222325ull) + size;
+
+	const uint8_t* p = (const uint8_t*)pData;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, p + i, 8);
+		hash = (hash ^ word) * Prime;
+		hash ^= hash >> 32;
+	}
+	for (; i < size; i++)
+	{
+		hash = (hash ^ p[i]) * Prime;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdull;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+bool CookedMeshReadSource(const std::string& path, std::vector<uint8_t>& bytes)
+{
+	FILE* pFile = fopen(path.c_str(), "rb");
+	if (!pFile)
+		return false;
+
+	bool ok = fseek(pFile, 0, SEEK_END) == 0;
+	long size = ok ? ftell(pFile) : -1;
+	ok = size >= 0 && fseek(pFile, 0, SEEK_SET) == 0;
+	if (ok)
+	{
+		bytes.resize((size_t)size);
+		ok = size == 0 || fread(bytes.data(), 1, (size_t)size, pFile) == (size_t)size;
+	}
+	fclose(pFile);
+	return ok;
+}
+
+bool CookedMeshHashSource(const std::string& path, uint64_t seed, uint64_t& key, uint64_t& size)
+{
+	std::vector<uint8_t> bytes;
+	if (!CookedMeshReadSource(path, bytes))
+		return false;
+
+	key = CookedMeshHash(bytes.data(), bytes.size(), seed);
+	size = bytes.size();
+	return true;
+}
+
+std::string CookedMeshCachePath(uint64_t key, const char* extension)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.", (unsigned long long)key);
+	return std::string(COOKED_CACHE_DIRECTORY) + "/" + name + extension;
+}
+
+std::string CookedMeshCanonicalPath(const std::string& path)
+{
+	const bool Absolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+
+	std::vector<std::string> parts;
+	size_t start = 0;
+	while (start <= path.size())
+	{
+		size_t end = path.find_first_of("/\\", start);
+		if (end == std::string::npos)
+			end = path.size();
+
+		std::string part = path.substr(start, end - start);
+		start = end + 1;
+
+		if (part.empty() || part == ".")
+			continue;
+		if (part == ".." && !parts.empty() && parts.back() != "..")
+			parts.pop_back();
+		else if (part != ".." || !Absolute)
+			parts.push_back(part);
+	}
+
+	std::string canonical = Absolute ? "/" : "";
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		if (i != 0)
+			canonical += '/';
+		canonical += parts[i];
+	}
+
+#ifdef _WIN32
+	for (char& c : canonical)
+	{
+		if (c >= 'A' && c <= 'Z')
+			c = c - 'A' + 'a';
+	}
+#endif
+	return canonical;
+}
+
+//////////////////////////////////////////////// DEPENDENCIES
+
+void CookedMeshAddDependencies(CookedMeshWriter& writer, const std::vector<std::string>& paths)
+{
+	CookedStreamWriter stream;
+	stream.Write((uint32_t)paths.size());
+	for (const std::string& path : paths)
+	{
+		// one that can't be read is stored as such, it recooks once it shows up
+		uint64_t key = 0, size = 0;
+		if (!CookedMeshHashSource(path, 0, key, size))
+			size = ~0ull;
+		stream.Write(path);
+		stream.Write(key);
+		stream.Write(size);
+	}
+	writer.AddChunk(COOKED_DEPENDENCIES, stream.Data());
+}
+
+bool CookedMeshDependenciesMatch(const CookedMeshFile& cooked)
+{
+	size_t chunkSize = 0;
+	const void* pChunk = cooked.Chunk(COOKED_DEPENDENCIES, &chunkSize);
+	CookedStreamReader stream(pChunk, chunkSize);
+
+	uint32_t count = 0;
+	stream.Read(count);
+	for (uint32_t i = 0; i < count && stream.Ok(); i++)
+	{
+		std::string path;
+		uint64_t cookedKey = 0, cookedSize = 0;
+		stream.Read(path);
+		stream.Read(cookedKey);
+		stream.Read(cookedSize);
+
+		uint64_t key = 0, size = 0;
+		if (!CookedMeshHashSource(path, 0, key, size))
+			size = ~0ull;
+		if (stream.Ok() && (key != cookedKey || size != cookedSize))
+			return false;
+	}
+	return stream.Ok();
+}
+
+//////////////////////////////////////////////// WRITER
+
+void CookedMeshWriter::AddChunk(uint32_t id, const void* pData, size_t size)
+{
+	CookedChunk chunk = {};
+	chunk.id = id;
+	chunk.offset = alignUp(mData.size());
+	chunk.size = size;
+	mChunks.push_back(chunk);
+
+	mData.resize((size_t)chunk.offset + size);
+	if (size != 0)
+		memcpy(&mData[(size_t)chunk.offset], pData, size);
+}
+
+void CookedMeshWriter::Serialize(uint64_t key, uint64_t sourceSize, std::vector<uint8_t>& bytes) const
+{
+	CookedMeshHeader header = {};
+	header.magic = COOKED_MESH_MAGIC;
+	header.version = COOKED_MESH_VERSION;
+	header.chunkCount = (uint32_t)mChunks.size();
+	header.key = key;
+	header.sourceSize = sourceSize;
+
+	// chunk offsets become file offsets once the table is in front of them
+	const size_t DataStart = alignUp(sizeof(CookedMeshHeader) + sizeof(CookedChunk) * mChunks.size());
+	bytes.assign(DataStart + mData.size(), 0);
+	memcpy(bytes.data(), &header, sizeof(header));
+	for (size_t i = 0; i < mChunks.size(); i++)
+	{
+		CookedChunk chunk = mChunks[i];
+		chunk.offset += DataStart;
+		memcpy(&bytes[sizeof(CookedMeshHeader) + i * sizeof(CookedChunk)], &chunk, sizeof(chunk));
+	}
+	if (!mData.empty())
+		memcpy(&bytes[DataStart], mData.data(), mData.size());
+}
+
+bool CookedMeshWriter::Write(const std::string& path, uint64_t key, uint64_t sourceSize) const
+{
+	std::vector<uint8_t> bytes;
+	Serialize(key, sourceSize, bytes);
+	return CookedMeshWriteFile(path, bytes);
+}
+
+bool CookedMeshWriteFile(const std::string& path, const std::vector<uint8_t>& bytes)
+{
+#ifdef _WIN32
+	_mkdir(COOKED_CACHE_DIRECTORY);
+#else
+	mkdir(COOKED_CACHE_DIRECTORY, 0755);
+#endif
+
+	std::string temporaryPath = path + ".tmp";
+	FILE* pFile = fopen(temporaryPath.c_str(), "wb");
+	if (!pFile)
+		return false;
+
+	bool ok = bytes.empty() || fwrite(bytes.data(), 1, bytes.size(), pFile) == bytes.size();
+	ok = fclose(pFile) == 0 && ok;
+
+	if (ok)
+	{
+		remove(path.c_str());
+		ok = rename(temporaryPath.c_str(), path.c_str()) == 0;
+	}
+	if (!ok)
+		remove(temporaryPath.c_str());
+	return ok;
+}
+
+//////////////////////////////////////////////// FILE
+
+CookedMeshFile::~CookedMeshFile()
+{
+	Close();
+}
+
+bool CookedMeshFile::Open(const std::string& path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	mFileHandle = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(CookedMeshHeader))
+	{
+		Close();
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		Close();
+		return false;
+	}
+	mMappingHandle = mapping;
+
+	mpData = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	mSize = (size_t)size.QuadPart;
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size < (off_t)sizeof(CookedMeshHeader))
+	{
+		close(file);
+		return false;
+	}
+
+	void* pMapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (pMapped == MAP_FAILED)
+		return false;
+
+	mpData = (const uint8_t*)pMapped;
+	mSize = (size_t)info.st_size;
+#endif
+
+	if (!mpData || !validate())
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool CookedMeshFile::Open(std::vector<uint8_t>& bytes)
+{
+	Close();
+
+	mOwned.swap(bytes);
+	mpData = mOwned.data();
+	mSize = mOwned.size();
+	if (mSize < sizeof(CookedMeshHeader) || !validate())
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool CookedMeshFile::validate()
+{
+	mpHeader = (const CookedMeshHeader*)mpData;
+	mpChunks = (const CookedChunk*)(mpData + sizeof(CookedMeshHeader));
+	bool valid = mpHeader->magic == COOKED_MESH_MAGIC && mpHeader->version == COOKED_MESH_VERSION &&
+				 sizeof(CookedMeshHeader) + (uint64_t)mpHeader->chunkCount * sizeof(CookedChunk) <= mSize;
+	for (uint32_t i = 0; valid && i < mpHeader->chunkCount; i++)
+	{
+		valid = mpChunks[i].offset <= mSize && mpChunks[i].size <= mSize - mpChunks[i].offset;
+	}
+	return valid;
+}
+
+void CookedMeshFile::Close()
+{
+	const bool Mapped = mpData && mOwned.empty();
+#ifdef _WIN32
+	if (Mapped)
+		UnmapViewOfFile(mpData);
+	if (mMappingHandle)
+		CloseHandle((HANDLE)mMappingHandle);
+	if (mFileHandle)
+		CloseHandle((HANDLE)mFileHandle);
+#else
+	if (Mapped)
+		munmap((void*)mpData, mSize);
+#endif
+	std::vector<uint8_t>().swap(mOwned);
+
+	mpData = nullptr;
+	mSize = 0;
+	mpHeader = nullptr;
+	mpChunks = nullptr;
+	mFileHandle = nullptr;
+	mMappingHandle = nullptr;
+}
+
+const void* CookedMeshFile::Chunk(uint32_t id, size_t* pSize) const
+{
+	if (!mpHeader)
+		return nullptr;
+
+	for (uint32_t i = 0; i < mpHeader->chunkCount; i++)
+	{
+		if (mpChunks[i].id == id)
+		{
+			if (pSize)
+				*pSize = (size_t)mpChunks[i].size;
+			return mpData + mpChunks[i].offset;
+		}
+	}
+	return nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Cooked meshes are what the loaders build out of an assimp scene, written once as a flat
+// blob of chunks and memory mapped on the next launch. Every chunk starts 16 byte aligned
+// so its pointer can go straight to glBufferData / a staging buffer without a copy.
+//
+//   CookedMeshHeader | CookedChunk x chunkCount | chunk data ...
+//
+// Cooked files live in COOKED_CACHE_DIRECTORY, named after a hash of the source file's bytes
+// seeded with everything else the result depends on (import flags, vertex layout, ...).
+// Editing the source or changing a setting gives a new name; the header repeats the key and
+// source size to catch collisions and foreign files. Other files the importer read (an OBJ's
+// .mtl) are only known after parsing, so their hashes are stored in the blob instead and
+// checked when it is opened. Textures are not part of a cooked mesh, only their paths are.
+#define COOKED_MESH_MAGIC	  0x4D584850 // "PHXM"
+#define COOKED_MESH_VERSION	  3
+#define COOKED_MESH_ALIGNMENT 16
+
+#ifndef COOKED_CACHE_DIRECTORY
+#define COOKED_CACHE_DIRECTORY "AssetCache"
+#endif
+
+#define COOKED_CHUNK_ID(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+struct CookedMeshHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t chunkCount;
+	uint32_t pad;
+	uint64_t key;
+	uint64_t sourceSize;
+};
+
+struct CookedChunk
+{
+	uint32_t id;
+	uint32_t pad;
+	uint64_t offset; // from the start of the file
+	uint64_t size;
+};
+
+// 64 bit hash, seed chains several inputs into one key
+uint64_t CookedMeshHash(const void* pData, size_t size, uint64_t seed = 0);
+
+inline uint64_t CookedMeshHash(const std::string& value, uint64_t seed = 0)
+{
+	return CookedMeshHash(value.data(), value.size(), seed);
+}
+
+// whole file, false when it can't be read
+bool CookedMeshReadSource(const std::string& path, std::vector<uint8_t>& bytes);
+
+// hash of a source file's bytes on top of seed, false when it can't be read
+bool CookedMeshHashSource(const std::string& path, uint64_t seed, uint64_t& key, uint64_t& size);
+
+// where the cooked result for a key lives
+std::string CookedMeshCachePath(uint64_t key, const char* extension);
+
+// one spelling per file for keying shared resources: '/' separators, no "." or "dir/.."
+// segments, lower case on Windows. Lexical only, the file doesn't have to exist
+std::string CookedMeshCanonicalPath(const std::string& path);
+
+// writes to a temporary file first so a crash never leaves a half written blob behind,
+// creates the cache directory when it is missing
+bool CookedMeshWriteFile(const std::string& path, const std::vector<uint8_t>& bytes);
+
+class CookedMeshWriter
+{
+public:
+	void AddChunk(uint32_t id, const void* pData, size_t size);
+
+	template <typename T>
+	void AddChunk(uint32_t id, const std::vector<T>& data)
+	{
+		AddChunk(id, data.data(), data.size() * sizeof(T));
+	}
+
+	// the whole file, header and chunk table included
+	void Serialize(uint64_t key, uint64_t sourceSize, std::vector<uint8_t>& bytes) const;
+
+	bool Write(const std::string& path, uint64_t key, uint64_t sourceSize) const;
+
+private:
+	std::vector<CookedChunk> mChunks; // offsets into mData until written
+	std::vector<uint8_t> mData;
+};
+
+// Read only mapping of a cooked mesh, chunk pointers stay valid until Close().
+class CookedMeshFile
+{
+public:
+	CookedMeshFile() {}
+	~CookedMeshFile();
+
+	CookedMeshFile(const CookedMeshFile&) = delete;
+	CookedMeshFile& operator=(const CookedMeshFile&) = delete;
+
+	// false when the file is missing, truncated or from another version
+	bool Open(const std::string& path);
+	// a freshly serialized one, takes the bytes over
+	bool Open(std::vector<uint8_t>& bytes);
+	void Close();
+
+	bool Matches(uint64_t key, uint64_t sourceSize) const
+	{
+		return mpHeader->key == key && mpHeader->sourceSize == sourceSize;
+	}
+
+	// null when the chunk is missing
+	const void* Chunk(uint32_t id, size_t* pSize = nullptr) const;
+
+	template <typename T>
+	const T* Chunk(uint32_t id, uint32_t& count) const
+	{
+		size_t size = 0;
+		const T* pData = (const T*)Chunk(id, &size);
+		count = (uint32_t)(size / sizeof(T));
+		return pData;
+	}
+
+private:
+	bool validate();
+
+	const uint8_t* mpData = nullptr;
+	size_t mSize = 0;
+	std::vector<uint8_t> mOwned; // Open(bytes), nothing is mapped then
+	const CookedMeshHeader* mpHeader = nullptr;
+	const CookedChunk* mpChunks = nullptr;
+
+	void* mFileHandle = nullptr;
+	void* mMappingHandle = nullptr;
+};
+
+// Builds the variable sized chunks (skeletons, clips) field by field.
+class CookedStreamWriter
+{
+public:
+	template <typename T>
+	void Write(const T& value)
+	{
+		const uint8_t* p = (const uint8_t*)&value;
+		mData.insert(mData.end(), p, p + sizeof(T));
+	}
+
+	template <typename T>
+	void Write(const std::vector<T>& values)
+	{
+		Write((uint32_t)values.size());
+		const uint8_t* p = (const uint8_t*)values.data();
+		mData.insert(mData.end(), p, p + values.size() * sizeof(T));
+	}
+
+	void Write(const std::string& value)
+	{
+		Write((uint32_t)value.size());
+		mData.insert(mData.end(), value.begin(), value.end());
+	}
+
+	const std::vector<uint8_t>& Data() const { return mData; }
+
+private:
+	std::vector<uint8_t> mData;
+};
+
+// Reads back what CookedStreamWriter wrote, every read is bounds checked and a failed read
+// leaves the reader failed so callers only check Ok() once at the end.
+class CookedStreamReader
+{
+public:
+	CookedStreamReader(const void* pData, size_t size) : mpData((const uint8_t*)pData), mSize(pData ? size : 0), mOffset(0), mOk(pData != nullptr) {}
+
+	template <typename T>
+	void Read(T& value)
+	{
+		if (canRead(sizeof(T)))
+		{
+			memcpy(&value, mpData + mOffset, sizeof(T));
+			mOffset += sizeof(T);
+		}
+	}
+
+	template <typename T>
+	void Read(std::vector<T>& values)
+	{
+		uint32_t count = 0;
+		Read(count);
+		if (canRead((size_t)count * sizeof(T)))
+		{
+			values.resize(count);
+			if (count)
+				memcpy(values.data(), mpData + mOffset, (size_t)count * sizeof(T));
+			mOffset += (size_t)count * sizeof(T);
+		}
+	}
+
+	void Read(std::string& value)
+	{
+		uint32_t length = 0;
+		Read(length);
+		if (canRead(length))
+		{
+			value.assign((const char*)mpData + mOffset, length);
+			mOffset += length;
+		}
+	}
+
+	bool Ok() const { return mOk; }
+	size_t Remaining() const { return mSize - mOffset; }
+
+private:
+	bool canRead(size_t size)
+	{
+		mOk = mOk && mOffset + size <= mSize;
+		return mOk;
+	}
+
+	const uint8_t* mpData;
+	size_t mSize;
+	size_t mOffset;
+	bool mOk;
+};
+
+// files besides the source that a cook read, path and hash of each
+#define COOKED_DEPENDENCIES COOKED_CHUNK_ID('D', 'E', 'P', 'S')
+
+void CookedMeshAddDependencies(CookedMeshWriter& writer, const std::vector<std::string>& paths);
+
+// false when a dependency changed or went missing, or the chunk isn't there
+bool CookedMeshDependenciesMatch(const CookedMeshFile& cooked);
\ No newline at end of file
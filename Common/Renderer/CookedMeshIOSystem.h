@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <assimp/DefaultIOSystem.h>
+
+#include "CookedMesh.h"
+
+// Default assimp file access that lists every file the importer opens besides the source,
+// e.g. an OBJ's .mtl, for CookedMeshAddDependencies. The importer owns and deletes the IO
+// system, so the list goes to a vector the caller keeps.
+class CookedMeshIOSystem : public Assimp::DefaultIOSystem
+{
+public:
+	CookedMeshIOSystem(const std::string& source, std::vector<std::string>* pDependencies)
+		: mSource(CookedMeshCanonicalPath(source)), mpDependencies(pDependencies)
+	{
+	}
+
+	Assimp::IOStream* Open(const char* pFile, const char* pMode = "rb") override
+	{
+		Assimp::IOStream* pStream = Assimp::DefaultIOSystem::Open(pFile, pMode);
+		if (!pStream)
+			return nullptr;
+
+		std::string path = CookedMeshCanonicalPath(pFile);
+		bool known = path == mSource;
+		for (size_t i = 0; i < mpDependencies->size() && !known; i++)
+		{
+			known = (*mpDependencies)[i] == path;
+		}
+		if (!known)
+			mpDependencies->push_back(path);
+		return pStream;
+	}
+
+private:
+	std::string mSource;
+	std::vector<std::string>* mpDependencies;
+};
\ No newline at end of file
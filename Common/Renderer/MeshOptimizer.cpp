@@ -0,0 +1,345 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+// FIFO vertex cache on timestamps: a vertex is still cached while fewer than cacheSize others
+// went in after it. Every cache starts with time = cacheSize + 1, adding that flushes it
+struct VertexCache
+{
+	std::vector<uint32_t> entered;
+	uint32_t time;
+	uint32_t size;
+
+	VertexCache(size_t vertexCount, uint32_t cacheSize) : entered(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+	bool Contains(uint32_t vertex) const
+	{
+		return time - entered[vertex] <= size;
+	}
+
+	// misses, 0 to 3
+	uint32_t Triangle(const uint32_t* pTriangle)
+	{
+		uint32_t misses = 0;
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			if (!Contains(pTriangle[k]))
+			{
+				entered[pTriangle[k]] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+	void Flush()
+	{
+		time += size + 1;
+	}
+};
+
+MeshCacheStats MeshAnalyzeVertexCache(const uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+	MeshCacheStats stats;
+	stats.triangles = (uint32_t)(indexCount / 3);
+
+	std::vector<bool> used(vertexCount, false);
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		assert(pIndices[i] < vertexCount);
+		if (!used[pIndices[i]])
+		{
+			used[pIndices[i]] = true;
+			stats.vertices++;
+		}
+	}
+
+	VertexCache cache(vertexCount, cacheSize);
+	for (size_t t = 0; t < stats.triangles; t++)
+	{
+		stats.transformed += cache.Triangle(&pIndices[t * 3]);
+	}
+	return stats;
+}
+
+//////////////////////////////////////////////// VERTEX CACHE
+
+// Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw".
+// Fans out of one vertex at a time, picking the next one among the vertices just emitted,
+// preferring those that will still be cached once their remaining triangles are emitted
+void MeshOptimizeVertexCache(uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+	const size_t TriangleCount = indexCount / 3;
+	if (TriangleCount == 0)
+		return;
+
+	// triangles using each vertex
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < TriangleCount * 3; i++)
+	{
+		assert(pIndices[i] < vertexCount);
+		offsets[pIndices[i] + 1]++;
+	}
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		offsets[v + 1] += offsets[v];
+	}
+
+	std::vector<uint32_t> adjacency(TriangleCount * 3);
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < TriangleCount * 3; i++)
+	{
+		adjacency[fill[pIndices[i]]++] = (uint32_t)(i / 3);
+	}
+
+	// triangles still to emit per vertex
+	std::vector<uint32_t> live(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		live[v] = offsets[v + 1] - offsets[v];
+	}
+
+	VertexCache cache(vertexCount, cacheSize);
+	std::vector<bool> emitted(TriangleCount, false);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	deadEnd.reserve(TriangleCount * 3);
+	result.reserve(TriangleCount * 3);
+
+	size_t cursor = 0;
+	int64_t fanning = 0;
+	while (fanning >= 0)
+	{
+		candidates.clear();
+		for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+		{
+			uint32_t t = adjacency[a];
+			if (emitted[t])
+				continue;
+			emitted[t] = true;
+
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t v = pIndices[t * 3 + k];
+				result.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+
+				if (!cache.Contains(v))
+					cache.entered[v] = cache.time++;
+			}
+		}
+
+		// the candidate that entered the cache earliest and still fits, otherwise any live one
+		int64_t next = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t v : candidates)
+		{
+			if (live[v] == 0)
+				continue;
+
+			int64_t age = (int64_t)cache.time - cache.entered[v];
+			int64_t priority = age + 2 * (int64_t)live[v] <= (int64_t)cacheSize ? age : 0;
+			if (priority > bestPriority)
+			{
+				next = v;
+				bestPriority = priority;
+			}
+		}
+
+		// dead end, back through what was recently emitted, then on in index order
+		while (next < 0 && !deadEnd.empty())
+		{
+			uint32_t v = deadEnd.back();
+			deadEnd.pop_back();
+			if (live[v] > 0)
+				next = v;
+		}
+		for (; next < 0 && cursor < vertexCount; cursor++)
+		{
+			if (live[cursor] > 0)
+				next = (int64_t)cursor;
+		}
+
+		fanning = next;
+	}
+
+	assert(result.size() == TriangleCount * 3);
+	memcpy(pIndices, result.data(), result.size() * sizeof(uint32_t));
+}
+
+//////////////////////////////////////////////// OVERDRAW
+
+struct Vector3
+{
+	float x, y, z;
+};
+
+static Vector3 position(const float* pPositions, size_t stride, uint32_t vertex)
+{
+	const float* p = (const float*)((const uint8_t*)pPositions + vertex * stride);
+	Vector3 result = { p[0], p[1], p[2] };
+	return result;
+}
+
+void MeshOptimizeOverdraw(uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t positionStride, size_t vertexCount, float threshold)
+{
+	const size_t TriangleCount = indexCount / 3;
+	if (TriangleCount < 2)
+		return;
+
+	// hard boundaries: all three vertices missed, so the cache order jumped to another patch
+	VertexCache cache(vertexCount, MESH_VERTEX_CACHE_SIZE);
+	std::vector<uint32_t> hard;
+	for (size_t t = 0; t < TriangleCount; t++)
+	{
+		if (cache.Triangle(&pIndices[t * 3]) == 3 || t == 0)
+			hard.push_back((uint32_t)t);
+	}
+
+	// soft boundaries: a patch is split again wherever the part before the split already is
+	// within threshold of the patch's own ACMR, restarting the cache there costs about that much
+	std::vector<uint32_t> clusters;
+	for (size_t h = 0; h < hard.size(); h++)
+	{
+		const uint32_t Start = hard[h];
+		const uint32_t End = h + 1 < hard.size() ? hard[h + 1] : (uint32_t)TriangleCount;
+
+		uint32_t misses = 0;
+		cache.Flush();
+		for (uint32_t t = Start; t < End; t++)
+		{
+			misses += cache.Triangle(&pIndices[t * 3]);
+		}
+		const float Target = threshold * misses / (End - Start);
+
+		clusters.push_back(Start);
+		uint32_t runningMisses = 0, runningTriangles = 0;
+		cache.Flush();
+		for (uint32_t t = Start; t < End; t++)
+		{
+			runningMisses += cache.Triangle(&pIndices[t * 3]);
+			runningTriangles++;
+
+			if (t + 1 < End && (float)runningMisses / runningTriangles <= Target)
+			{
+				clusters.push_back(t + 1);
+				runningMisses = runningTriangles = 0;
+				cache.Flush();
+			}
+		}
+
+		// a tail left far above the target goes back into the cluster before it
+		if (runningTriangles > 0 && clusters.back() != Start && (float)runningMisses / runningTriangles > Target)
+			clusters.pop_back();
+	}
+
+	// draw first what faces away from the middle of the mesh, it is most likely to hide the rest
+	Vector3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+	for (size_t i = 0; i < TriangleCount * 3; i++)
+	{
+		Vector3 p = position(pPositions, positionStride, pIndices[i]);
+		meshCentroid.x += p.x;
+		meshCentroid.y += p.y;
+		meshCentroid.z += p.z;
+	}
+	meshCentroid.x /= TriangleCount * 3;
+	meshCentroid.y /= TriangleCount * 3;
+	meshCentroid.z /= TriangleCount * 3;
+
+	std::vector<float> keys(clusters.size());
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		const uint32_t End = c + 1 < clusters.size() ? clusters[c + 1] : (uint32_t)TriangleCount;
+
+		// area weighted centroid, the summed cross products point along the area weighted normal
+		Vector3 centroid = { 0.0f, 0.0f, 0.0f };
+		Vector3 normal = { 0.0f, 0.0f, 0.0f };
+		float area = 0.0f;
+		for (uint32_t t = clusters[c]; t < End; t++)
+		{
+			Vector3 a = position(pPositions, positionStride, pIndices[t * 3 + 0]);
+			Vector3 b = position(pPositions, positionStride, pIndices[t * 3 + 1]);
+			Vector3 d = position(pPositions, positionStride, pIndices[t * 3 + 2]);
+
+			Vector3 e1 = { b.x - a.x, b.y - a.y, b.z - a.z };
+			Vector3 e2 = { d.x - a.x, d.y - a.y, d.z - a.z };
+			Vector3 cross = { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+			float weight = sqrtf(cross.x * cross.x + cross.y * cross.y + cross.z * cross.z);
+
+			centroid.x += (a.x + b.x + d.x) * weight;
+			centroid.y += (a.y + b.y + d.y) * weight;
+			centroid.z += (a.z + b.z + d.z) * weight;
+			normal.x += cross.x;
+			normal.y += cross.y;
+			normal.z += cross.z;
+			area += weight;
+		}
+
+		float length = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+		if (area <= 0.0f || length <= 0.0f)
+		{
+			keys[c] = 0.0f;
+			continue;
+		}
+
+		float scale = 1.0f / (3.0f * area);
+		keys[c] = ((centroid.x * scale - meshCentroid.x) * normal.x + (centroid.y * scale - meshCentroid.y) * normal.y +
+				   (centroid.z * scale - meshCentroid.z) * normal.z) / length;
+	}
+
+	std::vector<uint32_t> order(clusters.size());
+	for (size_t c = 0; c < order.size(); c++)
+	{
+		order[c] = (uint32_t)c;
+	}
+	std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(TriangleCount * 3);
+	for (uint32_t c : order)
+	{
+		const uint32_t End = c + 1 < clusters.size() ? clusters[c + 1] : (uint32_t)TriangleCount;
+		result.insert(result.end(), pIndices + clusters[c] * 3, pIndices + End * 3);
+	}
+	memcpy(pIndices, result.data(), result.size() * sizeof(uint32_t));
+}
+
+//////////////////////////////////////////////// VERTEX FETCH
+
+void MeshOptimizeVertexFetch(uint32_t* pIndices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& remap)
+{
+	const uint32_t Unused = 0xFFFFFFFF;
+	remap.assign(vertexCount, Unused);
+
+	uint32_t next = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		uint32_t& v = pIndices[i];
+		assert(v < vertexCount);
+		if (remap[v] == Unused)
+			remap[v] = next++;
+		v = remap[v];
+	}
+
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] == Unused)
+			remap[v] = next++;
+	}
+}
+
+void MeshRemapVertices(void* pVertices, size_t stride, size_t vertexCount, const uint32_t* pRemap)
+{
+	uint8_t* pDst = (uint8_t*)pVertices;
+	std::vector<uint8_t> source(pDst, pDst + stride * vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		memcpy(pDst + pRemap[v] * stride, &source[v * stride], stride);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Reorders indexed triangle lists for the GPU while a mesh is cooked, so the result is in the
+// asset cache and loading pays nothing for it. Run per draw, in this order:
+//
+//   MeshOptimizeVertexCache  triangles in post transform cache order (Tipsify)
+//   MeshOptimizeOverdraw     the clusters of that order sorted outside in, so front faces tend to
+//                            be drawn before what they hide, for a bounded ACMR increase
+//   MeshOptimizeVertexFetch  vertices renumbered in first use order, MeshRemapVertices then
+//                            moves every vertex stream to match
+//
+// Indices are relative to the draw's own vertices, [0, vertexCount).
+#define MESH_OPTIMIZER_VERSION	1 // part of the asset cache keys, bump when the output changes
+#define MESH_VERTEX_CACHE_SIZE	16
+#define MESH_OVERDRAW_THRESHOLD 1.05f
+
+// FIFO cache simulation of a triangle list, sums over several draws with Add
+struct MeshCacheStats
+{
+	uint32_t triangles = 0;
+	uint32_t vertices = 0;	  // referenced by the indices
+	uint32_t transformed = 0; // cache misses, one vertex shader invocation each
+
+	// average cache miss ratio, invocations per triangle: 3 is no reuse at all, ~0.5 a regular grid
+	float Acmr() const
+	{
+		return triangles ? (float)transformed / triangles : 0.0f;
+	}
+
+	// average transform to vertex ratio, invocations per vertex: 1 is ideal
+	float Atvr() const
+	{
+		return vertices ? (float)transformed / vertices : 0.0f;
+	}
+
+	void Add(const MeshCacheStats& other)
+	{
+		triangles += other.triangles;
+		vertices += other.vertices;
+		transformed += other.transformed;
+	}
+};
+
+MeshCacheStats MeshAnalyzeVertexCache(const uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = MESH_VERTEX_CACHE_SIZE);
+
+void MeshOptimizeVertexCache(uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = MESH_VERTEX_CACHE_SIZE);
+
+// pPositions points at the x of vertex 0, y and z follow it. threshold is how much worse than
+// the cache optimized order a cluster's ACMR may get so it can be split into smaller clusters
+void MeshOptimizeOverdraw(uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t positionStride, size_t vertexCount,
+						  float threshold = MESH_OVERDRAW_THRESHOLD);
+
+// remap[old] = new, vertices no index uses go last so the count doesn't change
+void MeshOptimizeVertexFetch(uint32_t* pIndices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& remap);
+
+void MeshRemapVertices(void* pVertices, size_t stride, size_t vertexCount, const uint32_t* pRemap);
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "VulkanRenderer.h"
+#include "CookedMesh.h"
+#include "CookedMeshIOSystem.h"
+#include "MeshOptimizer.h"
 
 #include <stdexcept>
 #include <functional>
@@ -684,9 +687,126 @@ void VulkanRenderer::PH_DestroyShaderModule(VkShaderModule* shaderModule)
 	vkDestroyShaderModule(device, *shaderModule, nullptr);
 }
 
+// chunks of a cooked PH_Model, see CookedMesh.h
+#define COOKED_VERTICES	 COOKED_CHUNK_ID('V', 'E', 'R', 'T')
+#define COOKED_INDICES	 COOKED_CHUNK_ID('I', 'D', 'X', ' ')
+#define COOKED_PARTS	 COOKED_CHUNK_ID('P', 'A', 'R', 'T')
+#define COOKED_DIMENSION COOKED_CHUNK_ID('D', 'I', 'M', ' ')
+
+// the vertices depend on the layout and the import flags as much as on the source
+static uint64_t cookedModelSeed(const VertexLayout& layout)
+{
+	const int settings[] = { PH_Model::defaultFlags, MESH_OPTIMIZER_VERSION };
+	uint64_t seed = CookedMeshHash(settings, sizeof(settings));
+	return CookedMeshHash(layout.components.data(), layout.components.size() * sizeof(Vertex_Component), seed);
+}
+
+bool VulkanRenderer::loadCookedModel(const CookedMeshFile& cooked, uint32_t stride, PH_Model* ph_model)
+{
+	uint32_t floatCount = 0, indexCount = 0, partCount = 0, dimCount = 0;
+	const float* pVertices = cooked.Chunk<float>(COOKED_VERTICES, floatCount);
+	const uint32_t* pIndices = cooked.Chunk<uint32_t>(COOKED_INDICES, indexCount);
+	const PH_Model::ModelPart* pParts = cooked.Chunk<PH_Model::ModelPart>(COOKED_PARTS, partCount);
+	const PH_Model::Dimension* pDim = cooked.Chunk<PH_Model::Dimension>(COOKED_DIMENSION, dimCount);
+
+	if (!pVertices || !pIndices || !pParts || dimCount != 1 || floatCount == 0 || indexCount == 0 || (floatCount * sizeof(float)) % stride != 0)
+		return false;
+
+	// the whole model is one draw, every index has to land in the vertex buffer and every
+	// part's indices in its own vertices
+	const uint32_t vertexCount = (uint32_t)(floatCount * sizeof(float) / stride);
+	for (uint32_t i = 0; i < indexCount; i++)
+	{
+		if (pIndices[i] >= vertexCount)
+			return false;
+	}
+	for (uint32_t i = 0; i < partCount; i++)
+	{
+		const PH_Model::ModelPart& part = pParts[i];
+		if ((uint64_t)part.vertexBase + part.vertexCount > vertexCount || (uint64_t)part.indexBase + part.indexCount > indexCount)
+			return false;
+		for (uint32_t j = part.indexBase; j < part.indexBase + part.indexCount; j++)
+		{
+			if (pIndices[j] < part.vertexBase || pIndices[j] - part.vertexBase >= part.vertexCount)
+				return false;
+		}
+	}
+
+	ph_model->parts.assign(pParts, pParts + partCount);
+	ph_model->dim = *pDim;
+	ph_model->vertexCount = vertexCount;
+	ph_model->indexCount = indexCount;
+
+	// straight from the mapping into the staging buffers
+	createModelBuffers(pVertices, floatCount * sizeof(float), pIndices, indexCount * sizeof(uint32_t), ph_model);
+	return true;
+}
+
+void VulkanRenderer::createModelBuffers(const void* pVertices, VkDeviceSize vertexSize, const void* pIndices, VkDeviceSize indexSize, PH_Model* ph_model)
+{
+	// VERTEX BUFFER
+	{
+		PH_BufferCreateInfo vBufferInfo;
+		vBufferInfo.bufferSize = vertexSize;
+		vBufferInfo.bufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		vBufferInfo.memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		vBufferInfo.data = const_cast<void*>(pVertices);
+		PH_CreateBuffer(vBufferInfo, &(ph_model->vertices));
+	}
+
+	// INDEX BUFFER
+	{
+		PH_BufferCreateInfo iBufferInfo;
+		iBufferInfo.bufferSize = indexSize;
+		iBufferInfo.bufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		iBufferInfo.memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		iBufferInfo.data = const_cast<void*>(pIndices);
+		PH_CreateBuffer(iBufferInfo, &(ph_model->indices));
+	}
+}
+
+// cache, overdraw then fetch order, see MeshOptimizer.h. The part's indices are relative to its
+// first vertex and are still the last ones in indices
+static void optimizeModelPart(VertexLayout& layout, const PH_Model::ModelPart& part, std::vector<float>& vertices, std::vector<uint32_t>& indices)
+{
+	if (part.indexCount == 0)
+		return;
+
+	const uint32_t Stride = layout.stride();
+	uint8_t* pVertices = (uint8_t*)vertices.data() + (size_t)part.vertexBase * Stride;
+	uint32_t* pIndices = indices.data() + indices.size() - part.indexCount;
+	MeshOptimizeVertexCache(pIndices, part.indexCount, part.vertexCount);
+
+	// the position's offset is the stride of the components in front of it
+	std::vector<Vertex_Component>::iterator position = std::find(layout.components.begin(), layout.components.end(), VERTEX_COMPONENT_POSITION);
+	if (position != layout.components.end())
+	{
+		VertexLayout front(std::vector<Vertex_Component>(layout.components.begin(), position));
+		MeshOptimizeOverdraw(pIndices, part.indexCount, (const float*)(pVertices + front.stride()), Stride, part.vertexCount);
+	}
+
+	std::vector<uint32_t> remap;
+	MeshOptimizeVertexFetch(pIndices, part.indexCount, part.vertexCount, remap);
+	MeshRemapVertices(pVertices, Stride, part.vertexCount, remap.data());
+}
+
 void VulkanRenderer::PH_LoadModel(const std::string& filename, VertexLayout layout, PH_Model *ph_model)
 {
+	// keyed on the source bytes, import flags and layout, an edited source simply misses
+	uint64_t key = 0, sourceSize = 0;
+	const bool hasSource = mUseCookedModels && CookedMeshHashSource(filename, cookedModelSeed(layout), key, sourceSize);
+	const std::string cookedPath = CookedMeshCachePath(key, "vkmesh");
+	if (hasSource)
+	{
+		CookedMeshFile cooked;
+		if (cooked.Open(cookedPath) && cooked.Matches(key, sourceSize) && CookedMeshDependenciesMatch(cooked) &&
+			loadCookedModel(cooked, layout.stride(), ph_model))
+			return;
+	}
+
+	std::vector<std::string> dependencies;
 	Assimp::Importer Importer;
+	Importer.SetIOHandler(new CookedMeshIOSystem(filename, &dependencies));
 	const aiScene* pScene;
 
 	pScene = Importer.ReadFile(filename.c_str(), PH_Model::defaultFlags);
@@ -792,42 +912,45 @@ void VulkanRenderer::PH_LoadModel(const std::string& filename, VertexLayout layo
 
 			ph_model->parts[i].vertexCount = paiMesh->mNumVertices;
 
+			// part relative until the part is optimized
 			uint32_t indexBase = static_cast<uint32_t>(indexBuffer.size());
 			for (unsigned int j = 0; j < paiMesh->mNumFaces; j++)
 			{
 				const aiFace& Face = paiMesh->mFaces[j];
 				if (Face.mNumIndices != 3)
 					continue;
-				indexBuffer.push_back(indexBase + Face.mIndices[0]);
-				indexBuffer.push_back(indexBase + Face.mIndices[1]);
-				indexBuffer.push_back(indexBase + Face.mIndices[2]);
+				indexBuffer.push_back(Face.mIndices[0]);
+				indexBuffer.push_back(Face.mIndices[1]);
+				indexBuffer.push_back(Face.mIndices[2]);
 				ph_model->parts[i].indexCount += 3;
 				ph_model->indexCount += 3;
 			}
+
+			optimizeModelPart(layout, ph_model->parts[i], vertexBuffer, indexBuffer);
+
+			// the whole model is one draw, so the indices point into the whole vertex buffer
+			for (uint32_t j = indexBase; j < indexBuffer.size(); j++)
+			{
+				indexBuffer[j] += ph_model->parts[i].vertexBase;
+			}
 		}
 
 
 		uint32_t vBufferSize = static_cast<uint32_t>(vertexBuffer.size()) * sizeof(float);
 		uint32_t iBufferSize = static_cast<uint32_t>(indexBuffer.size()) * sizeof(uint32_t);
 
-		// VERTEX BUFFER
-		{
-			PH_BufferCreateInfo vBufferInfo;
-			vBufferInfo.bufferSize = vBufferSize;
-			vBufferInfo.bufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-			vBufferInfo.memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-			vBufferInfo.data = vertexBuffer.data();
-			PH_CreateBuffer(vBufferInfo, &(ph_model->vertices));
-		}
+		createModelBuffers(vertexBuffer.data(), vBufferSize, indexBuffer.data(), iBufferSize, ph_model);
 
-		// INDEX BUFFER
+		if (hasSource)
 		{
-			PH_BufferCreateInfo iBufferInfo;
-			iBufferInfo.bufferSize = iBufferSize;
-			iBufferInfo.bufferUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-			iBufferInfo.memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-			iBufferInfo.data = indexBuffer.data();
-			PH_CreateBuffer(iBufferInfo, &(ph_model->indices));
+			CookedMeshWriter writer;
+			writer.AddChunk(COOKED_VERTICES, vertexBuffer);
+			writer.AddChunk(COOKED_INDICES, indexBuffer);
+			writer.AddChunk(COOKED_PARTS, ph_model->parts);
+			writer.AddChunk(COOKED_DIMENSION, &ph_model->dim, sizeof(ph_model->dim));
+			CookedMeshAddDependencies(writer, dependencies);
+			if (!writer.Write(cookedPath, key, sourceSize))
+				std::cerr << "Error writing " << cookedPath << std::endl;
 		}
 	}
 	else
@@ -1529,6 +1652,17 @@ void VulkanRenderer::PH_CreateTexture(PH_ImageCreateInfo info, PH_Image* ph_imag
 	}
 	else
 	{
+		// everything that makes two images of one file differ
+		std::string key = CookedMeshCanonicalPath(ph_image->path) + "|" + std::to_string(info.format) + "|" + std::to_string(info.tiling) + "|" +
+						  std::to_string(info.usageFlags) + "|" + std::to_string(info.memoryProperty) + "|" + std::to_string(info.aspectBits);
+		std::unordered_map<std::string, SharedImage>::iterator shared = mSharedImages.find(key);
+		if (shared != mSharedImages.end())
+		{
+			shared->second.refs++;
+			*ph_image = shared->second.image;
+			return;
+		}
+
 		stbi_uc* pixels = stbi_load(ph_image->path.c_str(), &ph_image->width, &ph_image->height, &ph_image->nChannels, STBI_rgb_alpha);
 		
 		VkDeviceSize imageSize = (uint64_t)(ph_image->width * ph_image->height * 4);
@@ -1579,11 +1713,25 @@ void VulkanRenderer::PH_CreateTexture(PH_ImageCreateInfo info, PH_Image* ph_imag
 		vkFreeMemory(device, stagingBufferMemory, nullptr);
 
 		ph_image->imageView = createImageView(ph_image->image, ph_image->format, info.aspectBits);
+
+		SharedImage sharedImage = { *ph_image, 1 };
+		mSharedImages.emplace(key, sharedImage);
+		mSharedImageKeys.emplace(ph_image->image, key);
 	}
 }
 
 void VulkanRenderer::PH_DeleteTexture(PH_Image* ph_image)
 {
+	std::unordered_map<VkImage, std::string>::iterator key = mSharedImageKeys.find(ph_image->image);
+	if (key != mSharedImageKeys.end())
+	{
+		if (--mSharedImages[key->second].refs != 0)
+			return;
+
+		mSharedImages.erase(key->second);
+		mSharedImageKeys.erase(key);
+	}
+
 	vkDestroyImageView(device, ph_image->imageView, nullptr);
 	vkDestroyImage(device, ph_image->image, nullptr);
 	vkFreeMemory(device, ph_image->imageMemory, nullptr);
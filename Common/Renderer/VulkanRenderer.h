@@ -14,10 +14,13 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
 
 #include "Window.h"
 #include "Camera.hpp"
 
+class CookedMeshFile;
+
 struct Settings
 {
 	int windowWidth = 0;
@@ -162,6 +165,8 @@ public:
 	void waitDeviceIdle();
 	
 	// TEXTURES
+	// images loaded from a file are shared: the same canonical path and create settings give
+	// the same image, destroyed with its last PH_DeleteTexture
 	void PH_CreateTexture(PH_ImageCreateInfo info, PH_Image* ph_image);
 	void PH_DeleteTexture(PH_Image* ph_image);
 
@@ -181,6 +186,9 @@ public:
 	// MODELS
 	void PH_LoadModel(const std::string& filename, VertexLayout layout, PH_Model* ph_model);
 	void PH_DeleteModel(PH_Model* ph_model);
+
+	// load models from / write them to the asset cache, see CookedMesh.h
+	bool mUseCookedModels = true;
 	
 	// DescriptorSet Layout
 	void PH_CreateDescriptorSetLayout(VkDescriptorSetLayoutCreateInfo layoutInfo, VkDescriptorSetLayout* descriptorSetLayout);
@@ -258,6 +266,9 @@ private:
 	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 	void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
 
+	void createModelBuffers(const void* pVertices, VkDeviceSize vertexSize, const void* pIndices, VkDeviceSize indexSize, PH_Model* ph_model);
+	bool loadCookedModel(const CookedMeshFile& cooked, uint32_t stride, PH_Model* ph_model);
+
 	void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
 		VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
 	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
@@ -297,4 +308,12 @@ private:
 
 	// current swapchain image index
 	uint32_t imageIndex;
+
+	struct SharedImage
+	{
+		PH_Image image;
+		uint32_t refs;
+	};
+	std::unordered_map<std::string, SharedImage> mSharedImages;
+	std::unordered_map<VkImage, std::string> mSharedImageKeys; // back to the key, for PH_DeleteTexture
 };
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "Component.h"
+
+#include <atomic>
+
+AllocatorStats& representationAllocatorStats()
+{
+	static AllocatorStats stats;
+	return stats;
+}
+
+static std::atomic<uint32> sComponentTypeCount(0);
+
+uint32 nextComponentTypeID()
+{
+	return sComponentTypeCount.fetch_add(1);
+}
+
+uint32 componentTypeCount()
+{
+	return sComponentTypeCount.load();
+}
@@ -1,10 +1,12 @@
 #pragma once
 
-#include <TINYSTL/hash.h>
 #include <TINYSTL/string.h>
 #include <TINYSTL/vector.h>
 #include <TINYSTL/unordered_map.h>
 
+#include "Reflection.h"
+#include "../Memory/PoolAllocator.h"
+
 typedef unsigned int uint32;
 
 class ComponentRepresentation
@@ -27,23 +29,33 @@ public:
 	virtual void destroyRepresentation(ComponentRepresentation* pRep) = 0;
 };
 
-// Unique ID
-static uint32 m_VarIdCounter = 0;
-static const uint32 generateUniqueID()
+// shared by the representation pools of every component type
+AllocatorStats& representationAllocatorStats();
+
+// Dense component type IDs (0, 1, 2, ...) handed out on first use of each type,
+// the EntityManager indexes its pool array with them.
+// Function local statics so no ID depends on static initialization order.
+uint32 nextComponentTypeID();
+uint32 componentTypeCount();
+
+template <typename T>
+struct ComponentTypeID
 {
-	return m_VarIdCounter++;
-}
+	static uint32 value()
+	{
+		static const uint32 id = nextComponentTypeID();
+		return id;
+	}
+};
 
 #define DECLARE_COMPONENT(Component_) \
 class Component_ : public Component { \
 	public: \
 		virtual Component_* clone() const override; \
 		virtual uint32 getType() const override; \
-		static  uint32 getTypeStatic(); \
+		static  uint32 getTypeStatic() { return ComponentTypeID<Component_>::value(); } \
 		virtual ComponentRepresentation* createRepresentation() override; \
 		virtual void destroyRepresentation(ComponentRepresentation* pRep) override; \
-\
-		static uint32 Component_##typeHash; \
 	private:
 
 
@@ -53,11 +65,19 @@ class Component_ : public Component { \
 #define DEFINE_COMPONENT(Component_) \
 	Component_* Component_::clone() const { return new Component_; } \
 	uint32 Component_::getType() const { return Component_::getTypeStatic(); } \
-	uint32 Component_::getTypeStatic() {  return Component_##typeHash; } \
-	ComponentRepresentation* Component_::createRepresentation() { return new Component_##Representation; } \
-	void Component_::destroyRepresentation(ComponentRepresentation* pRep) { pRep->~ComponentRepresentation(); delete pRep; } \
-\
-	uint32 Component_::Component_##typeHash = (uint32)(tinystl::hash(#Component_));
+	static PoolAllocator<Component_##Representation>& Component_##RepresentationPool() \
+	{ \
+		static PoolAllocator<Component_##Representation> pool(&representationAllocatorStats()); \
+		return pool; \
+	} \
+	ComponentRepresentation* Component_::createRepresentation() { return new(Component_##RepresentationPool().allocate()) Component_##Representation; } \
+	void Component_::destroyRepresentation(ComponentRepresentation* pRep) \
+	{ \
+		if (!pRep) return; \
+		Component_##Representation* pTypedRep = static_cast<Component_##Representation*>(pRep); \
+		pTypedRep->~Component_##Representation(); \
+		Component_##RepresentationPool().deallocate(pTypedRep); \
+	}
 
 
 #define REGISTER_COMPONENT_CLASS(Component_) \
@@ -70,27 +90,41 @@ public:\
 		 \
 	} \
 	\
-	virtual uint32 getComponentID() const override { return ComponentID; }\
+	virtual uint32 getComponentID() const override { return Component_::getTypeStatic(); }\
 	virtual const char* getComponentName() const override { return #Component_; }\
-	static const uint32 storeIDandName(tinystl::string var_name, const uint32 id)\
+	static const uint32 storeIDandName(tinystl::string var_name, const uint32 id, FieldInfo field)\
 	{\
-		Component_##varNames.emplace({var_name, id}); \
+		Component_##varNames().emplace({var_name, id}); \
+		field.id = id; \
+		typeInfo().fields.push_back(field); \
 		return id; \
 	}\
-	tinystl::unordered_map<tinystl::string, uint32> getVarNames() { return Component_##Representation::Component_##varNames; } \
+	static ComponentTypeInfo& typeInfo(); \
+	tinystl::unordered_map<tinystl::string, uint32> getVarNames() { return Component_##Representation::Component_##varNames(); } \
 	\
-	static const uint32 ComponentID; \
 	static uint32 Component_VarCounter; \
-	static tinystl::unordered_map<tinystl::string, uint32> Component_##varNames;
+	static tinystl::unordered_map<tinystl::string, uint32>& Component_##varNames() \
+	{ \
+		static tinystl::unordered_map<tinystl::string, uint32> varNames; \
+		return varNames; \
+	}
 
 
 #define START_REGISTRATION(Component_) \
 	uint32 Component_##Representation::Component_VarCounter = 0; \
-	const uint32 Component_##Representation::ComponentID = generateUniqueID(); \
-	tinystl::unordered_map<tinystl::string, uint32> Component_##Representation::Component_##varNames;
+	ComponentTypeInfo& Component_##Representation::typeInfo() \
+	{ \
+		static ComponentTypeInfo info = makeComponentTypeInfo<Component_>(#Component_); \
+		return info; \
+	} \
+	static const bool Component_##Registered = registerComponentType(&Component_##Representation::typeInfo());
 
 #define REGISTER_VARIABLE(x) \
 static const uint32 x;
 
 #define DEFINE_VARIABLE(Component_, x) \
-const uint32 Component_##Representation::x = Component_##Representation::storeIDandName(#x, Component_VarCounter++);
\ No newline at end of file
+const uint32 Component_##Representation::x = Component_##Representation::storeIDandName(#x, Component_VarCounter++, \
+	makeFieldInfo<Component_, decltype(Component_::x), &Component_::x>(#x));
+
+// createComponentPool<T> needs the complete pool when a registration is instantiated
+#include "ComponentPool.h"
\ No newline at end of file
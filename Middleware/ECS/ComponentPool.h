@@ -0,0 +1,185 @@
+#pragma once
+
+#include "Component.h"
+#include "EntityID.h"
+#include "../Memory/Memory.h"
+
+#include <atomic>
+#include <new>
+#include <utility>
+
+// Components of one type are stored packed in a single cache line aligned array.
+#define COMPONENT_POOL_ALIGNMENT 64
+#define INVALID_DENSE_INDEX		 0xFFFFFFFF
+
+// Sparse set: mSparse maps an entity index to its slot in the packed arrays,
+// mEntities maps a packed slot back to the full ID (index and generation) that owns it.
+// Every slot also remembers the change tick it was added at and last marked changed at,
+// see EntityManager::changeTick().
+class ComponentPoolBase
+{
+public:
+	ComponentPoolBase(AllocatorStats* pStats, const std::atomic<uint32>* pChangeTick) : mpStats(pStats), mpChangeTick(pChangeTick) {}
+	virtual ~ComponentPoolBase() {}
+	virtual void remove(EntityID id) = 0;
+	virtual Component* getComponentBase(EntityID id) = 0;
+
+	// untyped access for reflection driven code (snapshots), elements are elementSize() apart
+	virtual void* addUntyped(EntityID id) = 0;
+	virtual void reserve(uint32 capacity) = 0;
+	virtual void* data() = 0;
+	virtual uint32 elementSize() const = 0;
+
+	bool has(EntityID id) const
+	{
+		uint32 index = entityIndex(id);
+		return index < mSparse.size() && mSparse[index] != INVALID_DENSE_INDEX && mEntities[mSparse[index]] == id;
+	}
+
+	uint32 size() const { return (uint32)mEntities.size(); }
+	const EntityID* entities() const { return mEntities.data(); }
+
+	// packed slot of id, INVALID_DENSE_INDEX if it has no component here
+	uint32 indexOf(EntityID id) const
+	{
+		return has(id) ? mSparse[entityIndex(id)] : INVALID_DENSE_INDEX;
+	}
+
+	uint32 addedTick(uint32 index) const   { return mAddedTicks[index]; }
+	uint32 changedTick(uint32 index) const { return mChangedTicks[index]; }
+
+	// stamps the component with the current change tick
+	void markChanged(EntityID id)
+	{
+		if (has(id))
+			mChangedTicks[mSparse[entityIndex(id)]] = mpChangeTick->load(std::memory_order_relaxed);
+	}
+
+	void markChangedAt(uint32 index)
+	{
+		mChangedTicks[index] = mpChangeTick->load(std::memory_order_relaxed);
+	}
+
+protected:
+	tinystl::vector<uint32>   mSparse;
+	tinystl::vector<EntityID> mEntities;
+	tinystl::vector<uint32>   mAddedTicks;
+	tinystl::vector<uint32>   mChangedTicks;
+	AllocatorStats*			  mpStats;
+	const std::atomic<uint32>* mpChangeTick;
+};
+
+template <typename T>
+class ComponentPool : public ComponentPoolBase
+{
+public:
+	// every pool of a manager reports into the same stats
+	ComponentPool(AllocatorStats* pStats, const std::atomic<uint32>* pChangeTick) : ComponentPoolBase(pStats, pChangeTick), mData(nullptr), mCapacity(0) {}
+
+	~ComponentPool()
+	{
+		for (uint32 i = 0; i < size(); ++i)
+		{
+			mData[i].~T();
+		}
+		alignedFree(mData);
+		mpStats->onFree(sizeof(T) * size());
+		mpStats->bytesReserved -= sizeof(T) * mCapacity;
+	}
+
+	T* add(EntityID id)
+	{
+		if (has(id))
+			return &mData[mSparse[entityIndex(id)]];
+
+		uint32 sparseIndex = entityIndex(id);
+		if (sparseIndex >= mSparse.size())
+			mSparse.resize(sparseIndex + 1, INVALID_DENSE_INDEX);
+
+		uint32 index = size();
+		if (index == mCapacity)
+			grow(mCapacity ? mCapacity * 2 : 64);
+
+		T* pComponent = new(&mData[index]) T;
+		mSparse[sparseIndex] = index;
+		mEntities.push_back(id);
+		uint32 tick = mpChangeTick->load(std::memory_order_relaxed);
+		mAddedTicks.push_back(tick);
+		mChangedTicks.push_back(tick);
+		mpStats->onAllocate(sizeof(T));
+		return pComponent;
+	}
+
+	// swaps the last component into the freed slot so the array stays packed
+	virtual void remove(EntityID id) override
+	{
+		if (!has(id))
+			return;
+
+		uint32 sparseIndex = entityIndex(id);
+		uint32 index = mSparse[sparseIndex];
+		uint32 last = size() - 1;
+		if (index != last)
+		{
+			mData[index] = std::move(mData[last]);
+			mEntities[index] = mEntities[last];
+			mAddedTicks[index] = mAddedTicks[last];
+			// moving counts as a change, anything mirroring the packed order has to rewrite this slot
+			mChangedTicks[index] = mpChangeTick->load(std::memory_order_relaxed);
+			mSparse[entityIndex(mEntities[index])] = index;
+		}
+		mData[last].~T();
+		mEntities.pop_back();
+		mAddedTicks.pop_back();
+		mChangedTicks.pop_back();
+		mSparse[sparseIndex] = INVALID_DENSE_INDEX;
+		mpStats->onFree(sizeof(T));
+	}
+
+	T* get(EntityID id)
+	{
+		return has(id) ? &mData[mSparse[entityIndex(id)]] : nullptr;
+	}
+
+	virtual Component* getComponentBase(EntityID id) override
+	{
+		return get(id);
+	}
+
+	virtual void* addUntyped(EntityID id) override
+	{
+		return add(id);
+	}
+
+	virtual void reserve(uint32 capacity) override
+	{
+		if (capacity > mCapacity)
+			grow(capacity);
+	}
+
+	virtual void* data() override { return mData; }
+	virtual uint32 elementSize() const override { return sizeof(T); }
+
+	T& operator[](uint32 index) { return mData[index]; }
+
+	T* begin() { return mData; }
+	T* end()   { return mData + size(); }
+
+private:
+	void grow(uint32 capacity)
+	{
+		T* pData = (T*)alignedAlloc(sizeof(T) * capacity, COMPONENT_POOL_ALIGNMENT);
+		for (uint32 i = 0; i < size(); ++i)
+		{
+			new(&pData[i]) T(std::move(mData[i]));
+			mData[i].~T();
+		}
+		alignedFree(mData);
+		mData = pData;
+		mpStats->bytesReserved += sizeof(T) * (capacity - mCapacity);
+		mCapacity = capacity;
+	}
+
+	T*	   mData;
+	uint32 mCapacity;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+typedef unsigned int uint32;
+
+// An EntityID packs the slot index of the entity with the generation of that slot.
+// Destroying an entity bumps the generation, so stale IDs of recycled slots fail lookup.
+// Generations never wrap, a slot is retired once it used the last one.
+typedef uint32 EntityID;
+
+#define ENTITY_INDEX_BITS		20
+#define ENTITY_INDEX_MASK		((1u << ENTITY_INDEX_BITS) - 1)
+#define ENTITY_GENERATION_MASK	((1u << (32 - ENTITY_INDEX_BITS)) - 1)
+
+// slot 0 is never handed out, so 0 is never a valid ID
+#define INVALID_ENTITY_ID		0
+
+inline uint32 entityIndex(EntityID id)
+{
+	return id & ENTITY_INDEX_MASK;
+}
+
+inline uint32 entityGeneration(EntityID id)
+{
+	return id >> ENTITY_INDEX_BITS;
+}
+
+inline EntityID makeEntityID(uint32 index, uint32 generation)
+{
+	return (generation << ENTITY_INDEX_BITS) | (index & ENTITY_INDEX_MASK);
+}
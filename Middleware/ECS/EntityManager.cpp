@@ -1,59 +1,132 @@
 #include "EntityManager.h"
 
 #include <stdint.h>
+#include <assert.h>
 
-tinystl::unordered_map<uint32_t, std::list<Component*>> mComponentPoolMap;
-
-EntityManager::EntityManager()
+// ticks start at 1 so a query since tick 0 sees every component
+EntityManager::EntityManager() : mFreeListHead(INVALID_SLOT), mEntityCount(0), mChangeTick(1)
 {
-	mEntityIDCounter = 1;
+	// reserve slot 0 so that INVALID_ENTITY_ID never resolves
+	EntitySlot reserved = { new(mEntityAllocator.allocate()) Entity, 0, INVALID_SLOT };
+	mSlots.push_back(reserved);
 }
 
 EntityManager::~EntityManager()
 {
-	for (tinystl::unordered_hash_node<uint32, Entity*> entity : mEntities)
+	for (EntitySlot& slot : mSlots)
+	{
+		slot.pEntity->~Entity();
+		mEntityAllocator.deallocate(slot.pEntity);
+	}
+
+	for (ComponentPoolBase* pPool : mComponentPools)
 	{
-		entity.second->~Entity();
+		delete pPool;
 	}
 }
 
-std::list<Component*> EntityManager::GetComponents(uint32_t type)
+EntityID EntityManager::createEntity()
 {
-	tinystl::unordered_map<uint32_t, std::list<Component*>>::iterator itr = mComponentPoolMap.find(type);
-	return itr->second;
+	uint32 index = mFreeListHead;
+	if (index != INVALID_SLOT)
+	{
+		mFreeListHead = mSlots[index].nextFree;
+	}
+	else
+	{
+		index = (uint32)mSlots.size();
+		assert(index <= ENTITY_INDEX_MASK);
+
+		EntitySlot slot = { new(mEntityAllocator.allocate()) Entity, 0, INVALID_SLOT };
+		slot.pEntity->pManager = this;
+		mSlots.push_back(slot);
+	}
+
+	EntitySlot& slot = mSlots[index];
+	slot.nextFree = INVALID_SLOT;
+	slot.pEntity->ID = makeEntityID(index, slot.generation);
+	++mEntityCount;
+
+	return slot.pEntity->ID;
 }
 
-Entity::~Entity()
+void EntityManager::destroyEntity(EntityID id)
 {
-	for (tinystl::unordered_hash_node<uint32, Component*> component : mComponents)
+	Entity* pEntity = getEntityByID(id);
+	if (pEntity)
 	{
-		Component* pComponent = component.second;
+		removeComponents(pEntity);
 
-		uint32_t type = pComponent->getType();
-		tinystl::unordered_map<uint32_t, std::list<Component*>>::iterator itr = mComponentPoolMap.find(type);
-		if (itr != mComponentPoolMap.end())
+		uint32 index = entityIndex(id);
+		EntitySlot& slot = mSlots[index];
+		// a slot that handed out its last generation is retired, wrapping would revive its oldest IDs
+		if (slot.generation < ENTITY_GENERATION_MASK)
 		{
-			itr->second.remove(pComponent);
+			slot.generation++;
+			slot.nextFree = mFreeListHead;
+			mFreeListHead = index;
 		}
+		pEntity->ID = INVALID_ENTITY_ID;
+		--mEntityCount;
+	}
+}
 
-		pComponent->~Component();
+void EntityManager::removeComponents(Entity* pEntity)
+{
+	for (uint32 type : pEntity->mComponentTypes)
+	{
+		mComponentPools[type]->remove(pEntity->ID);
 	}
+	pEntity->mComponentTypes.clear();
 }
 
-void Entity::AddComponent(Component* component)
+void EntityManager::beginFrame()
 {
-	uint32_t type = component->getType();
-	mComponents.insert({ type, component });
+	mFrameArena.reset();
+	mEntityAllocator.stats().endFrame();
+	mComponentStats.endFrame();
+	representationAllocatorStats().endFrame();
+}
 
-	tinystl::unordered_map<uint32_t, std::list<Component*>>::iterator itr = mComponentPoolMap.find(type);
-	if (itr == mComponentPoolMap.end())
+EntityManagerMemoryStats EntityManager::memoryStats() const
+{
+	EntityManagerMemoryStats stats;
+	stats.entities = mEntityAllocator.stats();
+	stats.components = mComponentStats;
+	stats.representations = representationAllocatorStats();
+	stats.frameArena = mFrameArena.stats();
+	return stats;
+}
+
+void EntityManager::resetSlots(uint32 slotCount)
+{
+	for (EntitySlot& slot : mSlots)
 	{
-		std::list<Component*> list;
-		list.push_front(component);
-		mComponentPoolMap.insert({ type, list });
+		if (slot.pEntity->ID != INVALID_ENTITY_ID)
+			removeComponents(slot.pEntity);
 	}
-	else
+
+	while (mSlots.size() > slotCount && mSlots.size() > 1)
+	{
+		Entity* pEntity = mSlots.back().pEntity;
+		pEntity->~Entity();
+		mEntityAllocator.deallocate(pEntity);
+		mSlots.pop_back();
+	}
+
+	while (mSlots.size() < slotCount)
+	{
+		EntitySlot slot = { new(mEntityAllocator.allocate()) Entity, 0, INVALID_SLOT };
+		slot.pEntity->pManager = this;
+		mSlots.push_back(slot);
+	}
+
+	for (EntitySlot& slot : mSlots)
 	{
-		itr->second.push_front(component);
+		slot.pEntity->ID = INVALID_ENTITY_ID;
+		slot.generation = 0;
+		slot.nextFree = INVALID_SLOT;
 	}
+	mFreeListHead = INVALID_SLOT;
+	mEntityCount = 0;
 }
\ No newline at end of file
@@ -1,44 +1,48 @@
 #pragma once
 
 #include "Component.h"
-#include <list>
+#include "EntityID.h"
+#include "ComponentPool.h"
+#include "View.h"
+#include "../Memory/PoolAllocator.h"
+#include "../Memory/LinearArena.h"
 
 class Entity;
 class EntityManager;
 
 typedef unsigned int uint32;
-typedef uint32		 EntityID;
-typedef tinystl::unordered_map<uint32, Component*> ComponentMap;
-typedef tinystl::unordered_map<EntityID, Entity*>  EntityMap;
+// indexed by component type ID, NULL until the first component of that type is added
+typedef tinystl::vector<ComponentPoolBase*> ComponentPoolArray;
+
+struct EntityManagerMemoryStats
+{
+	AllocatorStats entities;
+	AllocatorStats components;
+	AllocatorStats representations;
+	AllocatorStats frameArena;
+};
 
 class Entity
 {
 	friend class EntityManager;
+	friend class SceneSnapshot;
 public:
-	Entity() : ID(0), mComponents() {}
-	~Entity();
+	Entity() : ID(INVALID_ENTITY_ID), pManager(nullptr), mComponentTypes() {}
 
+	// Returned pointer lives in the packed pool of T, adding or removing
+	// another T may move it.
 	template <typename T>
-	T* GetComponent()
-	{
-		T* componentOut = nullptr;
-		
-		ComponentMap::iterator it = mComponents.find(T::getTypeStatic());
-		if (it != mComponents.end())
-			componentOut = (T*)it->second;
-
-		return componentOut;
-	}
+	T* GetComponent();
 
 private:
-	void AddComponent(Component* component);
-
 	EntityID ID;
-	ComponentMap mComponents;
+	EntityManager* pManager;
+	tinystl::vector<uint32> mComponentTypes;
 };
 
 class EntityManager
 {
+	friend class SceneSnapshot;
 public:
 	EntityManager();
 	~EntityManager();
@@ -49,41 +53,128 @@ public:
 		Entity* pEntity = getEntityByID(id);
 		if (pEntity)
 		{
-			T* pComponent = new T;
-			pEntity->AddComponent(pComponent);
+			ComponentPool<T>* pPool = getOrCreatePool<T>();
+			if (!pPool->has(id))
+			{
+				pPool->add(id);
+				pEntity->mComponentTypes.push_back(T::getTypeStatic());
+			}
 		}
 	}
 
-	EntityID createEntity()
+	template <typename T>
+	T* getComponent(EntityID id)
 	{
-		Entity* pEntity = new Entity;
-		pEntity->ID = mEntityIDCounter++;
-		mEntities.emplace({ pEntity->ID, pEntity });
-		return pEntity->ID;
+		ComponentPool<T>* pPool = getPool<T>();
+		return pPool ? pPool->get(id) : nullptr;
 	}
 
-	void destroyEntity(EntityID id)
+	// Packed storage of every T, iterate it linearly with begin()/end().
+	template <typename T>
+	ComponentPool<T>* getPool()
 	{
-		Entity* pEntity = getEntityByID(id);
-		if (pEntity)
-		{
-			delete pEntity;
-		}
+		uint32 type = T::getTypeStatic();
+		return type < mComponentPools.size() ? static_cast<ComponentPool<T>*>(mComponentPools[type]) : nullptr;
 	}
 
+	EntityID createEntity();
+	void destroyEntity(EntityID id);
+
+	// O(1), returns NULL for destroyed entities and stale IDs of recycled slots
 	Entity* getEntityByID(EntityID id)
 	{
-		EntityMap::iterator itr = mEntities.find(id);
-		if (itr != mEntities.end())
+		uint32 index = entityIndex(id);
+		if (id != INVALID_ENTITY_ID && index < mSlots.size() && mSlots[index].generation == entityGeneration(id) && mSlots[index].pEntity->ID == id)
 		{
-			return itr->second;
+			return mSlots[index].pEntity;
 		}
 		return nullptr;
 	}
 
-	std::list<Component*> GetComponents(uint32_t);
+	bool isAlive(EntityID id) { return getEntityByID(id) != nullptr; }
+
+	uint32 entityCount() const { return mEntityCount; }
+	uint32 slotCount() const { return (uint32)mSlots.size(); }
+
+	// Call once per frame before the systems run, drops the frame arena and rolls the per frame counters.
+	void beginFrame();
+
+	// Scratch memory that stays valid until the next beginFrame(), e.g. data staged for an upload.
+	// Not thread safe, only the main thread and RunOnMainThread() systems allocate from it.
+	LinearArena& frameArena() { return mFrameArena; }
+
+	EntityManagerMemoryStats memoryStats() const;
+
+	// e.g. view<ModelComponent, LightComponent>().each([](EntityID id, ModelComponent& model, LightComponent& light) {});
+	// sinceTick is what Changed<T> / Added<T> filters compare against.
+	template <typename... Queries>
+	View<Queries...> view(uint32 sinceTick = 0)
+	{
+		return View<Queries...>(getPool<typename QueryTraits<Queries>::Component>()..., sinceTick);
+	}
+
+	// Components don't know when they are written to, whoever modifies one calls this
+	// so Changed<T> queries pick it up.
+	template <typename T>
+	void markChanged(EntityID id)
+	{
+		ComponentPool<T>* pPool = getPool<T>();
+		if (pPool)
+			pPool->markChanged(id);
+	}
+
+	// Change ticks only ever grow. Adding or marking a component stamps it with the
+	// current tick, advanceChangeTick() returns the current tick and moves on so
+	// everything stamped afterwards compares greater.
+	uint32 changeTick() const { return mChangeTick.load(); }
+	uint32 advanceChangeTick() { return mChangeTick.fetch_add(1); }
 
 private:
-	EntityMap mEntities;
-	EntityID  mEntityIDCounter;
-};
\ No newline at end of file
+	template <typename T>
+	ComponentPool<T>* getOrCreatePool()
+	{
+		ComponentPool<T>* pPool = getPool<T>();
+		if (!pPool)
+		{
+			uint32 type = T::getTypeStatic();
+			if (type >= mComponentPools.size())
+				mComponentPools.resize(type + 1, nullptr);
+
+			pPool = new ComponentPool<T>(&mComponentStats, &mChangeTick);
+			mComponentPools[type] = pPool;
+		}
+		return pPool;
+	}
+
+	void removeComponents(Entity* pEntity);
+
+	// drops every entity and resizes the slot map to slotCount empty slots
+	void resetSlots(uint32 slotCount);
+
+	// Slot map, destroyed slots are chained into a free list and recycled with a new generation.
+	// A slot whose generation ran out stays off the list for good.
+	// Entity objects stay allocated with their slot.
+#define INVALID_SLOT 0xFFFFFFFF
+	struct EntitySlot
+	{
+		Entity* pEntity;
+		uint32	generation;
+		uint32	nextFree;
+	};
+
+	tinystl::vector<EntitySlot> mSlots;
+	uint32						mFreeListHead;
+	uint32						mEntityCount;
+	ComponentPoolArray			mComponentPools;
+
+	PoolAllocator<Entity>		mEntityAllocator;
+	AllocatorStats				mComponentStats;
+	LinearArena					mFrameArena;
+	std::atomic<uint32>			mChangeTick;
+};
+
+template <typename T>
+T* Entity::GetComponent()
+{
+	return pManager->getComponent<T>(ID);
+}
\ No newline at end of file
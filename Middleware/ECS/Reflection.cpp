@@ -0,0 +1,65 @@
+#include "Reflection.h"
+#include "Component.h"
+
+#include <string.h>
+
+static tinystl::vector<ComponentTypeInfo*>& componentTypeRegistry()
+{
+	static tinystl::vector<ComponentTypeInfo*> registry;
+	return registry;
+}
+
+// FNV-1a
+static uint32 hashBytes(uint32 hash, const void* pData, size_t size)
+{
+	const unsigned char* pBytes = (const unsigned char*)pData;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= pBytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+uint32 ComponentTypeInfo::layoutHash() const
+{
+	uint32 hash = hashBytes(2166136261u, name, strlen(name));
+	for (const FieldInfo& field : fields)
+	{
+		hash = hashBytes(hash, field.name, strlen(field.name));
+		hash = hashBytes(hash, &field.size, sizeof(field.size));
+		hash = hashBytes(hash, &field.type, sizeof(field.type));
+	}
+	return hash;
+}
+
+bool registerComponentType(ComponentTypeInfo* pInfo)
+{
+	componentTypeRegistry().push_back(pInfo);
+	return true;
+}
+
+const tinystl::vector<ComponentTypeInfo*>& componentTypes()
+{
+	return componentTypeRegistry();
+}
+
+const ComponentTypeInfo* findComponentType(const char* name)
+{
+	for (ComponentTypeInfo* pInfo : componentTypeRegistry())
+	{
+		if (strcmp(pInfo->name, name) == 0)
+			return pInfo;
+	}
+	return nullptr;
+}
+
+const ComponentTypeInfo* findComponentType(uint32 typeID)
+{
+	for (ComponentTypeInfo* pInfo : componentTypeRegistry())
+	{
+		if (pInfo->getTypeID() == typeID)
+			return pInfo;
+	}
+	return nullptr;
+}
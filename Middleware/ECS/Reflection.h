@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+#include <TINYSTL/vector.h>
+
+typedef unsigned int uint32;
+
+class ComponentPoolBase;
+struct AllocatorStats;
+template <typename T> class ComponentPool;
+
+// Type of a registered variable. Anything that is not a plain scalar is stored
+// as FIELD_RAW and copied byte for byte, so it has to be trivially copyable.
+enum FieldType
+{
+	FIELD_RAW,
+	FIELD_INT32,
+	FIELD_UINT32,
+	FIELD_FLOAT,
+	FIELD_DOUBLE,
+	FIELD_BOOL
+};
+
+template <typename T> struct FieldTypeOf		   { static const FieldType value = FIELD_RAW; };
+template <>			  struct FieldTypeOf<int>	   { static const FieldType value = FIELD_INT32; };
+template <>			  struct FieldTypeOf<unsigned> { static const FieldType value = FIELD_UINT32; };
+template <>			  struct FieldTypeOf<float>	   { static const FieldType value = FIELD_FLOAT; };
+template <>			  struct FieldTypeOf<double>   { static const FieldType value = FIELD_DOUBLE; };
+template <>			  struct FieldTypeOf<bool>	   { static const FieldType value = FIELD_BOOL; };
+
+struct FieldInfo
+{
+	const char* name;
+	uint32		id;
+	void*		(*address)(void* pComponent); // the variable inside a component of this type
+	uint32		size;
+	FieldType	type;
+};
+
+// Everything REGISTER_COMPONENT_CLASS / DEFINE_VARIABLE know about a component type.
+struct ComponentTypeInfo
+{
+	const char* name;
+	uint32		size;
+	uint32		(*getTypeID)();
+	ComponentPoolBase* (*createPool)(AllocatorStats* pStats, const std::atomic<uint32>* pChangeTick);
+	tinystl::vector<FieldInfo> fields;
+
+	// changes whenever a field is added, removed, renamed, resized or retyped
+	uint32 layoutHash() const;
+};
+
+template <typename T>
+ComponentPoolBase* createComponentPool(AllocatorStats* pStats, const std::atomic<uint32>* pChangeTick)
+{
+	return new ComponentPool<T>(pStats, pChangeTick);
+}
+
+template <typename T>
+ComponentTypeInfo makeComponentTypeInfo(const char* name)
+{
+	ComponentTypeInfo info;
+	info.name = name;
+	info.size = sizeof(T);
+	info.getTypeID = &T::getTypeStatic;
+	info.createPool = &createComponentPool<T>;
+	return info;
+}
+
+// Components derive from the polymorphic Component, so they aren't standard layout and
+// offsetof isn't defined for them; the member pointer finds the variable instead
+template <typename C, typename T, T C::*Member>
+void* fieldAddress(void* pComponent)
+{
+	return &(static_cast<C*>(pComponent)->*Member);
+}
+
+template <typename C, typename T, T C::*Member>
+FieldInfo makeFieldInfo(const char* name)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "registered variables are copied byte for byte by snapshots");
+	FieldInfo field = { name, 0, &fieldAddress<C, T, Member>, (uint32)sizeof(T), FieldTypeOf<T>::value };
+	return field;
+}
+
+// Every type that went through START_REGISTRATION, filled during static initialization.
+bool registerComponentType(ComponentTypeInfo* pInfo);
+const tinystl::vector<ComponentTypeInfo*>& componentTypes();
+const ComponentTypeInfo* findComponentType(const char* name);
+const ComponentTypeInfo* findComponentType(uint32 typeID);
@@ -0,0 +1,329 @@
+#include "Snapshot.h"
+
+#include <stdio.h>
+#include <string.h>
+
+struct SnapshotHeader
+{
+	uint32 magic;
+	uint32 version;
+	uint32 slotCount;
+	uint32 freeListHead;
+	uint32 entityCount;
+	uint32 typeCount;
+};
+
+struct SnapshotTypeHeader
+{
+	uint32 nameLength;
+	uint32 layoutHash;
+	uint32 count;
+	uint32 fieldCount;
+};
+
+//////////////////////////////////////////////// WRITE
+static unsigned char* reserveBytes(tinystl::vector<unsigned char>& buffer, size_t size)
+{
+	size_t offset = buffer.size();
+	buffer.resize(offset + size);
+	return buffer.data() + offset;
+}
+
+// keeps every header and ID column 4 byte aligned after names and odd sized columns
+static void writePadding(tinystl::vector<unsigned char>& buffer)
+{
+	while (buffer.size() % 4)
+		buffer.push_back(0);
+}
+
+static void writeBytes(tinystl::vector<unsigned char>& buffer, const void* pData, size_t size)
+{
+	memcpy(reserveBytes(buffer, size), pData, size);
+}
+
+void SceneSnapshot::Write(EntityManager* pManager, tinystl::vector<unsigned char>& buffer)
+{
+	buffer.clear();
+
+	SnapshotHeader header;
+	header.magic = SNAPSHOT_MAGIC;
+	header.version = SNAPSHOT_VERSION;
+	header.slotCount = (uint32)pManager->mSlots.size();
+	header.freeListHead = pManager->mFreeListHead;
+	header.entityCount = pManager->mEntityCount;
+	header.typeCount = 0;
+	writeBytes(buffer, &header, sizeof(header));
+
+	// slot map as three columns
+	uint32* pIDs = (uint32*)reserveBytes(buffer, sizeof(uint32) * header.slotCount);
+	for (uint32 i = 0; i < header.slotCount; ++i)
+	{
+		pIDs[i] = pManager->mSlots[i].pEntity->ID;
+	}
+	uint32* pGenerations = (uint32*)reserveBytes(buffer, sizeof(uint32) * header.slotCount);
+	for (uint32 i = 0; i < header.slotCount; ++i)
+	{
+		pGenerations[i] = pManager->mSlots[i].generation;
+	}
+	uint32* pNextFree = (uint32*)reserveBytes(buffer, sizeof(uint32) * header.slotCount);
+	for (uint32 i = 0; i < header.slotCount; ++i)
+	{
+		pNextFree[i] = pManager->mSlots[i].nextFree;
+	}
+
+	for (uint32 type = 0; type < pManager->mComponentPools.size(); ++type)
+	{
+		ComponentPoolBase* pPool = pManager->mComponentPools[type];
+		const ComponentTypeInfo* pInfo = findComponentType(type);
+		if (!pPool || !pPool->size() || !pInfo)
+			continue;
+
+		SnapshotTypeHeader typeHeader;
+		typeHeader.nameLength = (uint32)strlen(pInfo->name);
+		typeHeader.layoutHash = pInfo->layoutHash();
+		typeHeader.count = pPool->size();
+		typeHeader.fieldCount = (uint32)pInfo->fields.size();
+		writeBytes(buffer, &typeHeader, sizeof(typeHeader));
+		writeBytes(buffer, pInfo->name, typeHeader.nameLength);
+		writePadding(buffer);
+		writeBytes(buffer, pPool->entities(), sizeof(EntityID) * typeHeader.count);
+
+		unsigned char* pComponents = (unsigned char*)pPool->data();
+		uint32 stride = pPool->elementSize();
+		for (const FieldInfo& field : pInfo->fields)
+		{
+			writeBytes(buffer, &field.size, sizeof(field.size));
+			unsigned char* pColumn = reserveBytes(buffer, (size_t)field.size * typeHeader.count);
+			for (uint32 i = 0; i < typeHeader.count; ++i)
+			{
+				memcpy(pColumn + (size_t)i * field.size, field.address(pComponents + (size_t)i * stride), field.size);
+			}
+			writePadding(buffer);
+		}
+
+		++header.typeCount;
+	}
+
+	// patch the type count in now that skipped types are known
+	memcpy(buffer.data() + offsetof(SnapshotHeader, typeCount), &header.typeCount, sizeof(header.typeCount));
+}
+
+//////////////////////////////////////////////// READ
+struct SnapshotReader
+{
+	const unsigned char* pData;
+	size_t size;
+	size_t offset;
+
+	const unsigned char* read(size_t bytes)
+	{
+		if (bytes > size - offset)
+			return nullptr;
+		const unsigned char* pBytes = pData + offset;
+		offset += bytes;
+		return pBytes;
+	}
+
+	bool skipPadding()
+	{
+		return read((4 - offset % 4) % 4) != nullptr;
+	}
+};
+
+ComponentPoolBase* SceneSnapshot::getOrCreatePool(EntityManager* pManager, const ComponentTypeInfo& info)
+{
+	uint32 type = info.getTypeID();
+	if (type >= pManager->mComponentPools.size())
+		pManager->mComponentPools.resize(type + 1, nullptr);
+
+	if (!pManager->mComponentPools[type])
+		pManager->mComponentPools[type] = info.createPool(&pManager->mComponentStats, &pManager->mChangeTick);
+	return pManager->mComponentPools[type];
+}
+
+// a type block that matched a registered type, pointers into the snapshot
+struct SnapshotTypeBlock
+{
+	const ComponentTypeInfo* pInfo;
+	uint32 count;
+	const EntityID* pEntities;
+	tinystl::vector<const unsigned char*> columns;
+};
+
+// the slot map has to be one EntityManager could have built itself: live IDs name their own
+// slot and generation, the free list only chains free slots and reaches each at most once
+static bool validSlots(const SnapshotHeader& header, const uint32* pIDs, const uint32* pGenerations, const uint32* pNextFree)
+{
+	if (header.slotCount > ENTITY_INDEX_MASK + 1 || (header.freeListHead != INVALID_SLOT && header.freeListHead >= header.slotCount))
+		return false;
+
+	uint32 alive = 0;
+	for (uint32 i = 0; i < header.slotCount; ++i)
+	{
+		if (pGenerations[i] > ENTITY_GENERATION_MASK || (pNextFree[i] != INVALID_SLOT && pNextFree[i] >= header.slotCount))
+			return false;
+		if (pIDs[i] == INVALID_ENTITY_ID)
+			continue;
+		if (i == 0 || pIDs[i] != makeEntityID(i, pGenerations[i]) || pNextFree[i] != INVALID_SLOT)
+			return false;
+		++alive;
+	}
+	if (alive != header.entityCount)
+		return false;
+
+	tinystl::vector<bool> visited(header.slotCount, false);
+	for (uint32 slot = header.freeListHead; slot != INVALID_SLOT; slot = pNextFree[slot])
+	{
+		if (slot == 0 || visited[slot] || pIDs[slot] != INVALID_ENTITY_ID)
+			return false;
+		visited[slot] = true;
+	}
+	return true;
+}
+
+bool SceneSnapshot::Read(EntityManager* pManager, const unsigned char* pData, size_t size)
+{
+	SnapshotReader reader = { pData, size, 0 };
+
+	// everything is parsed and checked first, a snapshot that fails leaves the scene untouched
+	const SnapshotHeader* pHeader = (const SnapshotHeader*)reader.read(sizeof(SnapshotHeader));
+	if (!pHeader || pHeader->magic != SNAPSHOT_MAGIC || pHeader->version != SNAPSHOT_VERSION || pHeader->slotCount == 0)
+		return false;
+
+	SnapshotHeader header = *pHeader;
+	const uint32* pIDs = (const uint32*)reader.read(sizeof(uint32) * header.slotCount);
+	const uint32* pGenerations = (const uint32*)reader.read(sizeof(uint32) * header.slotCount);
+	const uint32* pNextFree = (const uint32*)reader.read(sizeof(uint32) * header.slotCount);
+	if (!pNextFree || !validSlots(header, pIDs, pGenerations, pNextFree))
+		return false;
+
+	tinystl::vector<SnapshotTypeBlock> blocks;
+	tinystl::vector<uint32> seen(header.slotCount, 0); // last block each entity showed up in, + 1
+	for (uint32 t = 0; t < header.typeCount; ++t)
+	{
+		const SnapshotTypeHeader* pTypeHeader = (const SnapshotTypeHeader*)reader.read(sizeof(SnapshotTypeHeader));
+		if (!pTypeHeader)
+			return false;
+		SnapshotTypeHeader typeHeader = *pTypeHeader;
+
+		const char* pName = (const char*)reader.read(typeHeader.nameLength);
+		if (!pName || !reader.skipPadding())
+			return false;
+		const EntityID* pEntities = (const EntityID*)reader.read(sizeof(EntityID) * typeHeader.count);
+		if (!pEntities)
+			return false;
+
+		char name[256];
+		if (typeHeader.nameLength >= sizeof(name))
+			return false;
+		memcpy(name, pName, typeHeader.nameLength);
+		name[typeHeader.nameLength] = '\0';
+
+		const ComponentTypeInfo* pInfo = findComponentType(name);
+		bool matches = pInfo && pInfo->layoutHash() == typeHeader.layoutHash && pInfo->fields.size() == typeHeader.fieldCount;
+		for (const SnapshotTypeBlock& block : blocks)
+		{
+			if (matches && block.pInfo == pInfo)
+				return false;
+		}
+
+		SnapshotTypeBlock block = { pInfo, typeHeader.count, pEntities, {} };
+		for (uint32 f = 0; f < typeHeader.fieldCount; ++f)
+		{
+			const uint32* pFieldSize = (const uint32*)reader.read(sizeof(uint32));
+			if (!pFieldSize)
+				return false;
+			uint32 fieldSize = *pFieldSize;
+			const unsigned char* pColumn = reader.read((size_t)fieldSize * typeHeader.count);
+			if (!pColumn || !reader.skipPadding())
+				return false;
+
+			// the layout hash covers the sizes, a different one means the file is damaged
+			if (matches && fieldSize != pInfo->fields[f].size)
+				return false;
+			block.columns.push_back(pColumn);
+		}
+		if (!matches)
+			continue;
+
+		// every component belongs to a live entity, once
+		const uint32 Stamp = (uint32)blocks.size() + 1;
+		for (uint32 i = 0; i < typeHeader.count; ++i)
+		{
+			uint32 index = entityIndex(pEntities[i]);
+			if (pEntities[i] == INVALID_ENTITY_ID || index >= header.slotCount || pIDs[index] != pEntities[i] || seen[index] == Stamp)
+				return false;
+			seen[index] = Stamp;
+		}
+		blocks.push_back(block);
+	}
+
+	pManager->resetSlots(header.slotCount);
+	for (uint32 i = 0; i < header.slotCount; ++i)
+	{
+		EntityManager::EntitySlot& slot = pManager->mSlots[i];
+		slot.pEntity->ID = pIDs[i];
+		slot.generation = pGenerations[i];
+		slot.nextFree = pNextFree[i];
+	}
+	pManager->mFreeListHead = header.freeListHead;
+	pManager->mEntityCount = header.entityCount;
+
+	for (const SnapshotTypeBlock& block : blocks)
+	{
+		uint32 type = block.pInfo->getTypeID();
+		ComponentPoolBase* pPool = getOrCreatePool(pManager, *block.pInfo);
+		uint32 firstIndex = pPool->size();
+		pPool->reserve(firstIndex + block.count);
+		for (uint32 i = 0; i < block.count; ++i)
+		{
+			pPool->addUntyped(block.pEntities[i]);
+			pManager->mSlots[entityIndex(block.pEntities[i])].pEntity->mComponentTypes.push_back(type);
+		}
+
+		unsigned char* pComponents = (unsigned char*)pPool->data() + (size_t)firstIndex * pPool->elementSize();
+		uint32 stride = pPool->elementSize();
+		for (uint32 f = 0; f < block.columns.size(); ++f)
+		{
+			const FieldInfo& field = block.pInfo->fields[f];
+			for (uint32 i = 0; i < block.count; ++i)
+			{
+				memcpy(field.address(pComponents + (size_t)i * stride), block.columns[f] + (size_t)i * field.size, field.size);
+			}
+		}
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////// FILES
+bool SceneSnapshot::Save(EntityManager* pManager, const char* path)
+{
+	tinystl::vector<unsigned char> buffer;
+	Write(pManager, buffer);
+
+	FILE* pFile = fopen(path, "wb");
+	if (!pFile)
+		return false;
+	bool written = fwrite(buffer.data(), 1, buffer.size(), pFile) == buffer.size();
+	fclose(pFile);
+	return written;
+}
+
+bool SceneSnapshot::Load(EntityManager* pManager, const char* path)
+{
+	FILE* pFile = fopen(path, "rb");
+	if (!pFile)
+		return false;
+
+	fseek(pFile, 0, SEEK_END);
+	long size = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+
+	tinystl::vector<unsigned char> buffer;
+	buffer.resize(size > 0 ? (size_t)size : 0);
+	bool read = size > 0 && fread(buffer.data(), 1, buffer.size(), pFile) == buffer.size();
+	fclose(pFile);
+
+	return read && Read(pManager, buffer.data(), buffer.size());
+}
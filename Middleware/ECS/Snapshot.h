@@ -0,0 +1,27 @@
+#pragma once
+
+#include "EntityManager.h"
+
+#define SNAPSHOT_MAGIC	 0x50534345 // "ECSP"
+#define SNAPSHOT_VERSION 1
+
+// Binary dump of a whole EntityManager: the slot map (IDs, generations and free list,
+// so restored IDs and the IDs handed out afterwards match the saved session exactly)
+// followed by one block per component type.
+// Components carry a vptr and may own pointers, so instead of the raw packed array
+// every registered variable is written as its own column, gathered from and scattered
+// back into the packed pool in one pass. Variables that were not registered with
+// DEFINE_VARIABLE keep their default constructed value after a restore.
+// A type whose layout changed since the snapshot was taken is skipped.
+class SceneSnapshot
+{
+public:
+	static void Write(EntityManager* pManager, tinystl::vector<unsigned char>& buffer);
+	static bool Read(EntityManager* pManager, const unsigned char* pData, size_t size);
+
+	static bool Save(EntityManager* pManager, const char* path);
+	static bool Load(EntityManager* pManager, const char* path);
+
+private:
+	static ComponentPoolBase* getOrCreatePool(EntityManager* pManager, const ComponentTypeInfo& info);
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Component.h"
+
+class EntityManager;
+
+// Base for systems run by the SystemScheduler.
+// Every system declares the component types it reads and writes in its constructor,
+// the scheduler runs systems concurrently unless one writes what the other touches.
+class System
+{
+	friend class SystemScheduler;
+public:
+	System(EntityManager* pEM) : pEntityManager(pEM), mMainThreadOnly(false), mLastRunTick(0) {}
+	virtual ~System() {}
+
+	virtual void Update(float dt) = 0;
+
+	const tinystl::vector<uint32>& reads() const  { return mReads; }
+	const tinystl::vector<uint32>& writes() const { return mWrites; }
+	bool mainThreadOnly() const { return mMainThreadOnly; }
+
+	bool conflictsWith(const System& other) const
+	{
+		return overlaps(mWrites, other.mReads) || overlaps(mWrites, other.mWrites) || overlaps(mReads, other.mWrites);
+	}
+
+	EntityManager* pEntityManager;
+
+protected:
+	template <typename T>
+	void Reads() { mReads.push_back(T::getTypeStatic()); }
+
+	template <typename T>
+	void Writes() { mWrites.push_back(T::getTypeStatic()); }
+
+	// for systems that talk to the graphics context
+	void RunOnMainThread() { mMainThreadOnly = true; }
+
+	// change tick the scheduler started the previous Update() at, 0 before the first one,
+	// e.g. pEntityManager->view<Changed<LightComponent>>(lastRunTick())
+	uint32 lastRunTick() const { return mLastRunTick; }
+
+private:
+	static bool overlaps(const tinystl::vector<uint32>& a, const tinystl::vector<uint32>& b)
+	{
+		for (uint32 typeA : a)
+			for (uint32 typeB : b)
+				if (typeA == typeB)
+					return true;
+		return false;
+	}
+
+	tinystl::vector<uint32> mReads;
+	tinystl::vector<uint32> mWrites;
+	bool mMainThreadOnly;
+	uint32 mLastRunTick;
+};
@@ -0,0 +1,118 @@
+#include "SystemScheduler.h"
+#include "EntityManager.h"
+
+#include <thread>
+
+SystemScheduler::SystemScheduler(JobSystem* pJobSystem) : mpJobSystem(pJobSystem), mGraphDirty(false), mCompletedCount(0), mDeltaTime(0.0f)
+{
+}
+
+void SystemScheduler::RegisterSystem(System* pSystem)
+{
+	SystemNode node;
+	node.pSystem = pSystem;
+	node.dependencyCount = 0;
+	mNodes.push_back(node);
+	mGraphDirty = true;
+}
+
+// An edge runs from every system to each later registered system it conflicts with.
+void SystemScheduler::buildGraph()
+{
+	for (SystemNode& node : mNodes)
+	{
+		node.successors.clear();
+		node.dependencyCount = 0;
+	}
+
+	for (uint32 i = 0; i < mNodes.size(); ++i)
+	{
+		for (uint32 j = i + 1; j < mNodes.size(); ++j)
+		{
+			if (mNodes[i].pSystem->conflictsWith(*mNodes[j].pSystem))
+			{
+				mNodes[i].successors.push_back(j);
+				++mNodes[j].dependencyCount;
+			}
+		}
+	}
+
+	mRemainingDependencies.reset(new std::atomic<uint32>[mNodes.size()]);
+	mGraphDirty = false;
+}
+
+void SystemScheduler::Run(float dt)
+{
+	if (mNodes.empty())
+		return;
+
+	if (mGraphDirty)
+		buildGraph();
+
+	mDeltaTime = dt;
+	mCompletedCount = 0;
+	for (uint32 i = 0; i < mNodes.size(); ++i)
+	{
+		mRemainingDependencies[i] = mNodes[i].dependencyCount;
+	}
+
+	for (uint32 i = 0; i < mNodes.size(); ++i)
+	{
+		if (mNodes[i].dependencyCount == 0)
+			dispatch(i);
+	}
+
+	while (mCompletedCount.load() < mNodes.size())
+	{
+		uint32 node = 0;
+		bool hasMainThreadNode = false;
+		{
+			std::lock_guard<std::mutex> lock(mMainThreadMutex);
+			if (!mMainThreadQueue.empty())
+			{
+				node = mMainThreadQueue.front();
+				mMainThreadQueue.pop_front();
+				hasMainThreadNode = true;
+			}
+		}
+
+		if (hasMainThreadNode)
+			runNode(node);
+		else if (!mpJobSystem->RunPendingJob())
+			std::this_thread::yield();
+	}
+}
+
+void SystemScheduler::dispatch(uint32 node)
+{
+	if (mNodes[node].pSystem->mainThreadOnly())
+	{
+		std::lock_guard<std::mutex> lock(mMainThreadMutex);
+		mMainThreadQueue.push_back(node);
+	}
+	else
+	{
+		mpJobSystem->Run(&SystemScheduler::systemJob, this, node, nullptr);
+	}
+}
+
+void SystemScheduler::runNode(uint32 node)
+{
+	System* pSystem = mNodes[node].pSystem;
+	uint32 tick = pSystem->pEntityManager->advanceChangeTick();
+	pSystem->Update(mDeltaTime);
+	pSystem->mLastRunTick = tick;
+
+	for (uint32 successor : mNodes[node].successors)
+	{
+		if (mRemainingDependencies[successor].fetch_sub(1) == 1)
+			dispatch(successor);
+	}
+
+	mCompletedCount.fetch_add(1);
+}
+
+void SystemScheduler::systemJob(void* pData, uint32 node)
+{
+	((SystemScheduler*)pData)->runNode(node);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "System.h"
+#include "../Jobs/JobSystem.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+// Runs registered systems once per Run() call.
+// Conflicting systems run in registration order, everything else is submitted to the job system.
+// The calling thread runs main thread systems and helps with pending jobs while it waits.
+class SystemScheduler
+{
+public:
+	SystemScheduler(JobSystem* pJobSystem);
+
+	// systems are not owned by the scheduler
+	void RegisterSystem(System* pSystem);
+
+	void Run(float dt);
+
+private:
+	struct SystemNode
+	{
+		System* pSystem;
+		tinystl::vector<uint32> successors;
+		uint32 dependencyCount;
+	};
+
+	void buildGraph();
+	void dispatch(uint32 node);
+	void runNode(uint32 node);
+	static void systemJob(void* pData, uint32 node);
+
+	JobSystem* mpJobSystem;
+
+	tinystl::vector<SystemNode> mNodes;
+	std::unique_ptr<std::atomic<uint32>[]> mRemainingDependencies;
+	bool mGraphDirty;
+
+	std::mutex mMainThreadMutex;
+	std::deque<uint32> mMainThreadQueue;
+	std::atomic<uint32> mCompletedCount;
+	float mDeltaTime;
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "ComponentPool.h"
+
+#include <tuple>
+#include <utility>
+
+// Query filters, used in place of a component type:
+// view<Changed<LightComponent>>(lastRunTick()) only visits lights marked changed after that tick,
+// Added<T> only those added after it. Both still hand T& to each().
+template <typename T> struct Changed {};
+template <typename T> struct Added {};
+
+template <typename Query>
+struct QueryTraits
+{
+	typedef Query Component;
+	static bool passes(const ComponentPoolBase& pool, uint32 index, uint32 sinceTick) { return true; }
+};
+
+template <typename T>
+struct QueryTraits<Changed<T>>
+{
+	typedef T Component;
+	static bool passes(const ComponentPoolBase& pool, uint32 index, uint32 sinceTick) { return pool.changedTick(index) > sinceTick; }
+};
+
+template <typename T>
+struct QueryTraits<Added<T>>
+{
+	typedef T Component;
+	static bool passes(const ComponentPoolBase& pool, uint32 index, uint32 sinceTick) { return pool.addedTick(index) > sinceTick; }
+};
+
+// Query over every entity that owns all of the queried components.
+// Iteration walks the smallest of the pools and probes the others through
+// their sparse arrays, so a pass costs O(smallest pool) and never allocates.
+template <typename... Queries>
+class View
+{
+public:
+	View(ComponentPool<typename QueryTraits<Queries>::Component>*... pPools, uint32 sinceTick = 0) : mPools(pPools...), mpLead(nullptr), mSinceTick(sinceTick)
+	{
+		ComponentPoolBase* pools[] = { pPools... };
+		for (ComponentPoolBase* pPool : pools)
+		{
+			// a type that was never added means nothing can match
+			if (!pPool)
+			{
+				mpLead = nullptr;
+				return;
+			}
+			if (!mpLead || pPool->size() < mpLead->size())
+				mpLead = pPool;
+		}
+	}
+
+	// func(EntityID, Components&...)
+	template <typename Func>
+	void each(Func func)
+	{
+		if (!mpLead)
+			return;
+
+		eachImpl(func, std::index_sequence_for<Queries...>());
+	}
+
+	bool contains(EntityID id) const
+	{
+		const ComponentPoolBase* pools[] = { std::get<ComponentPool<typename QueryTraits<Queries>::Component>*>(mPools)... };
+		for (const ComponentPoolBase* pPool : pools)
+		{
+			if (!pPool || !pPool->has(id))
+				return false;
+		}
+		return true;
+	}
+
+	template <typename T>
+	T* get(EntityID id)
+	{
+		ComponentPool<T>* pPool = std::get<ComponentPool<T>*>(mPools);
+		return pPool ? pPool->get(id) : nullptr;
+	}
+
+	// upper bound on the number of matching entities
+	uint32 sizeHint() const { return mpLead ? mpLead->size() : 0; }
+
+private:
+	template <typename Func, size_t... Is>
+	void eachImpl(Func& func, std::index_sequence<Is...>)
+	{
+		const EntityID* pEntities = mpLead->entities();
+		const uint32 count = mpLead->size();
+		for (uint32 i = 0; i < count; ++i)
+		{
+			EntityID id = pEntities[i];
+			uint32 indices[] = { indexIn<Is>(id, i)... };
+			if (!matches<Is...>(indices))
+				continue;
+
+			func(id, (*std::get<Is>(mPools))[indices[Is]]...);
+		}
+	}
+
+	// the lead pool is already positioned at leadIndex, skip its sparse lookup
+	template <size_t I>
+	uint32 indexIn(EntityID id, uint32 leadIndex) const
+	{
+		const ComponentPoolBase* pPool = std::get<I>(mPools);
+		return pPool == mpLead ? leadIndex : pPool->indexOf(id);
+	}
+
+	template <size_t... Is>
+	bool matches(const uint32* indices) const
+	{
+		for (uint32 i = 0; i < sizeof...(Is); ++i)
+		{
+			if (indices[i] == INVALID_DENSE_INDEX)
+				return false;
+		}
+
+		bool passes[] = { QueryTraits<Queries>::passes(*std::get<Is>(mPools), indices[Is], mSinceTick)... };
+		for (bool pass : passes)
+		{
+			if (!pass)
+				return false;
+		}
+		return true;
+	}
+
+	std::tuple<ComponentPool<typename QueryTraits<Queries>::Component>*...> mPools;
+	ComponentPoolBase* mpLead;
+	uint32 mSinceTick;
+};
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include "JobSystem.h"
+
+// worker threads remember which job system they belong to and which queue they own
+static thread_local JobSystem* tlsJobSystem = nullptr;
+static thread_local uint32	   tlsThreadIndex = 0;
+
+//////////////////////////////////////////////// JOB QUEUE
+bool JobSystem::JobQueue::push(const Job& job)
+{
+	lock();
+	if (mTail - mHead == JOB_QUEUE_CAPACITY)
+	{
+		unlock();
+		return false;
+	}
+	mJobs[mTail % JOB_QUEUE_CAPACITY] = job;
+	++mTail;
+	unlock();
+	return true;
+}
+
+bool JobSystem::JobQueue::pop(Job& job)
+{
+	lock();
+	if (mTail == mHead)
+	{
+		unlock();
+		return false;
+	}
+	--mTail;
+	job = mJobs[mTail % JOB_QUEUE_CAPACITY];
+	unlock();
+	return true;
+}
+
+bool JobSystem::JobQueue::steal(Job& job)
+{
+	lock();
+	if (mTail == mHead)
+	{
+		unlock();
+		return false;
+	}
+	job = mJobs[mHead % JOB_QUEUE_CAPACITY];
+	++mHead;
+	unlock();
+	return true;
+}
+
+//////////////////////////////////////////////// JOB SYSTEM
+JobSystem::JobSystem(uint32 threadCount) : mQueuedJobs(0), mSleepingWorkers(0), mShutdown(false)
+{
+	if (threadCount == 0)
+	{
+		threadCount = std::thread::hardware_concurrency();
+		if (threadCount == 0)
+			threadCount = 1;
+	}
+
+	for (uint32 i = 0; i < threadCount; ++i)
+	{
+		mQueues.push_back(new JobQueue);
+	}
+
+	tlsJobSystem = this;
+	tlsThreadIndex = 0;
+
+	for (uint32 i = 1; i < threadCount; ++i)
+	{
+		mWorkers.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mShutdown = true;
+	}
+	mWakeCondition.notify_all();
+
+	for (std::thread& worker : mWorkers)
+	{
+		worker.join();
+	}
+
+	for (JobQueue* pQueue : mQueues)
+	{
+		delete pQueue;
+	}
+
+	if (tlsJobSystem == this)
+		tlsJobSystem = nullptr;
+}
+
+void JobSystem::Run(JobFunction pFunction, void* pData, uint32 index, JobCounter* pCounter)
+{
+	if (pCounter)
+		pCounter->pending.fetch_add(1);
+
+	Job job = { pFunction, pData, index, pCounter };
+	submit(job);
+	wake(1);
+}
+
+void JobSystem::Wait(JobCounter* pCounter)
+{
+	while (pCounter->pending.load() != 0)
+	{
+		if (!RunPendingJob())
+			std::this_thread::yield();
+	}
+}
+
+bool JobSystem::RunPendingJob()
+{
+	Job job;
+	if (fetchJob(currentThreadIndex(), job))
+	{
+		execute(job);
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::submit(const Job& job)
+{
+	// counted before it is visible so a thief can never take the count below zero
+	mQueuedJobs.fetch_add(1);
+	if (!mQueues[currentThreadIndex()]->push(job))
+	{
+		mQueuedJobs.fetch_sub(1);
+
+		// queue is full, run it right here instead of blocking
+		Job inlineJob = job;
+		execute(inlineJob);
+	}
+}
+
+void JobSystem::wake(uint32 jobCount)
+{
+	if (mSleepingWorkers.load() == 0)
+		return;
+
+	std::lock_guard<std::mutex> lock(mSleepMutex);
+	if (jobCount > 1)
+		mWakeCondition.notify_all();
+	else
+		mWakeCondition.notify_one();
+}
+
+// own queue first (LIFO, still warm in cache), then steal the oldest job of another thread
+bool JobSystem::fetchJob(uint32 threadIndex, Job& job)
+{
+	if (mQueues[threadIndex]->pop(job))
+	{
+		mQueuedJobs.fetch_sub(1);
+		return true;
+	}
+
+	uint32 queueCount = (uint32)mQueues.size();
+	for (uint32 i = 1; i < queueCount; ++i)
+	{
+		if (mQueues[(threadIndex + i) % queueCount]->steal(job))
+		{
+			mQueuedJobs.fetch_sub(1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::execute(Job& job)
+{
+	job.pFunction(job.pData, job.index);
+	if (job.pCounter)
+		job.pCounter->pending.fetch_sub(1);
+}
+
+void JobSystem::workerLoop(uint32 threadIndex)
+{
+	tlsJobSystem = this;
+	tlsThreadIndex = threadIndex;
+
+	while (!mShutdown.load())
+	{
+		Job job;
+		if (fetchJob(threadIndex, job))
+		{
+			execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mSleepingWorkers.fetch_add(1);
+		mWakeCondition.wait(lock, [this] { return mShutdown.load() || mQueuedJobs.load() != 0; });
+		mSleepingWorkers.fetch_sub(1);
+	}
+}
+
+uint32 JobSystem::currentThreadIndex() const
+{
+	return tlsJobSystem == this ? tlsThreadIndex : 0;
+}
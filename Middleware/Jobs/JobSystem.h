@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef unsigned int uint32;
+
+#define JOB_QUEUE_CAPACITY 4096
+
+typedef void (*JobFunction)(void* pData, uint32 index);
+
+// Tracks a group of jobs, Wait() on it returns once every job of the group finished.
+struct JobCounter
+{
+	JobCounter() : pending(0) {}
+	std::atomic<uint32> pending;
+};
+
+struct Job
+{
+	JobFunction pFunction;
+	void*		pData;
+	uint32		index;
+	JobCounter* pCounter;
+};
+
+// Work stealing job system.
+// Every thread owns a deque, it pushes and pops its own jobs at the back and
+// idle threads steal from the front of the others. The thread that created the
+// JobSystem owns queue 0 and runs jobs whenever it waits on a counter.
+class JobSystem
+{
+public:
+	// threadCount includes the calling thread, 0 uses every hardware thread
+	JobSystem(uint32 threadCount = 0);
+	~JobSystem();
+
+	void Run(JobFunction pFunction, void* pData, uint32 index, JobCounter* pCounter);
+
+	// Runs pending jobs until the counter drops to zero.
+	void Wait(JobCounter* pCounter);
+
+	// func(uint32 first, uint32 last) over [begin, end) split into grainSize chunks, returns when all chunks ran
+	template <typename Func>
+	void ParallelFor(uint32 begin, uint32 end, uint32 grainSize, Func func)
+	{
+		if (end <= begin)
+			return;
+		if (grainSize == 0)
+			grainSize = 1;
+
+		struct ForData
+		{
+			Func* pFunc;
+			uint32 begin, end, grainSize;
+		};
+		ForData data = { &func, begin, end, grainSize };
+
+		JobFunction chunk = [](void* pData, uint32 index)
+		{
+			ForData* pFor = (ForData*)pData;
+			uint32 first = pFor->begin + index * pFor->grainSize;
+			uint32 last = first + pFor->grainSize < pFor->end ? first + pFor->grainSize : pFor->end;
+			(*pFor->pFunc)(first, last);
+		};
+
+		uint32 chunkCount = (end - begin + grainSize - 1) / grainSize;
+		JobCounter counter;
+		counter.pending.store(chunkCount);
+		for (uint32 i = 0; i < chunkCount; ++i)
+		{
+			Job job = { chunk, &data, i, &counter };
+			submit(job);
+		}
+		wake(chunkCount);
+
+		Wait(&counter);
+	}
+
+	// Pops and runs one job on the calling thread, false if there was nothing to do.
+	bool RunPendingJob();
+
+	uint32 threadCount() const { return (uint32)mQueues.size(); }
+
+	// [0, threadCount()) on threads of this job system, 0 anywhere else
+	uint32 currentThreadIndex() const;
+
+private:
+	class JobQueue
+	{
+	public:
+		JobQueue() : mHead(0), mTail(0) { mLock.clear(); }
+
+		bool push(const Job& job);
+		bool pop(Job& job);
+		bool steal(Job& job);
+
+	private:
+		void lock()   { while (mLock.test_and_set(std::memory_order_acquire)) { std::this_thread::yield(); } }
+		void unlock() { mLock.clear(std::memory_order_release); }
+
+		Job mJobs[JOB_QUEUE_CAPACITY];
+		uint32 mHead;
+		uint32 mTail;
+		std::atomic_flag mLock;
+	};
+
+	void submit(const Job& job);
+	void wake(uint32 jobCount);
+	bool fetchJob(uint32 threadIndex, Job& job);
+	void execute(Job& job);
+	void workerLoop(uint32 threadIndex);
+
+	std::vector<JobQueue*>	 mQueues;
+	std::vector<std::thread> mWorkers;
+
+	std::atomic<uint32>		mQueuedJobs;
+	std::atomic<uint32>		mSleepingWorkers;
+	std::mutex				mSleepMutex;
+	std::condition_variable mWakeCondition;
+	std::atomic<bool>		mShutdown;
+};
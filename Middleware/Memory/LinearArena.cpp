@@ -0,0 +1,74 @@
+#include "LinearArena.h"
+
+#include <assert.h>
+
+#define LINEAR_ARENA_ALIGNMENT 64
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+LinearArena::LinearArena(size_t capacity) : mpBuffer(nullptr), mCapacity(capacity), mOffset(0), mpOverflow(nullptr), mOverflowBytes(0)
+{
+	mpBuffer = (char*)alignedAlloc(mCapacity, LINEAR_ARENA_ALIGNMENT);
+	assert(mpBuffer);
+	mStats.bytesReserved = mCapacity;
+}
+
+LinearArena::~LinearArena()
+{
+	reset();
+	alignedFree(mpBuffer);
+}
+
+void* LinearArena::allocate(size_t size, size_t alignment)
+{
+	assert(alignment <= LINEAR_ARENA_ALIGNMENT && (alignment & (alignment - 1)) == 0);
+
+	size_t offset = alignUp(mOffset, alignment);
+	if (offset + size <= mCapacity)
+	{
+		mOffset = offset + size;
+		mStats.onAllocate(size);
+		return mpBuffer + offset;
+	}
+
+	// does not fit, hand out a dedicated block for the rest of the frame
+	size_t header = alignUp(sizeof(OverflowBlock), LINEAR_ARENA_ALIGNMENT);
+	OverflowBlock* pBlock = (OverflowBlock*)alignedAlloc(header + size, LINEAR_ARENA_ALIGNMENT);
+	assert(pBlock);
+	pBlock->pNext = mpOverflow;
+	pBlock->size = size;
+	mpOverflow = pBlock;
+	mOverflowBytes += size;
+	mStats.bytesReserved += header + size;
+	mStats.onAllocate(size);
+	return (char*)pBlock + header;
+}
+
+void LinearArena::reset()
+{
+	size_t header = alignUp(sizeof(OverflowBlock), LINEAR_ARENA_ALIGNMENT);
+	while (mpOverflow)
+	{
+		OverflowBlock* pNext = mpOverflow->pNext;
+		mStats.bytesReserved -= header + mpOverflow->size;
+		alignedFree(mpOverflow);
+		mpOverflow = pNext;
+	}
+
+	if (mOverflowBytes)
+	{
+		alignedFree(mpBuffer);
+		mCapacity = alignUp(mCapacity + mOverflowBytes, LINEAR_ARENA_ALIGNMENT);
+		mpBuffer = (char*)alignedAlloc(mCapacity, LINEAR_ARENA_ALIGNMENT);
+		assert(mpBuffer);
+		mStats.bytesReserved = mCapacity;
+		mOverflowBytes = 0;
+	}
+
+	mOffset = 0;
+	mStats.bytesLive = 0;
+	mStats.endFrame();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Memory.h"
+
+#include <new>
+
+#define LINEAR_ARENA_DEFAULT_CAPACITY (1024 * 1024)
+
+// Bump allocator for transient data that only lives until the next reset(),
+// e.g. per frame scratch buffers. Nothing is freed individually and no
+// destructors run, only use it for trivially destructible data.
+// When a frame overflows, the extra memory comes from overflow blocks and the
+// next reset() grows the arena so the following frames fit in one block.
+class LinearArena
+{
+public:
+	LinearArena(size_t capacity = LINEAR_ARENA_DEFAULT_CAPACITY);
+	~LinearArena();
+
+	void* allocate(size_t size, size_t alignment = 16);
+
+	template <typename T>
+	T* allocateArray(uint32 count)
+	{
+		T* pArray = (T*)allocate(sizeof(T) * count, alignof(T));
+		for (uint32 i = 0; i < count; ++i)
+		{
+			new(&pArray[i]) T;
+		}
+		return pArray;
+	}
+
+	// drops everything allocated since the last reset
+	void reset();
+
+	size_t capacity() const { return mCapacity; }
+	const AllocatorStats& stats() const { return mStats; }
+
+private:
+	struct OverflowBlock
+	{
+		OverflowBlock* pNext;
+		size_t		   size;
+	};
+
+	char*		   mpBuffer;
+	size_t		   mCapacity;
+	size_t		   mOffset;
+	OverflowBlock* mpOverflow;
+	size_t		   mOverflowBytes;
+	AllocatorStats mStats;
+};
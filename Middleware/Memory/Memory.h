@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+typedef unsigned int uint32;
+
+inline void* alignedAlloc(size_t size, size_t alignment)
+{
+#if defined(_WIN32)
+	return _aligned_malloc(size, alignment);
+#else
+	void* ptr = nullptr;
+	if (posix_memalign(&ptr, alignment, size) != 0)
+		return nullptr;
+	return ptr;
+#endif
+}
+
+inline void alignedFree(void* ptr)
+{
+#if defined(_WIN32)
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+// Counters every allocator keeps, endFrame() rolls the per frame counter over.
+struct AllocatorStats
+{
+	AllocatorStats() : bytesLive(0), highWaterMark(0), bytesReserved(0), allocationsThisFrame(0), allocationsLastFrame(0), totalAllocations(0) {}
+
+	void onAllocate(size_t bytes)
+	{
+		bytesLive += bytes;
+		if (bytesLive > highWaterMark)
+			highWaterMark = bytesLive;
+		++allocationsThisFrame;
+		++totalAllocations;
+	}
+
+	void onFree(size_t bytes)
+	{
+		bytesLive -= bytes;
+	}
+
+	void endFrame()
+	{
+		allocationsLastFrame = allocationsThisFrame;
+		allocationsThisFrame = 0;
+	}
+
+	size_t	 bytesLive;
+	size_t	 highWaterMark;
+	size_t	 bytesReserved;	// backing memory taken from the heap
+	uint32	 allocationsThisFrame;
+	uint32	 allocationsLastFrame;
+	uint64_t totalAllocations;
+};
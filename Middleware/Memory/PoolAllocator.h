@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Memory.h"
+
+#include <assert.h>
+#include <new>
+
+#define POOL_ALLOCATOR_ALIGNMENT 16
+
+// Fixed size blocks of sizeof(T) carved out of chunks of BlocksPerChunk.
+// Freed blocks go on an intrusive free list, chunks are only returned on destruction.
+// allocate() hands out raw memory, construct with placement new.
+template <typename T, uint32 BlocksPerChunk = 64>
+class PoolAllocator
+{
+public:
+	// pStats lets several pools report into one set of counters, NULL uses the pool's own
+	PoolAllocator(AllocatorStats* pStats = nullptr) : mpChunks(nullptr), mpFreeList(nullptr), mpStats(pStats ? pStats : &mStats) {}
+
+	~PoolAllocator()
+	{
+		while (mpChunks)
+		{
+			Chunk* pNext = mpChunks->pNext;
+			alignedFree(mpChunks);
+			mpChunks = pNext;
+		}
+	}
+
+	void* allocate()
+	{
+		if (!mpFreeList)
+			addChunk();
+
+		Block* pBlock = mpFreeList;
+		mpFreeList = pBlock->pNext;
+		mpStats->onAllocate(sizeof(T));
+		return pBlock;
+	}
+
+	void deallocate(void* ptr)
+	{
+		if (!ptr)
+			return;
+
+		Block* pBlock = (Block*)ptr;
+		pBlock->pNext = mpFreeList;
+		mpFreeList = pBlock;
+		mpStats->onFree(sizeof(T));
+	}
+
+	const AllocatorStats& stats() const { return *mpStats; }
+	AllocatorStats& stats() { return *mpStats; }
+
+private:
+	union Block
+	{
+		Block* pNext;
+		alignas(POOL_ALLOCATOR_ALIGNMENT) char storage[sizeof(T)];
+	};
+
+	struct Chunk
+	{
+		Chunk* pNext;
+		Block  blocks[BlocksPerChunk];
+	};
+
+	void addChunk()
+	{
+		static_assert(alignof(T) <= POOL_ALLOCATOR_ALIGNMENT, "PoolAllocator: over aligned type");
+
+		Chunk* pChunk = (Chunk*)alignedAlloc(sizeof(Chunk), POOL_ALLOCATOR_ALIGNMENT);
+		assert(pChunk);
+		pChunk->pNext = mpChunks;
+		mpChunks = pChunk;
+
+		for (uint32 i = 0; i < BlocksPerChunk; ++i)
+		{
+			pChunk->blocks[i].pNext = i + 1 < BlocksPerChunk ? &pChunk->blocks[i + 1] : mpFreeList;
+		}
+		mpFreeList = &pChunk->blocks[0];
+		mpStats->bytesReserved += sizeof(Chunk);
+	}
+
+	Chunk*		   mpChunks;
+	Block*		   mpFreeList;
+	AllocatorStats mStats;
+	AllocatorStats* mpStats;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <chrono>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// wall time since start, as a double so sub millisecond timings survive
+inline double elapsedMs(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+
+#define ECS_STORAGE_BENCHMARK 0
+#define ECS_ENTITY_CHURN_BENCHMARK 0
+#define JOB_SYSTEM_BENCHMARK 0
+#define ECS_GET_COMPONENT_BENCHMARK 0
+#define ECS_SNAPSHOT_BENCHMARK 0
+
+void RunECSStorageBenchmark();
+void RunEntityChurnBenchmark();
+void RunJobSystemBenchmark();
+void RunGetComponentBenchmark();
+void RunSnapshotBenchmark();
@@ -0,0 +1,290 @@
+#include "Benchmarks.h"
+
+#include "PositionComponent.h"
+#include "../../../Middleware/ECS/EntityManager.h"
+#include "../../../Middleware/ECS/Snapshot.h"
+#include "../../../Middleware/Profiling/Timer.h"
+
+#include <TINYSTL/hash.h>
+
+#include <algorithm>
+#include <list>
+#include <random>
+#include <stdio.h>
+
+#if ECS_STORAGE_BENCHMARK
+
+static const uint32 STORAGE_BENCHMARK_COMPONENTS = 100000;
+static const uint32 STORAGE_BENCHMARK_PASSES	 = 100;
+
+// Compares iterating heap allocated components threaded through a std::list
+// (the old mComponentPoolMap layout) against the packed ComponentPool.
+void RunECSStorageBenchmark()
+{
+	std::list<Component*> listPool;
+	EntityManager manager;
+
+	for (uint32 i = 0; i < STORAGE_BENCHMARK_COMPONENTS; ++i)
+	{
+		PositionComponent* pListComp = new PositionComponent;
+		pListComp->x = (int)i;
+		pListComp->y = 1;
+		listPool.push_front(pListComp);
+
+		EntityID id = manager.createEntity();
+		manager.addComponent<PositionComponent>(id);
+		PositionComponent* pPoolComp = manager.getComponent<PositionComponent>(id);
+		pPoolComp->x = (int)i;
+		pPoolComp->y = 1;
+	}
+
+	long long listSum = 0;
+	Clock::time_point start = Clock::now();
+	for (uint32 pass = 0; pass < STORAGE_BENCHMARK_PASSES; ++pass)
+	{
+		for (std::list<Component*>::iterator it = listPool.begin(); it != listPool.end(); ++it)
+		{
+			PositionComponent* pPosition = static_cast<PositionComponent*>(*it);
+			pPosition->x += pPosition->y;
+			listSum += pPosition->x;
+		}
+	}
+	double listMs = elapsedMs(start);
+
+	long long poolSum = 0;
+	ComponentPool<PositionComponent>* pPool = manager.getPool<PositionComponent>();
+	start = Clock::now();
+	for (uint32 pass = 0; pass < STORAGE_BENCHMARK_PASSES; ++pass)
+	{
+		for (PositionComponent& position : *pPool)
+		{
+			position.x += position.y;
+			poolSum += position.x;
+		}
+	}
+	double poolMs = elapsedMs(start);
+
+	double visited = (double)STORAGE_BENCHMARK_COMPONENTS * STORAGE_BENCHMARK_PASSES;
+	printf("ECS STORAGE: %u components, %u passes\n", STORAGE_BENCHMARK_COMPONENTS, STORAGE_BENCHMARK_PASSES);
+	printf("  list pool   : %8.3f ms  %8.2f M components/s\n", listMs, visited / (listMs * 1000.0));
+	printf("  packed pool : %8.3f ms  %8.2f M components/s\n", poolMs, visited / (poolMs * 1000.0));
+	printf("  speedup     : %8.2fx (checksum %s)\n", listMs / poolMs, listSum == poolSum ? "ok" : "MISMATCH");
+
+	for (std::list<Component*>::iterator it = listPool.begin(); it != listPool.end(); ++it)
+	{
+		delete *it;
+	}
+}
+
+#endif
+
+#if ECS_ENTITY_CHURN_BENCHMARK
+
+static const uint32 CHURN_BENCHMARK_BATCH  = 10000;
+static const uint32 CHURN_BENCHMARK_ROUNDS = 500;
+
+// Spawns and destroys batches of entities, with and without a component,
+// and checks that recycled slots keep the slot map from growing and that no
+// stale ID resolves again, not even once a slot ran through every generation.
+void RunEntityChurnBenchmark()
+{
+	EntityManager manager;
+	tinystl::vector<EntityID> ids(CHURN_BENCHMARK_BATCH);
+
+	Clock::time_point start = Clock::now();
+	for (uint32 round = 0; round < CHURN_BENCHMARK_ROUNDS; ++round)
+	{
+		for (uint32 i = 0; i < CHURN_BENCHMARK_BATCH; ++i)
+		{
+			ids[i] = manager.createEntity();
+		}
+		for (uint32 i = 0; i < CHURN_BENCHMARK_BATCH; ++i)
+		{
+			manager.destroyEntity(ids[i]);
+		}
+	}
+	double bareMs = elapsedMs(start);
+
+	EntityID staleID = ids[0];
+
+	start = Clock::now();
+	for (uint32 round = 0; round < CHURN_BENCHMARK_ROUNDS; ++round)
+	{
+		for (uint32 i = 0; i < CHURN_BENCHMARK_BATCH; ++i)
+		{
+			ids[i] = manager.createEntity();
+			manager.addComponent<PositionComponent>(ids[i]);
+		}
+		// even then odd, so pools swap-remove from the middle and not only the back
+		for (uint32 i = 0; i < CHURN_BENCHMARK_BATCH; i += 2)
+		{
+			manager.destroyEntity(ids[i]);
+		}
+		for (uint32 i = 1; i < CHURN_BENCHMARK_BATCH; i += 2)
+		{
+			manager.destroyEntity(ids[i]);
+		}
+	}
+	double componentMs = elapsedMs(start);
+
+	// one entity churned through every generation twice over, its first ID must never come back
+	EntityManager wrapManager;
+	EntityID firstID = wrapManager.createEntity();
+	wrapManager.destroyEntity(firstID);
+	const uint32 WrapCycles = 2 * (ENTITY_GENERATION_MASK + 1);
+	uint32 revived = 0;
+	for (uint32 i = 0; i < WrapCycles; ++i)
+	{
+		EntityID id = wrapManager.createEntity();
+		if (wrapManager.isAlive(firstID))
+			++revived;
+		wrapManager.destroyEntity(id);
+	}
+
+	double operations = 2.0 * CHURN_BENCHMARK_BATCH * CHURN_BENCHMARK_ROUNDS;
+	printf("ECS ENTITY CHURN: %u entities x %u rounds\n", CHURN_BENCHMARK_BATCH, CHURN_BENCHMARK_ROUNDS);
+	printf("  create/destroy             : %8.3f ms  %8.2f M ops/s\n", bareMs, operations / (bareMs * 1000.0));
+	printf("  create/add/destroy         : %8.3f ms  %8.2f M ops/s\n", componentMs, operations / (componentMs * 1000.0));
+	printf("  slots allocated            : %8u (live %u)\n", manager.slotCount(), manager.entityCount());
+	printf("  stale ID rejected          : %8s\n", manager.getEntityByID(staleID) ? "NO" : "yes");
+	printf("  wrapped ID rejected        : %8s (%u cycles, %u slots)\n", revived ? "NO" : "yes", WrapCycles, wrapManager.slotCount());
+
+	EntityManagerMemoryStats memoryStats = manager.memoryStats();
+	printf("  entity memory              : %8u KB live, %u KB peak, %u KB reserved\n", (uint32)(memoryStats.entities.bytesLive / 1024), (uint32)(memoryStats.entities.highWaterMark / 1024), (uint32)(memoryStats.entities.bytesReserved / 1024));
+	printf("  component memory           : %8u KB live, %u KB peak, %u KB reserved\n", (uint32)(memoryStats.components.bytesLive / 1024), (uint32)(memoryStats.components.highWaterMark / 1024), (uint32)(memoryStats.components.bytesReserved / 1024));
+}
+
+#endif
+
+
+#if ECS_GET_COMPONENT_BENCHMARK
+
+static const uint32 GET_COMPONENT_BENCHMARK_ENTITIES = 100000;
+static const uint32 GET_COMPONENT_BENCHMARK_PASSES	 = 100;
+
+// GetComponent<T> latency in random entity order. "hashed" replays the old lookup,
+// a hash map probe keyed on tinystl::hash of the type name, "indexed" is the
+// dense type ID lookup the EntityManager does now.
+void RunGetComponentBenchmark()
+{
+	EntityManager manager;
+	tinystl::vector<EntityID> ids;
+	for (uint32 i = 0; i < GET_COMPONENT_BENCHMARK_ENTITIES; ++i)
+	{
+		EntityID id = manager.createEntity();
+		manager.addComponent<PositionComponent>(id);
+		manager.getComponent<PositionComponent>(id)->x = (int)i;
+		ids.push_back(id);
+	}
+	std::shuffle(ids.begin(), ids.end(), std::mt19937(1234));
+
+	// the old type ID was hashed once during static init, only the map probe is per lookup
+	const uint32 hashedType = (uint32)tinystl::hash("PositionComponent");
+	tinystl::unordered_map<uint32, ComponentPoolBase*> hashedPools;
+	hashedPools.insert({ hashedType, manager.getPool<PositionComponent>() });
+
+	long long hashedSum = 0;
+	Clock::time_point start = Clock::now();
+	for (uint32 pass = 0; pass < GET_COMPONENT_BENCHMARK_PASSES; ++pass)
+	{
+		for (EntityID id : ids)
+		{
+			tinystl::unordered_map<uint32, ComponentPoolBase*>::iterator itr = hashedPools.find(hashedType);
+			PositionComponent* pPosition = static_cast<ComponentPool<PositionComponent>*>(itr->second)->get(id);
+			hashedSum += pPosition->x;
+		}
+	}
+	double hashedMs = elapsedMs(start);
+
+	long long indexedSum = 0;
+	start = Clock::now();
+	for (uint32 pass = 0; pass < GET_COMPONENT_BENCHMARK_PASSES; ++pass)
+	{
+		for (EntityID id : ids)
+		{
+			indexedSum += manager.getComponent<PositionComponent>(id)->x;
+		}
+	}
+	double indexedMs = elapsedMs(start);
+
+	double lookups = (double)GET_COMPONENT_BENCHMARK_ENTITIES * GET_COMPONENT_BENCHMARK_PASSES;
+	printf("ECS GET COMPONENT: %u entities, %u passes, random order\n", GET_COMPONENT_BENCHMARK_ENTITIES, GET_COMPONENT_BENCHMARK_PASSES);
+	printf("  hashed type  : %8.3f ms  %6.2f ns/lookup\n", hashedMs, hashedMs * 1000000.0 / lookups);
+	printf("  indexed type : %8.3f ms  %6.2f ns/lookup\n", indexedMs, indexedMs * 1000000.0 / lookups);
+	printf("  speedup      : %8.2fx (checksum %s)\n", hashedMs / indexedMs, hashedSum == indexedSum ? "ok" : "MISMATCH");
+}
+
+#endif
+
+#if ECS_SNAPSHOT_BENCHMARK
+
+static const uint32 SNAPSHOT_BENCHMARK_ENTITIES = 50000;
+static const uint32 SNAPSHOT_BENCHMARK_ROUNDS	= 20;
+
+// Saves and restores a scene of SNAPSHOT_BENCHMARK_ENTITIES entities, every third one
+// destroyed so the free list has to survive the round trip, and checks the restored
+// manager against the original.
+void RunSnapshotBenchmark()
+{
+	EntityManager manager;
+	tinystl::vector<EntityID> ids;
+	for (uint32 i = 0; i < SNAPSHOT_BENCHMARK_ENTITIES; ++i)
+	{
+		EntityID id = manager.createEntity();
+		manager.addComponent<PositionComponent>(id);
+		PositionComponent* pPosition = manager.getComponent<PositionComponent>(id);
+		pPosition->x = (int)i;
+		pPosition->y = (int)(i * 7);
+		ids.push_back(id);
+	}
+	for (uint32 i = 0; i < SNAPSHOT_BENCHMARK_ENTITIES; i += 3)
+	{
+		manager.destroyEntity(ids[i]);
+	}
+
+	tinystl::vector<unsigned char> buffer;
+	Clock::time_point start = Clock::now();
+	for (uint32 round = 0; round < SNAPSHOT_BENCHMARK_ROUNDS; ++round)
+	{
+		SceneSnapshot::Write(&manager, buffer);
+	}
+	double writeMs = elapsedMs(start) / SNAPSHOT_BENCHMARK_ROUNDS;
+
+	EntityManager restored;
+	bool readOk = true;
+	start = Clock::now();
+	for (uint32 round = 0; round < SNAPSHOT_BENCHMARK_ROUNDS; ++round)
+	{
+		readOk &= SceneSnapshot::Read(&restored, buffer.data(), buffer.size());
+	}
+	double readMs = elapsedMs(start) / SNAPSHOT_BENCHMARK_ROUNDS;
+
+	bool matches = readOk && restored.entityCount() == manager.entityCount();
+	for (uint32 i = 0; i < SNAPSHOT_BENCHMARK_ENTITIES && matches; ++i)
+	{
+		PositionComponent* pOriginal = manager.getComponent<PositionComponent>(ids[i]);
+		PositionComponent* pRestored = restored.getComponent<PositionComponent>(ids[i]);
+		matches = restored.isAlive(ids[i]) == manager.isAlive(ids[i]) && (pOriginal == nullptr) == (pRestored == nullptr);
+		if (matches && pOriginal)
+			matches = pOriginal->x == pRestored->x && pOriginal->y == pRestored->y;
+	}
+	// both free lists have to hand out the same IDs from here on
+	matches &= manager.createEntity() == restored.createEntity();
+
+	start = Clock::now();
+	bool fileOk = SceneSnapshot::Save(&manager, "ecs_snapshot.bin");
+	double saveFileMs = elapsedMs(start);
+	start = Clock::now();
+	fileOk &= SceneSnapshot::Load(&restored, "ecs_snapshot.bin");
+	double loadFileMs = elapsedMs(start);
+	remove("ecs_snapshot.bin");
+
+	printf("ECS SNAPSHOT: %u entities (%u alive), %u KB\n", SNAPSHOT_BENCHMARK_ENTITIES, manager.entityCount(), (uint32)(buffer.size() / 1024));
+	printf("  write to memory  : %8.3f ms\n", writeMs);
+	printf("  read from memory : %8.3f ms\n", readMs);
+	printf("  save file        : %8.3f ms\n", saveFileMs);
+	printf("  load file        : %8.3f ms\n", loadFileMs);
+	printf("  round trip       : %8s\n", matches && fileOk ? "ok" : "MISMATCH");
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "Benchmarks.h"
+
+#include "../../../Middleware/Jobs/JobSystem.h"
+#include "../../../Middleware/Profiling/Timer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#if JOB_SYSTEM_BENCHMARK
+
+static const uint32 JOB_OVERHEAD_JOBS	 = 1000000;
+static const uint32 JOB_OVERHEAD_BATCH	 = 1024;
+static const uint32 JOB_SCALING_ELEMENTS = 1 << 20;
+static const uint32 JOB_SCALING_GRAIN	 = 4096;
+static const uint32 JOB_SCALING_PASSES	 = 5;
+
+static void emptyJob(void*, uint32)
+{
+}
+
+// enough math per element that the loop is compute bound and not memory bound
+static float scalingWork(float x)
+{
+	for (int i = 0; i < 32; ++i)
+	{
+		x = sqrtf(x * x + 1.0f) * 0.5f;
+	}
+	return x;
+}
+
+// Measures the cost of pushing, fetching and retiring an empty job, and how a
+// compute bound ParallelFor scales from one thread to every hardware thread.
+void RunJobSystemBenchmark()
+{
+	uint32 hardwareThreads = std::thread::hardware_concurrency();
+	if (hardwareThreads == 0)
+		hardwareThreads = 1;
+
+	printf("JOB SYSTEM: %u hardware threads\n", hardwareThreads);
+
+	{
+		JobSystem jobSystem;
+		JobCounter counter;
+		Clock::time_point start = Clock::now();
+		for (uint32 i = 0; i < JOB_OVERHEAD_JOBS; i += JOB_OVERHEAD_BATCH)
+		{
+			for (uint32 j = 0; j < JOB_OVERHEAD_BATCH; ++j)
+			{
+				jobSystem.Run(emptyJob, nullptr, j, &counter);
+			}
+			jobSystem.Wait(&counter);
+		}
+		double overheadMs = elapsedMs(start);
+		printf("  empty job overhead  : %8.1f ns/job (%u jobs, batches of %u)\n", overheadMs * 1000000.0 / JOB_OVERHEAD_JOBS, JOB_OVERHEAD_JOBS, JOB_OVERHEAD_BATCH);
+	}
+
+	std::vector<float> values(JOB_SCALING_ELEMENTS);
+	double singleThreadMs = 0.0;
+	for (uint32 threads = 1; threads <= hardwareThreads; threads *= 2)
+	{
+		for (uint32 i = 0; i < JOB_SCALING_ELEMENTS; ++i)
+		{
+			values[i] = (float)i;
+		}
+
+		JobSystem jobSystem(threads);
+		float* pValues = values.data();
+		Clock::time_point start = Clock::now();
+		for (uint32 pass = 0; pass < JOB_SCALING_PASSES; ++pass)
+		{
+			jobSystem.ParallelFor(0, JOB_SCALING_ELEMENTS, JOB_SCALING_GRAIN, [pValues](uint32 first, uint32 last)
+			{
+				for (uint32 i = first; i < last; ++i)
+				{
+					pValues[i] = scalingWork(pValues[i]);
+				}
+			});
+		}
+		double ms = elapsedMs(start);
+		if (threads == 1)
+			singleThreadMs = ms;
+
+		printf("  parallel for %2u thr : %8.3f ms  speedup %5.2fx  efficiency %5.1f%%\n", threads, ms, singleThreadMs / ms, 100.0 * singleThreadMs / (ms * threads));
+
+		// also cover odd counts such as 6 or 12 hardware threads
+		if (threads < hardwareThreads && threads * 2 > hardwareThreads)
+			threads = hardwareThreads / 2;
+	}
+}
+
+#endif
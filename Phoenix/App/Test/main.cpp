@@ -1,5 +1,6 @@
 #include <iostream>
 #include "PositionComponent.h"
+#include "Benchmarks.h"
 #include "../../../Middleware/ECS/EntityManager.h"
 
 // I am Stud Shingala Fenil..
@@ -21,6 +22,22 @@ int main()
 		}
 		position->destroyRepresentation(rep);
 	}
+
+#if ECS_STORAGE_BENCHMARK
+	RunECSStorageBenchmark();
+#endif
+#if ECS_ENTITY_CHURN_BENCHMARK
+	RunEntityChurnBenchmark();
+#endif
+#if JOB_SYSTEM_BENCHMARK
+	RunJobSystemBenchmark();
+#endif
+#if ECS_GET_COMPONENT_BENCHMARK
+	RunGetComponentBenchmark();
+#endif
+#if ECS_SNAPSHOT_BENCHMARK
+	RunSnapshotBenchmark();
+#endif
 	
 	getchar();
 	return 0;
@@ -0,0 +1,64 @@
+#include "AnimationBatch.h"
+
+AnimationBatch::AnimationBatch(JobSystem* pJobSystem) : mpJobSystem(pJobSystem), mThreadScratch(pJobSystem->threadCount())
+{
+}
+
+void AnimationBatch::Evaluate(const AnimationSet& set, const AnimationInstance* pInstances, AnimationPose* pPoses, uint32_t count)
+{
+	// sized up front, the jobs only ever touch their own thread's scratch
+	const uint32_t NodeCount = set.GetSkeleton().NodeCount();
+	for (PoseScratch& scratch : mThreadScratch)
+	{
+		if (scratch.globals.size() < NodeCount)
+			scratch.globals.resize(NodeCount);
+	}
+
+	JobSystem* pJobSystem = mpJobSystem;
+	std::vector<PoseScratch>& threadScratch = mThreadScratch;
+	mpJobSystem->ParallelFor(0, count, ANIMATION_BATCH_GRAIN, [&set, pInstances, pPoses, pJobSystem, &threadScratch](uint32 first, uint32 last)
+	{
+		aiMatrix4x4* pGlobals = threadScratch[pJobSystem->currentThreadIndex()].globals.data();
+		for (uint32 i = first; i < last; ++i)
+		{
+			set.EvaluatePose(pInstances[i], pPoses[i], pGlobals);
+		}
+	});
+}
+
+void AnimationBatch::Evaluate(const AnimationSet& set, const AnimationLod& lod, const uint32_t* pLods, uint32_t frame, const AnimationInstance* pInstances, AnimationPose* pPoses, uint32_t count)
+{
+	const uint32_t NodeCount = set.GetSkeleton().NodeCount();
+	for (PoseScratch& scratch : mThreadScratch)
+	{
+		if (scratch.globals.size() < NodeCount)
+			scratch.globals.resize(NodeCount);
+	}
+
+	JobSystem* pJobSystem = mpJobSystem;
+	std::vector<PoseScratch>& threadScratch = mThreadScratch;
+	mpJobSystem->ParallelFor(0, count, ANIMATION_BATCH_GRAIN, [&set, &lod, pLods, frame, pInstances, pPoses, pJobSystem, &threadScratch](uint32 first, uint32 last)
+	{
+		aiMatrix4x4* pGlobals = threadScratch[pJobSystem->currentThreadIndex()].globals.data();
+		for (uint32 i = first; i < last; ++i)
+		{
+			if (lod.ShouldUpdate(pLods[i], frame, i) || pPoses[i].skinning.empty())
+				set.EvaluatePose(pInstances[i], pPoses[i], pGlobals, lod.mSkipHeight[pLods[i]]);
+		}
+	});
+}
+
+void AnimationBatch::Evaluate(const AnimationSet& set, const AnimationLayer* pLayers, uint32_t layersPerInstance, AnimationPose* pPoses, uint32_t count)
+{
+	// the scratch poses grow on first use, each only ever by the thread that owns it
+	JobSystem* pJobSystem = mpJobSystem;
+	std::vector<PoseScratch>& threadScratch = mThreadScratch;
+	mpJobSystem->ParallelFor(0, count, ANIMATION_BATCH_GRAIN, [&set, pLayers, layersPerInstance, pPoses, pJobSystem, &threadScratch](uint32 first, uint32 last)
+	{
+		PoseScratch& scratch = threadScratch[pJobSystem->currentThreadIndex()];
+		for (uint32 i = first; i < last; ++i)
+		{
+			set.EvaluateLayers(pLayers + (size_t)i * layersPerInstance, layersPerInstance, pPoses[i], scratch);
+		}
+	});
+}
\ No newline at end of file
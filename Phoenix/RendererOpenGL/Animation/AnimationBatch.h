@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include "AnimationLod.h"
+#include "AnimationSet.h"
+#include "../../../Middleware/Jobs/JobSystem.h"
+
+// instances per job
+#define ANIMATION_BATCH_GRAIN 16
+
+// Evaluates many instances of one AnimationSet across the job system's threads.
+// Every thread gets its own node scratch, poses are written by exactly one job.
+class AnimationBatch
+{
+public:
+	AnimationBatch(JobSystem* pJobSystem);
+
+	// returns once every pose is written
+	void Evaluate(const AnimationSet& set, const AnimationInstance* pInstances, AnimationPose* pPoses, uint32_t count);
+
+	// pLods holds each instance's level from AnimationLod::Select. Instances not due for an
+	// update this frame keep their previous pose, a pose that was never written is always evaluated.
+	void Evaluate(const AnimationSet& set, const AnimationLod& lod, const uint32_t* pLods, uint32_t frame, const AnimationInstance* pInstances, AnimationPose* pPoses, uint32_t count);
+
+	// layered instances, pLayers holds layersPerInstance layers for every pose
+	void Evaluate(const AnimationSet& set, const AnimationLayer* pLayers, uint32_t layersPerInstance, AnimationPose* pPoses, uint32_t count);
+
+private:
+	JobSystem* mpJobSystem;
+	std::vector<PoseScratch> mThreadScratch; // indexed by job system thread
+};
\ No newline at end of file
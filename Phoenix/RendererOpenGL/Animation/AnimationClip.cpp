@@ -0,0 +1,600 @@
+#include "AnimationClip.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <xmmintrin.h>
+
+#include "../../../Common/Renderer/CookedMesh.h"
+
+// Walks a key array forward while the sample time grows, so resampling a channel is linear in its keys.
+template <typename Key>
+static uint32_t advanceKey(const Key* pKeys, uint32_t numKeys, uint32_t index, float time)
+{
+	while (index + 2 < numKeys && time >= (float)pKeys[index + 1].mTime)
+	{
+		++index;
+	}
+	return index;
+}
+
+template <typename Key>
+static float keyFactor(const Key* pKeys, uint32_t index, float time)
+{
+	float DeltaTime = (float)(pKeys[index + 1].mTime - pKeys[index].mTime);
+	float Factor = DeltaTime > 0.0f ? (time - (float)pKeys[index].mTime) / DeltaTime : 0.0f;
+	return Factor < 0.0f ? 0.0f : (Factor > 1.0f ? 1.0f : Factor);
+}
+
+template <typename Key>
+static void updateMinDelta(const Key* pKeys, uint32_t numKeys, float& minDelta)
+{
+	for (uint32_t i = 0; i + 1 < numKeys; i++)
+	{
+		float delta = (float)(pKeys[i + 1].mTime - pKeys[i].mTime);
+		if (delta > 1e-4f && delta < minDelta)
+			minDelta = delta;
+	}
+}
+
+AnimationClip::AnimationClip() : mChannelCount(0), mSampleCount(0), mDuration(0.0f), mTicksPerSecond(25.0f), mInvSampleInterval(0.0f), mFrameSize(0)
+{
+}
+
+void AnimationClip::Build(const aiAnimation* pAnimation)
+{
+	mName = pAnimation->mName.data;
+	mChannelCount = pAnimation->mNumChannels;
+	mDuration = (float)pAnimation->mDuration;
+	mTicksPerSecond = (float)(pAnimation->mTicksPerSecond != 0 ? pAnimation->mTicksPerSecond : 25.0f);
+
+	// the grid follows the densest channel so clips authored at a fixed frame rate
+	// land exactly on their keys, but never goes finer than the max sample rate
+	float minDelta = mDuration;
+	for (uint32_t c = 0; c < mChannelCount; c++)
+	{
+		const aiNodeAnim* pNodeAnim = pAnimation->mChannels[c];
+		updateMinDelta(pNodeAnim->mPositionKeys, pNodeAnim->mNumPositionKeys, minDelta);
+		updateMinDelta(pNodeAnim->mRotationKeys, pNodeAnim->mNumRotationKeys, minDelta);
+		updateMinDelta(pNodeAnim->mScalingKeys, pNodeAnim->mNumScalingKeys, minDelta);
+	}
+
+	float interval = mTicksPerSecond / ANIMATION_CLIP_MAX_SAMPLE_RATE;
+	if (minDelta > interval)
+		interval = minDelta;
+
+	mSampleCount = 1;
+	if (mDuration > 0.0f && interval > 0.0f)
+	{
+		float intervals = ceilf(mDuration / interval - 1e-3f);
+		mSampleCount = intervals + 1.0f < (float)ANIMATION_CLIP_MAX_SAMPLES ? (uint32_t)intervals + 1 : ANIMATION_CLIP_MAX_SAMPLES;
+	}
+	mInvSampleInterval = mSampleCount > 1 ? (mSampleCount - 1) / mDuration : 0.0f;
+
+	mTracks.clear();
+	mCompressed.clear();
+	mConstants.clear();
+	mFrameSize = 0;
+
+	mChannelNames.resize(mChannelCount);
+	mSamples.resize((size_t)mSampleCount * STREAM_COUNT * mChannelCount);
+
+	const uint32_t n = mChannelCount;
+	for (uint32_t c = 0; c < n; c++)
+	{
+		const aiNodeAnim* pNodeAnim = pAnimation->mChannels[c];
+		mChannelNames[c] = pNodeAnim->mNodeName.data;
+
+		assert(pNodeAnim->mNumPositionKeys > 0 && pNodeAnim->mNumRotationKeys > 0 && pNodeAnim->mNumScalingKeys > 0);
+
+		uint32_t PositionIndex = 0, RotationIndex = 0, ScalingIndex = 0;
+		aiQuaternion Previous;
+		for (uint32_t s = 0; s < mSampleCount; s++)
+		{
+			float time = mSampleCount > 1 ? mDuration * s / (mSampleCount - 1) : 0.0f;
+			float* pFrame = &mSamples[(size_t)s * STREAM_COUNT * n];
+
+			aiVector3D Translation = pNodeAnim->mPositionKeys[0].mValue;
+			if (pNodeAnim->mNumPositionKeys > 1)
+			{
+				PositionIndex = advanceKey(pNodeAnim->mPositionKeys, pNodeAnim->mNumPositionKeys, PositionIndex, time);
+				const aiVector3D& Start = pNodeAnim->mPositionKeys[PositionIndex].mValue;
+				const aiVector3D& End = pNodeAnim->mPositionKeys[PositionIndex + 1].mValue;
+				Translation = Start + keyFactor(pNodeAnim->mPositionKeys, PositionIndex, time) * (End - Start);
+			}
+
+			aiQuaternion Rotation = pNodeAnim->mRotationKeys[0].mValue;
+			if (pNodeAnim->mNumRotationKeys > 1)
+			{
+				RotationIndex = advanceKey(pNodeAnim->mRotationKeys, pNodeAnim->mNumRotationKeys, RotationIndex, time);
+				Quaternion Start = pNodeAnim->mRotationKeys[RotationIndex].mValue;
+				Quaternion End = pNodeAnim->mRotationKeys[RotationIndex + 1].mValue;
+				Rotation = Quaternion::interpolate(Start, End, keyFactor(pNodeAnim->mRotationKeys, RotationIndex, time)).toAiQuaternion();
+			}
+			// keep neighbours in the same hemisphere, sampling can then skip the dot product
+			if (s > 0 && Previous.x * Rotation.x + Previous.y * Rotation.y + Previous.z * Rotation.z + Previous.w * Rotation.w < 0.0f)
+			{
+				Rotation = aiQuaternion(-Rotation.w, -Rotation.x, -Rotation.y, -Rotation.z);
+			}
+			Previous = Rotation;
+
+			aiVector3D Scaling = pNodeAnim->mScalingKeys[0].mValue;
+			if (pNodeAnim->mNumScalingKeys > 1)
+			{
+				ScalingIndex = advanceKey(pNodeAnim->mScalingKeys, pNodeAnim->mNumScalingKeys, ScalingIndex, time);
+				const aiVector3D& Start = pNodeAnim->mScalingKeys[ScalingIndex].mValue;
+				const aiVector3D& End = pNodeAnim->mScalingKeys[ScalingIndex + 1].mValue;
+				Scaling = Start + keyFactor(pNodeAnim->mScalingKeys, ScalingIndex, time) * (End - Start);
+			}
+
+			pFrame[TX * n + c] = Translation.x;
+			pFrame[TY * n + c] = Translation.y;
+			pFrame[TZ * n + c] = Translation.z;
+			pFrame[RX * n + c] = Rotation.x;
+			pFrame[RY * n + c] = Rotation.y;
+			pFrame[RZ * n + c] = Rotation.z;
+			pFrame[RW * n + c] = Rotation.w;
+			pFrame[SX * n + c] = Scaling.x;
+			pFrame[SY * n + c] = Scaling.y;
+			pFrame[SZ * n + c] = Scaling.z;
+		}
+	}
+}
+
+ClipCursor AnimationClip::Cursor(float AnimationTime) const
+{
+	ClipCursor cursor = { 0, 0, 0.0f };
+	if (mSampleCount < 2)
+		return cursor;
+
+	float f = AnimationTime * mInvSampleInterval;
+	if (f <= 0.0f)
+		return cursor;
+
+	cursor.frame = (uint32_t)f;
+	if (cursor.frame >= mSampleCount - 1)
+	{
+		cursor.frame = cursor.nextFrame = mSampleCount - 1;
+		return cursor;
+	}
+	cursor.nextFrame = cursor.frame + 1;
+	cursor.alpha = f - (float)cursor.frame;
+	return cursor;
+}
+
+void AnimationClip::SampleChannel(uint32_t channel, const ClipCursor& cursor, aiVector3D& Translation, Quaternion& Rotation, aiVector3D& Scaling) const
+{
+	if (IsCompressed())
+	{
+		float v[STREAM_COUNT];
+		sampleCompressed(channel, cursor, v);
+		Translation = aiVector3D(v[TX], v[TY], v[TZ]);
+		Rotation = Quaternion(v[RX], v[RY], v[RZ], v[RW]);
+		Scaling = aiVector3D(v[SX], v[SY], v[SZ]);
+		return;
+	}
+
+	const uint32_t n = mChannelCount;
+	const float* a = frame(cursor.frame) + channel;
+	const float* b = frame(cursor.nextFrame) + channel;
+	const float t = cursor.alpha;
+
+	Translation.x = a[TX * n] + (b[TX * n] - a[TX * n]) * t;
+	Translation.y = a[TY * n] + (b[TY * n] - a[TY * n]) * t;
+	Translation.z = a[TZ * n] + (b[TZ * n] - a[TZ * n]) * t;
+
+	// the constructor normalizes, which turns the lerp into an nlerp
+	Rotation = Quaternion(a[RX * n] + (b[RX * n] - a[RX * n]) * t,
+						  a[RY * n] + (b[RY * n] - a[RY * n]) * t,
+						  a[RZ * n] + (b[RZ * n] - a[RZ * n]) * t,
+						  a[RW * n] + (b[RW * n] - a[RW * n]) * t);
+
+	Scaling.x = a[SX * n] + (b[SX * n] - a[SX * n]) * t;
+	Scaling.y = a[SY * n] + (b[SY * n] - a[SY * n]) * t;
+	Scaling.z = a[SZ * n] + (b[SZ * n] - a[SZ * n]) * t;
+}
+
+void AnimationClip::SampleStreams(const ClipCursor& cursor, float* pOut) const
+{
+	if (IsCompressed())
+	{
+		const uint32_t n = mChannelCount;
+		for (uint32_t c = 0; c < n; c++)
+		{
+			float v[STREAM_COUNT];
+			sampleCompressed(c, cursor, v);
+			for (uint32_t k = 0; k < STREAM_COUNT; k++)
+				pOut[k * n + c] = v[k];
+		}
+		return;
+	}
+
+	// the streams of a block are contiguous, so the whole block is a single lerp
+	const uint32_t count = STREAM_COUNT * mChannelCount;
+	const float* a = frame(cursor.frame);
+	const float* b = frame(cursor.nextFrame);
+
+	uint32_t i = 0;
+	const __m128 t = _mm_set1_ps(cursor.alpha);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 va = _mm_loadu_ps(a + i);
+		__m128 vb = _mm_loadu_ps(b + i);
+		_mm_storeu_ps(pOut + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), t)));
+	}
+	for (; i < count; i++)
+	{
+		pOut[i] = a[i] + (b[i] - a[i]) * cursor.alpha;
+	}
+}
+
+int32_t AnimationClip::FindChannel(const char* nodeName) const
+{
+	for (uint32_t i = 0; i < mChannelCount; i++)
+	{
+		if (strcmp(mChannelNames[i].c_str(), nodeName) == 0)
+			return (int32_t)i;
+	}
+	return -1;
+}
+
+////////////////////////////////////////////// COMPRESSION
+#define SMALLEST_THREE_RANGE 0.70710678f // no component but the largest can be bigger than 1 / sqrt(2)
+
+static const uint32_t trackStreams[3] = { AnimationClip::TX, AnimationClip::RX, AnimationClip::SX };
+static const uint32_t trackComponents[3] = { 3, 4, 3 };
+
+static uint32_t trackSize(uint32_t track, uint32_t format)
+{
+	// translation and scale, then rotation
+	static const uint32_t vectorSizes[4] = { 0, 3, 6, 12 };
+	static const uint32_t rotationSizes[4] = { 0, 4, 6, 16 };
+	return track == 1 ? rotationSizes[format] : vectorSizes[format];
+}
+
+// scale is the size of one quantization step
+static uint32_t quantize(float value, float origin, float scale, uint32_t maxValue)
+{
+	if (scale <= 0.0f)
+		return 0;
+	float q = (value - origin) / scale + 0.5f;
+	return q <= 0.0f ? 0 : (q >= (float)maxValue ? maxValue : (uint32_t)q);
+}
+
+static inline float dequantize(uint32_t q, float origin, float scale)
+{
+	return origin + scale * (float)q;
+}
+
+// largest component index in the low 2 bits, then the other three with bits each; the largest
+// is made positive, q and -q being the same rotation
+static uint64_t packRotation(const float* q, uint32_t bits)
+{
+	uint32_t largest = 0;
+	for (uint32_t i = 1; i < 4; i++)
+	{
+		if (fabsf(q[i]) > fabsf(q[largest]))
+			largest = i;
+	}
+	float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+	const uint32_t maxValue = (1u << bits) - 1;
+	const float scale = 2.0f * SMALLEST_THREE_RANGE / maxValue;
+	uint64_t packed = largest;
+	uint32_t shift = 2;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		if (i == largest)
+			continue;
+		packed |= (uint64_t)quantize(q[i] * sign, -SMALLEST_THREE_RANGE, scale, maxValue) << shift;
+		shift += bits;
+	}
+	return packed;
+}
+
+static inline void unpackRotation(uint64_t packed, uint32_t bits, float* q)
+{
+	// where the three stored components go for each largest index, no branch on the index
+	static const uint8_t slots[4][3] = { { 1, 2, 3 }, { 0, 2, 3 }, { 0, 1, 3 }, { 0, 1, 2 } };
+
+	const uint32_t maxValue = (1u << bits) - 1;
+	const float scale = 2.0f * SMALLEST_THREE_RANGE / maxValue;
+	const uint32_t largest = (uint32_t)(packed & 3);
+	float a = dequantize((uint32_t)(packed >> 2) & maxValue, -SMALLEST_THREE_RANGE, scale);
+	float b = dequantize((uint32_t)(packed >> (2 + bits)) & maxValue, -SMALLEST_THREE_RANGE, scale);
+	float c = dequantize((uint32_t)(packed >> (2 + 2 * bits)) & maxValue, -SMALLEST_THREE_RANGE, scale);
+	float sum = a * a + b * b + c * c;
+
+	q[slots[largest][0]] = a;
+	q[slots[largest][1]] = b;
+	q[slots[largest][2]] = c;
+	q[largest] = sqrtf(sum < 1.0f ? 1.0f - sum : 0.0f);
+}
+
+static float rotationError(const float* a, const float* b)
+{
+	float d = fabsf(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]);
+	return 2.0f * acosf(d < 1.0f ? d : 1.0f);
+}
+
+static void normalizeRotation(float* q)
+{
+	float length = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	for (uint32_t i = 0; i < 4; i++)
+		q[i] = length > 0.0f ? q[i] / length : (i == 3 ? 1.0f : 0.0f);
+}
+
+// writes one value of a track in the given format, pOut has trackSize() bytes
+static void encodeTrack(uint32_t track, uint32_t format, const float* pValue, const float* origin, const float* scale, uint8_t* pOut)
+{
+	if (track == 1)
+	{
+		uint64_t packed;
+		switch (format)
+		{
+		case 1: packed = packRotation(pValue, 10); memcpy(pOut, &packed, 4); break;
+		case 2: packed = packRotation(pValue, 15); memcpy(pOut, &packed, 6); break;
+		case 3: memcpy(pOut, pValue, 16); break;
+		}
+		return;
+	}
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		switch (format)
+		{
+		case 1: pOut[i] = (uint8_t)quantize(pValue[i], origin[i], scale[i], 0xFF); break;
+		case 2:
+		{
+			uint16_t q = (uint16_t)quantize(pValue[i], origin[i], scale[i], 0xFFFF);
+			memcpy(pOut + i * 2, &q, 2);
+			break;
+		}
+		case 3: memcpy(pOut + i * 4, pValue + i, 4); break;
+		}
+	}
+}
+
+static inline void decodeTrack(uint32_t track, uint32_t format, const uint8_t* pIn, const float* origin, const float* scale, float* pValue)
+{
+	if (track == 1)
+	{
+		uint64_t packed = 0;
+		switch (format)
+		{
+		case 1: memcpy(&packed, pIn, 4); unpackRotation(packed, 10, pValue); break;
+		case 2: memcpy(&packed, pIn, 6); unpackRotation(packed, 15, pValue); break;
+		case 3: memcpy(pValue, pIn, 16); break;
+		}
+		return;
+	}
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		switch (format)
+		{
+		case 1: pValue[i] = dequantize(pIn[i], origin[i], scale[i]); break;
+		case 2:
+		{
+			uint16_t q;
+			memcpy(&q, pIn + i * 2, 2);
+			pValue[i] = dequantize(q, origin[i], scale[i]);
+			break;
+		}
+		case 3: memcpy(pValue + i, pIn + i * 4, 4); break;
+		}
+	}
+}
+
+void AnimationClip::Compress(const ClipCompression& settings)
+{
+	if (IsCompressed() || mChannelCount == 0)
+		return;
+
+	const float tolerances[3] = { settings.translationError, settings.rotationError, settings.scaleError };
+	const uint32_t n = mChannelCount;
+	std::vector<float> values((size_t)mSampleCount * 4);
+
+	// pick the smallest format per track that holds the tolerance on every sample
+	mTracks.resize((size_t)n * 3);
+	mFrameSize = 0;
+	for (uint32_t c = 0; c < n; c++)
+	{
+		for (uint32_t t = 0; t < 3; t++)
+		{
+			const uint32_t components = trackComponents[t];
+			for (uint32_t f = 0; f < mSampleCount; f++)
+			{
+				for (uint32_t k = 0; k < components; k++)
+					values[(size_t)f * 4 + k] = frame(f)[(trackStreams[t] + k) * n + c];
+				if (t == 1)
+					normalizeRotation(&values[(size_t)f * 4]);
+			}
+
+			Track& track = mTracks[(size_t)c * 3 + t];
+			float extent[3];
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				float lo = values[k], hi = values[k];
+				for (uint32_t f = 1; f < mSampleCount; f++)
+				{
+					lo = values[(size_t)f * 4 + k] < lo ? values[(size_t)f * 4 + k] : lo;
+					hi = values[(size_t)f * 4 + k] > hi ? values[(size_t)f * 4 + k] : hi;
+				}
+				track.origin[k] = lo;
+				extent[k] = hi - lo;
+			}
+
+			for (track.format = TRACK_CONSTANT; track.format < TRACK_FLOAT; track.format++)
+			{
+				const float maxValue = track.format == TRACK_SMALL ? 255.0f : 65535.0f;
+				for (uint32_t k = 0; k < 3; k++)
+					track.scale[k] = extent[k] / maxValue;
+
+				float maxError = 0.0f;
+				for (uint32_t f = 0; f < mSampleCount && maxError <= tolerances[t]; f++)
+				{
+					const float* pValue = &values[(size_t)f * 4];
+					float decoded[4];
+					if (track.format == TRACK_CONSTANT)
+					{
+						memcpy(decoded, &values[0], sizeof(decoded));
+					}
+					else
+					{
+						uint8_t encoded[16];
+						encodeTrack(t, track.format, pValue, track.origin, track.scale, encoded);
+						decodeTrack(t, track.format, encoded, track.origin, track.scale, decoded);
+					}
+
+					if (t == 1)
+					{
+						float error = rotationError(pValue, decoded);
+						maxError = error > maxError ? error : maxError;
+					}
+					else
+					{
+						for (uint32_t k = 0; k < 3; k++)
+							maxError = fabsf(pValue[k] - decoded[k]) > maxError ? fabsf(pValue[k] - decoded[k]) : maxError;
+					}
+				}
+				if (maxError <= tolerances[t])
+					break;
+			}
+
+			if (track.format == TRACK_CONSTANT)
+			{
+				track.offset = (uint32_t)mConstants.size();
+				mConstants.insert(mConstants.end(), values.begin(), values.begin() + components);
+			}
+			else
+			{
+				track.offset = mFrameSize;
+				mFrameSize += trackSize(t, track.format);
+			}
+		}
+	}
+
+	mCompressed.resize((size_t)mFrameSize * mSampleCount);
+	for (uint32_t f = 0; f < mSampleCount; f++)
+	{
+		for (uint32_t c = 0; c < n; c++)
+		{
+			for (uint32_t t = 0; t < 3; t++)
+			{
+				const Track& track = mTracks[(size_t)c * 3 + t];
+				if (track.format == TRACK_CONSTANT)
+					continue;
+
+				float value[4];
+				for (uint32_t k = 0; k < trackComponents[t]; k++)
+					value[k] = frame(f)[(trackStreams[t] + k) * n + c];
+				if (t == 1)
+					normalizeRotation(value);
+
+				encodeTrack(t, track.format, value, track.origin, track.scale, &mCompressed[(size_t)f * mFrameSize + track.offset]);
+			}
+		}
+	}
+
+	std::vector<float>().swap(mSamples);
+}
+
+void AnimationClip::decode(uint32_t channel, uint32_t frame, float* pValues) const
+{
+	const uint8_t* pFrame = mCompressed.data() + (size_t)frame * mFrameSize;
+	for (uint32_t t = 0; t < 3; t++)
+	{
+		const Track& track = mTracks[(size_t)channel * 3 + t];
+		float* pValue = pValues + trackStreams[t];
+		if (track.format == TRACK_CONSTANT)
+		{
+			const float* pConstant = &mConstants[track.offset];
+			for (uint32_t k = 0; k < trackComponents[t]; k++)
+				pValue[k] = pConstant[k];
+		}
+		else
+			decodeTrack(t, track.format, pFrame + track.offset, track.origin, track.scale, pValue);
+	}
+}
+
+void AnimationClip::sampleCompressed(uint32_t channel, const ClipCursor& cursor, float* pValues) const
+{
+	float b[STREAM_COUNT];
+	decode(channel, cursor.frame, pValues);
+	decode(channel, cursor.nextFrame, b);
+
+	// smallest three loses the hemisphere alignment of the source samples
+	if (pValues[RX] * b[RX] + pValues[RY] * b[RY] + pValues[RZ] * b[RZ] + pValues[RW] * b[RW] < 0.0f)
+	{
+		for (uint32_t k = RX; k <= RW; k++)
+			b[k] = -b[k];
+	}
+
+	for (uint32_t k = 0; k < STREAM_COUNT; k++)
+		pValues[k] += (b[k] - pValues[k]) * cursor.alpha;
+}
+
+void AnimationClip::Write(CookedStreamWriter& stream) const
+{
+	stream.Write(mName);
+	stream.Write(mChannelCount);
+	for (const std::string& name : mChannelNames)
+	{
+		stream.Write(name);
+	}
+	stream.Write(mSamples);
+	stream.Write(mSampleCount);
+	stream.Write(mDuration);
+	stream.Write(mTicksPerSecond);
+	stream.Write(mInvSampleInterval);
+
+	stream.Write(mTracks);
+	stream.Write(mCompressed);
+	stream.Write(mConstants);
+	stream.Write(mFrameSize);
+}
+
+bool AnimationClip::Read(CookedStreamReader& stream)
+{
+	stream.Read(mName);
+	stream.Read(mChannelCount);
+	// a name takes at least its length, a damaged count fails below instead of allocating for it
+	mChannelNames.resize(stream.Ok() && mChannelCount <= stream.Remaining() / sizeof(uint32_t) ? mChannelCount : 0);
+	for (std::string& name : mChannelNames)
+	{
+		stream.Read(name);
+	}
+	stream.Read(mSamples);
+	stream.Read(mSampleCount);
+	stream.Read(mDuration);
+	stream.Read(mTicksPerSecond);
+	stream.Read(mInvSampleInterval);
+
+	stream.Read(mTracks);
+	stream.Read(mCompressed);
+	stream.Read(mConstants);
+	stream.Read(mFrameSize);
+
+	if (!stream.Ok() || mChannelNames.size() != mChannelCount || (mChannelCount != 0 && mSampleCount == 0) || mSampleCount > ANIMATION_CLIP_MAX_SAMPLES ||
+		!(mTicksPerSecond > 0.0f) || !(mDuration >= 0.0f) || !isfinite(mDuration) || !(mInvSampleInterval >= 0.0f) || !isfinite(mInvSampleInterval))
+		return false;
+
+	// every sample and track a cursor can reach has to be in the arrays
+	if (!IsCompressed())
+		return mSamples.size() == (size_t)mSampleCount * STREAM_COUNT * mChannelCount;
+
+	if (mTracks.size() != (size_t)mChannelCount * 3 || mCompressed.size() != (size_t)mFrameSize * mSampleCount)
+		return false;
+	for (size_t i = 0; i < mTracks.size(); i++)
+	{
+		const Track& track = mTracks[i];
+		const uint32_t t = (uint32_t)(i % 3);
+		if (track.format > TRACK_FLOAT)
+			return false;
+		if (track.format == TRACK_CONSTANT ? (size_t)track.offset + trackComponents[t] > mConstants.size()
+										   : (size_t)track.offset + trackSize(t, track.format) > mFrameSize)
+			return false;
+	}
+	return true;
+}
\ No newline at end of file
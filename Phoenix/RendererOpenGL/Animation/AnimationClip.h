@@ -0,0 +1,127 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <assimp/anim.h>
+
+#include "../Quaternion.h"
+
+// highest rate a clip gets resampled at, in samples per second
+#define ANIMATION_CLIP_MAX_SAMPLE_RATE 120.0f
+#define ANIMATION_CLIP_MAX_SAMPLES	   16384
+
+class CookedStreamWriter;
+class CookedStreamReader;
+
+// Tolerances of AnimationClip::Compress, per track and in the clip's local space.
+struct ClipCompression
+{
+	float translationError; // units of the source file
+	float rotationError;	// radians
+	float scaleError;
+
+	ClipCompression() : translationError(0.01f), rotationError(0.003f), scaleError(0.001f) {}
+};
+
+// Where a time falls on the sample grid, computed once per evaluation and shared by every channel.
+struct ClipCursor
+{
+	uint32_t frame;
+	uint32_t nextFrame;
+	float	 alpha;
+};
+
+// Animation clip resampled onto a uniform grid at load time.
+// Keys are stored sample major and SoA inside a sample: for frame f the block holds
+// every channel's tx, then every ty, tz, rx, ry, rz, rw, sx, sy, sz. Finding the two
+// samples around a time is a multiply, sampling a channel reads 2 x 10 floats.
+// Rotations are hemisphere aligned between neighbouring samples so a plain nlerp is enough.
+class AnimationClip
+{
+public:
+	enum Stream
+	{
+		TX, TY, TZ,
+		RX, RY, RZ, RW,
+		SX, SY, SZ,
+		STREAM_COUNT
+	};
+
+	AnimationClip();
+
+	// resamples every channel of an assimp animation, the aiAnimation can be freed afterwards
+	void Build(const aiAnimation* pAnimation);
+
+	// time in ticks, clamped to [0, duration]
+	ClipCursor Cursor(float AnimationTime) const;
+
+	void SampleChannel(uint32_t channel, const ClipCursor& cursor, aiVector3D& Translation, Quaternion& Rotation, aiVector3D& Scaling) const;
+
+	// every stream of every channel at once, pOut gets STREAM_COUNT x ChannelCount() floats in the
+	// same layout as a sample block. Rotations are lerped but not normalized.
+	void SampleStreams(const ClipCursor& cursor, float* pOut) const;
+
+	// Replaces the float samples with a compressed copy. Tracks that never move beyond the
+	// tolerance are stored once, translations and scales are range quantized to 8 or 16 bits
+	// per component, rotations are stored smallest three in 32 or 48 bits. Every track gets the
+	// smallest format whose decoded samples all stay within the tolerance, sampling decodes
+	// the two frames it needs on the fly.
+	void Compress(const ClipCompression& settings);
+	bool IsCompressed() const { return !mTracks.empty(); }
+
+	// flat copy for cooked meshes, compressed clips stay compressed. Read returns false when the
+	// stream is truncated or a sample or track would be out of the arrays
+	void Write(CookedStreamWriter& stream) const;
+	bool Read(CookedStreamReader& stream);
+
+	// channel bound to a node name, -1 if the clip does not animate it
+	int32_t FindChannel(const char* nodeName) const;
+
+	const std::string& Name() const { return mName; }
+	const std::string& ChannelName(uint32_t channel) const { return mChannelNames[channel]; }
+	uint32_t ChannelCount() const { return mChannelCount; }
+	uint32_t SampleCount() const { return mSampleCount; }
+	float Duration() const { return mDuration; }
+	float TicksPerSecond() const { return mTicksPerSecond; }
+	float SampleRate() const { return mSampleCount > 1 ? (mSampleCount - 1) / mDuration * mTicksPerSecond : 0.0f; }
+	size_t SizeInBytes() const { return mSamples.size() * sizeof(float) + mCompressed.size() + mConstants.size() * sizeof(float) + mTracks.size() * sizeof(Track); }
+
+private:
+	enum TrackFormat
+	{
+		TRACK_CONSTANT, // value in mConstants
+		TRACK_SMALL,	// 8 bit range per component, 32 bit smallest three for rotations
+		TRACK_LARGE,	// 16 bit range per component, 48 bit smallest three for rotations
+		TRACK_FLOAT
+	};
+
+	// translation, rotation and scale of a channel are three tracks
+	struct Track
+	{
+		uint32_t format;
+		uint32_t offset; // bytes into a compressed frame, or first float in mConstants
+		float	 origin[3];
+		float	 scale[3];  // one quantization step
+	};
+
+	const float* frame(uint32_t index) const { return &mSamples[(size_t)index * STREAM_COUNT * mChannelCount]; }
+
+	// one channel of one sample in Stream order
+	void decode(uint32_t channel, uint32_t frame, float* pValues) const;
+	void sampleCompressed(uint32_t channel, const ClipCursor& cursor, float* pValues) const;
+
+	std::string mName;
+	std::vector<std::string> mChannelNames;
+	std::vector<float> mSamples;
+	uint32_t mChannelCount;
+	uint32_t mSampleCount;
+	float mDuration;		// ticks
+	float mTicksPerSecond;
+	float mInvSampleInterval; // samples per tick
+
+	std::vector<Track> mTracks;
+	std::vector<uint8_t> mCompressed; // mFrameSize bytes per sample
+	std::vector<float> mConstants;
+	uint32_t mFrameSize;
+};
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "AnimationLod.h"
+
+AnimationLod::AnimationLod() : mView(1.0f), mProjectionScale(1.0f)
+{
+	mCoverage[0] = 0.25f;
+	mCoverage[1] = 0.08f;
+	mCoverage[2] = 0.02f;
+
+	mUpdateInterval[0] = 1;
+	mUpdateInterval[1] = 2;
+	mUpdateInterval[2] = 4;
+	mUpdateInterval[3] = 16;
+
+	mSkipHeight[0] = 0;
+	mSkipHeight[1] = 1;
+	mSkipHeight[2] = 2;
+	mSkipHeight[3] = 3;
+
+	for (glm::vec4& plane : mFrustum)
+		plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+void AnimationLod::SetCamera(const glm::mat4& view, const glm::mat4& projection)
+{
+	mView = view;
+	mProjectionScale = projection[1][1];
+
+	// planes straight from the rows of the view projection, pointing inwards
+	glm::mat4 m = glm::transpose(projection * view);
+	mFrustum[0] = m[3] + m[0];
+	mFrustum[1] = m[3] - m[0];
+	mFrustum[2] = m[3] + m[1];
+	mFrustum[3] = m[3] - m[1];
+	mFrustum[4] = m[3] + m[2];
+	mFrustum[5] = m[3] - m[2];
+	for (glm::vec4& plane : mFrustum)
+		plane /= glm::length(glm::vec3(plane));
+}
+
+uint32_t AnimationLod::Select(const glm::vec3& center, float radius) const
+{
+	for (const glm::vec4& plane : mFrustum)
+	{
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return ANIMATION_LOD_HIDDEN;
+	}
+
+	// the camera looks down -z, anything around or behind the eye is as big as it gets
+	float distance = -(mView * glm::vec4(center, 1.0f)).z;
+	if (distance <= radius)
+		return 0;
+
+	float coverage = radius * mProjectionScale / distance;
+	uint32_t lod = 0;
+	while (lod < ANIMATION_LOD_COUNT - 1 && coverage < mCoverage[lod])
+		lod++;
+	return lod;
+}
\ No newline at end of file
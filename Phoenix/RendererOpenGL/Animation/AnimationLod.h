@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+// level 0 is full detail, the last level is also used for instances outside the view
+#define ANIMATION_LOD_COUNT	 4
+#define ANIMATION_LOD_HIDDEN (ANIMATION_LOD_COUNT - 1)
+
+// Picks how much animation work an instance gets from how big it is on screen.
+// Coarser levels are evaluated less often, the pose of the last update is kept in between,
+// and stop sampling the lowest levels of the skeleton (fingers, toes, face) which then keep
+// their bind transform. The thresholds are public so demos can tune them live.
+class AnimationLod
+{
+public:
+	AnimationLod();
+
+	// call once per frame with the active camera's matrices
+	void SetCamera(const glm::mat4& view, const glm::mat4& projection);
+
+	// level for a world space bounding sphere, ANIMATION_LOD_HIDDEN when outside the frustum
+	uint32_t Select(const glm::vec3& center, float radius) const;
+
+	// Updates of coarse levels are spread over their interval by instance index, so a crowd
+	// at one level does not update all at once every few frames.
+	bool ShouldUpdate(uint32_t lod, uint32_t frame, uint32_t instance) const
+	{
+		return (frame + instance) % mUpdateInterval[lod] == 0;
+	}
+
+	// fraction of the screen height the sphere's diameter has to cover to stay at a level
+	float mCoverage[ANIMATION_LOD_COUNT - 1];
+	// evaluate every n frames
+	uint32_t mUpdateInterval[ANIMATION_LOD_COUNT];
+	// nodes with a Skeleton::Height() below this keep their bind transform
+	uint32_t mSkipHeight[ANIMATION_LOD_COUNT];
+
+private:
+	glm::vec4 mFrustum[6];
+	glm::mat4 mView;
+	float mProjectionScale; // projection[1][1], screen coverage of a unit sphere at distance 1
+};
\ No newline at end of file
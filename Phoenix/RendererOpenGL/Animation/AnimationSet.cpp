@@ -0,0 +1,267 @@
+#include "AnimationSet.h"
+
+#include <math.h>
+
+void AnimationSet::Build(const aiScene* pScene)
+{
+	Skeleton skeleton;
+	skeleton.Build(pScene);
+	Build(skeleton);
+}
+
+void AnimationSet::Build(const Skeleton& skeleton)
+{
+	mSkeleton = skeleton;
+
+	// decomposed once so unanimated nodes can be copied straight into a local pose
+	const uint32_t NodeCount = mSkeleton.NodeCount();
+	mBindPose.Resize(NodeCount);
+	for (uint32_t i = 0; i < NodeCount; i++)
+	{
+		aiVector3D Scaling, Translation;
+		aiQuaternion Rotation;
+		mSkeleton.BindTransform(i).Decompose(Scaling, Rotation, Translation);
+
+		const float values[AnimationClip::STREAM_COUNT] = { Translation.x, Translation.y, Translation.z,
+															Rotation.x, Rotation.y, Rotation.z, Rotation.w,
+															Scaling.x, Scaling.y, Scaling.z };
+		for (uint32_t s = 0; s < AnimationClip::STREAM_COUNT; s++)
+			mBindPose.Stream(s)[i] = values[s];
+	}
+}
+
+uint32_t AnimationSet::AddClip(const aiAnimation* pAnimation, bool compress)
+{
+	AnimationClip clip;
+	clip.Build(pAnimation);
+	if (compress)
+		clip.Compress(mCompression);
+
+	return AddClip(clip);
+}
+
+uint32_t AnimationSet::AddClip(const AnimationClip& clip)
+{
+	mClips.push_back(clip);
+
+	mBindings.emplace_back();
+	mSkeleton.BindClip(mClips.back(), mBindings.back());
+
+	mChannelNodes.emplace_back(mClips.back().ChannelCount(), INVALID_SKELETON_INDEX);
+	for (uint32_t i = 0; i < mSkeleton.NodeCount(); i++)
+	{
+		if (mBindings.back()[i] != INVALID_SKELETON_INDEX)
+			mChannelNodes.back()[mBindings.back()[i]] = (int32_t)i;
+	}
+
+	uint32_t index = (uint32_t)mClips.size() - 1;
+	std::vector<float> channels;
+	AnimationInstance first = { index, 0.0f };
+	mReferencePoses.emplace_back();
+	SampleLocalPose(first, mReferencePoses.back(), channels);
+
+	buildCurves(index);
+
+	return index;
+}
+
+void AnimationSet::buildCurves(uint32_t index)
+{
+	const AnimationClip& clip = mClips[index];
+	const std::vector<int32_t>& Nodes = mChannelNodes[index];
+	mCurves.emplace_back();
+
+	// nodes are depth first, so the lowest animated index has no animated ancestors
+	int32_t Root = INVALID_SKELETON_INDEX;
+	for (int32_t node : Nodes)
+	{
+		if (node != INVALID_SKELETON_INDEX && (Root == INVALID_SKELETON_INDEX || node < Root))
+			Root = node;
+	}
+	if (Root == INVALID_SKELETON_INDEX || clip.SampleCount() == 0)
+		return;
+
+	aiMatrix4x4 ParentTransform = mSkeleton.GlobalInverseTransform();
+	std::vector<int32_t> Ancestors;
+	for (int32_t node = mSkeleton.Parent(Root); node != INVALID_SKELETON_INDEX; node = mSkeleton.Parent(node))
+	{
+		Ancestors.push_back(node);
+	}
+	for (size_t i = Ancestors.size(); i-- > 0;)
+	{
+		ParentTransform = ParentTransform * mSkeleton.BindTransform(Ancestors[i]);
+	}
+
+	// the clip's own sample grid, the last sample sits exactly on the duration
+	const uint32_t SampleCount = clip.SampleCount();
+	const int32_t Channel = mBindings[index][Root];
+	std::vector<aiMatrix4x4> RootTransforms(SampleCount);
+	for (uint32_t i = 0; i < SampleCount; i++)
+	{
+		float AnimationTime = SampleCount > 1 ? clip.Duration() * i / (SampleCount - 1) : 0.0f;
+
+		aiVector3D Translation, Scaling;
+		Quaternion RotationQ;
+		clip.SampleChannel(Channel, clip.Cursor(AnimationTime), Translation, RotationQ, Scaling);
+
+		aiMatrix4x4 ScalingM;
+		aiMatrix4x4::Scaling(Scaling, ScalingM);
+		aiMatrix4x4 TranslationM;
+		aiMatrix4x4::Translation(Translation, TranslationM);
+		RootTransforms[i] = ParentTransform * TranslationM * RotationQ.toAiRotationMatrix() * ScalingM;
+	}
+
+	mCurves.back().BuildRootMotion(Root, RootTransforms.data(), SampleCount, clip.Duration() / clip.TicksPerSecond(),
+		mCompression.translationError, mCompression.rotationError);
+}
+
+void AnimationSet::EvaluatePose(const AnimationInstance& instance, AnimationPose& pose, aiMatrix4x4* pGlobals, uint32_t skipHeight) const
+{
+	const AnimationClip& clip = mClips[instance.clip];
+	const int32_t* pChannels = mBindings[instance.clip].data();
+	const aiMatrix4x4& GlobalInverseTransform = mSkeleton.GlobalInverseTransform();
+
+	float TimeInTicks = instance.time * clip.TicksPerSecond();
+	float AnimationTime = fmod(TimeInTicks, clip.Duration());
+	ClipCursor Cursor = clip.Cursor(AnimationTime);
+
+	pose.skinning.resize(mSkeleton.BoneCount());
+	pose.bones.resize(mSkeleton.BoneCount());
+
+	// parents are always evaluated before their children
+	const uint32_t NodeCount = mSkeleton.NodeCount();
+	for (uint32_t i = 0; i < NodeCount; i++)
+	{
+		aiMatrix4x4 NodeTransformation = mSkeleton.BindTransform(i);
+
+		if (pChannels[i] != INVALID_SKELETON_INDEX && mSkeleton.Height(i) >= skipHeight)
+		{
+			aiVector3D Translation, Scaling;
+			Quaternion RotationQ;
+			clip.SampleChannel(pChannels[i], Cursor, Translation, RotationQ, Scaling);
+
+			aiMatrix4x4 ScalingM;
+			aiMatrix4x4::Scaling(Scaling, ScalingM);
+			aiMatrix4x4 RotationM = RotationQ.toAiRotationMatrix();
+			aiMatrix4x4 TranslationM;
+			aiMatrix4x4::Translation(Translation, TranslationM);
+
+			// Combine the above transformations
+			NodeTransformation = TranslationM * RotationM * ScalingM;
+		}
+
+		int32_t Parent = mSkeleton.Parent(i);
+		pGlobals[i] = Parent != INVALID_SKELETON_INDEX ? pGlobals[Parent] * NodeTransformation : NodeTransformation;
+
+		int32_t BoneIndex = mSkeleton.Bone(i);
+		if (BoneIndex != INVALID_SKELETON_INDEX)
+		{
+			pose.bones[BoneIndex] = GlobalInverseTransform * pGlobals[i];
+			pose.skinning[BoneIndex] = pose.bones[BoneIndex] * mSkeleton.BoneOffset(BoneIndex);
+		}
+	}
+}
+
+void AnimationSet::SampleLocalPose(const AnimationInstance& instance, LocalPose& pose, std::vector<float>& channelScratch) const
+{
+	const AnimationClip& clip = mClips[instance.clip];
+	const int32_t* pNodes = mChannelNodes[instance.clip].data();
+
+	float TimeInTicks = instance.time * clip.TicksPerSecond();
+	float AnimationTime = fmod(TimeInTicks, clip.Duration());
+
+	const uint32_t ChannelCount = clip.ChannelCount();
+	channelScratch.resize((size_t)AnimationClip::STREAM_COUNT * ChannelCount);
+	clip.SampleStreams(clip.Cursor(AnimationTime), channelScratch.data());
+
+	pose = mBindPose;
+	for (uint32_t s = 0; s < AnimationClip::STREAM_COUNT; s++)
+	{
+		float* pStream = pose.Stream(s);
+		const float* pChannels = &channelScratch[(size_t)s * ChannelCount];
+		for (uint32_t c = 0; c < ChannelCount; c++)
+		{
+			if (pNodes[c] != INVALID_SKELETON_INDEX)
+				pStream[pNodes[c]] = pChannels[c];
+		}
+	}
+}
+
+void AnimationSet::ComposePose(const LocalPose& local, AnimationPose& pose, aiMatrix4x4* pGlobals) const
+{
+	const aiMatrix4x4& GlobalInverseTransform = mSkeleton.GlobalInverseTransform();
+
+	pose.skinning.resize(mSkeleton.BoneCount());
+	pose.bones.resize(mSkeleton.BoneCount());
+
+	const float* t[3] = { local.Stream(AnimationClip::TX), local.Stream(AnimationClip::TY), local.Stream(AnimationClip::TZ) };
+	const float* r[4] = { local.Stream(AnimationClip::RX), local.Stream(AnimationClip::RY), local.Stream(AnimationClip::RZ), local.Stream(AnimationClip::RW) };
+	const float* s[3] = { local.Stream(AnimationClip::SX), local.Stream(AnimationClip::SY), local.Stream(AnimationClip::SZ) };
+
+	const uint32_t NodeCount = mSkeleton.NodeCount();
+	for (uint32_t i = 0; i < NodeCount; i++)
+	{
+		// T * R * S, blended rotations are already normalized
+		aiMatrix3x3 Rotation = aiQuaternion(r[3][i], r[0][i], r[1][i], r[2][i]).GetMatrix();
+		aiMatrix4x4 NodeTransformation(Rotation.a1 * s[0][i], Rotation.a2 * s[1][i], Rotation.a3 * s[2][i], t[0][i],
+									   Rotation.b1 * s[0][i], Rotation.b2 * s[1][i], Rotation.b3 * s[2][i], t[1][i],
+									   Rotation.c1 * s[0][i], Rotation.c2 * s[1][i], Rotation.c3 * s[2][i], t[2][i],
+									   0.0f, 0.0f, 0.0f, 1.0f);
+
+		int32_t Parent = mSkeleton.Parent(i);
+		pGlobals[i] = Parent != INVALID_SKELETON_INDEX ? pGlobals[Parent] * NodeTransformation : NodeTransformation;
+
+		int32_t BoneIndex = mSkeleton.Bone(i);
+		if (BoneIndex != INVALID_SKELETON_INDEX)
+		{
+			pose.bones[BoneIndex] = GlobalInverseTransform * pGlobals[i];
+			pose.skinning[BoneIndex] = pose.bones[BoneIndex] * mSkeleton.BoneOffset(BoneIndex);
+		}
+	}
+}
+
+void AnimationSet::EvaluateLayers(const AnimationLayer* pLayers, uint32_t count, AnimationPose& pose, PoseScratch& scratch) const
+{
+	const uint32_t NodeCount = mSkeleton.NodeCount();
+	if (scratch.globals.size() < NodeCount)
+		scratch.globals.resize(NodeCount);
+	scratch.pose.Resize(NodeCount);
+	scratch.sample.Resize(NodeCount);
+
+	// base pose, N-way blend of the leading blend layers
+	uint32_t i = 0;
+	float TotalWeight = 0.0f;
+	for (; i < count && pLayers[i].mode == ANIMATION_LAYER_BLEND; i++)
+	{
+		if (pLayers[i].weight <= 0.0f)
+			continue;
+
+		SampleLocalPose(pLayers[i].instance, scratch.sample, scratch.channels);
+		AccumulatePose(scratch.pose, scratch.sample, pLayers[i].weight, TotalWeight == 0.0f);
+		TotalWeight += pLayers[i].weight;
+	}
+
+	if (TotalWeight > 0.0f)
+		NormalizePose(scratch.pose, TotalWeight);
+	else
+		scratch.pose = mBindPose;
+
+	for (; i < count; i++)
+	{
+		const AnimationLayer& layer = pLayers[i];
+		if (layer.weight <= 0.0f)
+			continue;
+
+		// a blend layer after the base pose has nothing left to be normalized with, it cross fades
+		// the result so far towards its clip like an override of the whole body
+		SampleLocalPose(layer.instance, scratch.sample, scratch.channels);
+		if (layer.mode == ANIMATION_LAYER_BLEND)
+			OverridePose(scratch.pose, scratch.sample, fminf(layer.weight, 1.0f), nullptr);
+		else if (layer.mode == ANIMATION_LAYER_OVERRIDE)
+			OverridePose(scratch.pose, scratch.sample, layer.weight, layer.pMask);
+		else
+			AddPose(scratch.pose, scratch.sample, mReferencePoses[layer.instance.clip], layer.weight, layer.pMask);
+	}
+
+	ComposePose(scratch.pose, pose, scratch.globals.data());
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+
+#include "AnimationClip.h"
+#include "ClipCurves.h"
+#include "PoseBlend.h"
+#include "Skeleton.h"
+
+// Per instance playback state, everything else about the animation is shared.
+struct AnimationInstance
+{
+	uint32_t clip;
+	float	 time; // seconds, clips loop
+};
+
+// Per instance output, sized on the first evaluation and reused afterwards.
+struct AnimationPose
+{
+	std::vector<aiMatrix4x4> skinning; // bone palette for the skinning shader
+	std::vector<aiMatrix4x4> bones;	   // model space bone transforms, for drawing joints
+};
+
+enum AnimationLayerMode
+{
+	ANIMATION_LAYER_BLEND,	  // leading blend layers are mixed N-way into the base pose, weights normalized,
+							  // a later one cross fades the layers below it towards the clip
+	ANIMATION_LAYER_OVERRIDE, // lerps the pose below towards the clip
+	ANIMATION_LAYER_ADDITIVE  // adds the clip's difference to its first frame
+};
+
+struct AnimationLayer
+{
+	AnimationInstance  instance;
+	float			   weight;
+	AnimationLayerMode mode;
+	const BoneMask*	   pMask; // null for the whole body, ignored by blend layers
+};
+
+// Everything a layered evaluation needs besides the pose, one per thread.
+struct PoseScratch
+{
+	LocalPose pose;
+	LocalPose sample;
+	std::vector<float> channels;
+	std::vector<aiMatrix4x4> globals;
+};
+
+// What every instance of a skinned mesh shares: the skeleton, its clips and
+// each clip's node -> channel binding. Evaluation only reads it, so any number
+// of threads can evaluate instances at once.
+class AnimationSet
+{
+public:
+	void Build(const aiScene* pScene);
+	void Build(const Skeleton& skeleton);
+
+	// returns the clip index, the clip is compressed with mCompression unless compress is false
+	uint32_t AddClip(const aiAnimation* pAnimation, bool compress = true);
+	// an already built clip, e.g. from a cooked mesh
+	uint32_t AddClip(const AnimationClip& clip);
+
+	// pGlobals is scratch for NodeCount() matrices, left holding every node's transform.
+	// Nodes with a Skeleton::Height() below skipHeight keep their bind transform and are not sampled.
+	void EvaluatePose(const AnimationInstance& instance, AnimationPose& pose, aiMatrix4x4* pGlobals, uint32_t skipHeight = 0) const;
+
+	// Layers are blended as SoA local poses and turned into matrices once, so a layer costs
+	// a clip sample and one pass of SIMD math instead of a matrix per node.
+	// Layers with no weight are skipped without sampling.
+	void EvaluateLayers(const AnimationLayer* pLayers, uint32_t count, AnimationPose& pose, PoseScratch& scratch) const;
+
+	// node local transforms of a clip, nodes it does not animate keep their bind transform
+	void SampleLocalPose(const AnimationInstance& instance, LocalPose& pose, std::vector<float>& channelScratch) const;
+
+	// local transforms to bone palette and model space bones, pGlobals is scratch for NodeCount() matrices
+	void ComposePose(const LocalPose& local, AnimationPose& pose, aiMatrix4x4* pGlobals) const;
+
+	const Skeleton& GetSkeleton() const { return mSkeleton; }
+	uint32_t ClipCount() const { return (uint32_t)mClips.size(); }
+	const AnimationClip& Clip(uint32_t index) const { return mClips[index]; }
+
+	// root motion and events of a clip, the root is the topmost node the clip animates
+	const ClipCurves& Curves(uint32_t clip) const { return mCurves[clip]; }
+	void AddEvent(uint32_t clip, const char* name, float time) { mCurves[clip].AddEvent(name, time); }
+
+	// tolerances for clips added from now on, also used to reduce the root motion keys
+	ClipCompression mCompression;
+
+private:
+	void buildCurves(uint32_t clip);
+
+	Skeleton mSkeleton;
+	std::vector<AnimationClip> mClips;
+	std::vector<std::vector<int32_t>> mBindings;		// node -> channel
+	std::vector<std::vector<int32_t>> mChannelNodes;	// channel -> node
+	std::vector<LocalPose> mReferencePoses;				// first frame of every clip, for additive layers
+	std::vector<ClipCurves> mCurves;
+	LocalPose mBindPose;
+};
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "ClipCurves.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+static aiQuaternion inverse(aiQuaternion q)
+{
+	return q.Conjugate();
+}
+
+static float angleBetween(const aiQuaternion& a, const aiQuaternion& b)
+{
+	float d = fabsf(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+	return 2.0f * acosf(d < 1.0f ? d : 1.0f);
+}
+
+void ClipCurves::BuildRootMotion(int32_t rootNode, const aiMatrix4x4* pRoot, uint32_t sampleCount, float duration, float translationError, float rotationError)
+{
+	mRootNode = rootNode;
+	mDuration = duration;
+	mRootKeys.clear();
+	if (sampleCount == 0)
+		return;
+
+	std::vector<RootMotionKey> samples(sampleCount);
+	for (uint32_t i = 0; i < sampleCount; i++)
+	{
+		aiVector3D Scaling;
+		pRoot[i].Decompose(Scaling, samples[i].rotation, samples[i].translation);
+		samples[i].time = sampleCount > 1 ? duration * i / (sampleCount - 1) : 0.0f;
+
+		// same hemisphere as the previous sample so the keys interpolate the short way
+		if (i > 0)
+		{
+			const aiQuaternion& p = samples[i - 1].rotation;
+			aiQuaternion& q = samples[i].rotation;
+			if (p.x * q.x + p.y * q.y + p.z * q.z + p.w * q.w < 0.0f)
+				q = aiQuaternion(-q.w, -q.x, -q.y, -q.z);
+		}
+	}
+
+	// greedy: stretch every segment as far as the samples it skips stay within tolerance
+	mRootKeys.push_back(samples[0]);
+	uint32_t start = 0;
+	while (start + 1 < sampleCount)
+	{
+		uint32_t end = start + 1;
+		for (; end + 1 < sampleCount; end++)
+		{
+			const RootMotionKey& a = samples[start];
+			const RootMotionKey& b = samples[end + 1];
+
+			bool fits = true;
+			for (uint32_t k = start + 1; k <= end && fits; k++)
+			{
+				float Factor = (samples[k].time - a.time) / (b.time - a.time);
+				aiVector3D Translation = a.translation + (b.translation - a.translation) * Factor;
+				aiQuaternion Rotation;
+				aiQuaternion::Interpolate(Rotation, a.rotation, b.rotation, Factor);
+
+				fits = (Translation - samples[k].translation).Length() <= translationError &&
+					   angleBetween(Rotation, samples[k].rotation) <= rotationError;
+			}
+			if (!fits)
+				break;
+		}
+
+		mRootKeys.push_back(samples[end]);
+		start = end;
+	}
+}
+
+void ClipCurves::AddEvent(const char* name, float time)
+{
+	ClipEvent event = { wrap(time), name };
+	std::vector<ClipEvent>::iterator itr = std::upper_bound(mEvents.begin(), mEvents.end(), event,
+		[](const ClipEvent& a, const ClipEvent& b) { return a.time < b.time; });
+	mEvents.insert(itr, event);
+}
+
+float ClipCurves::wrap(float time) const
+{
+	if (mDuration <= 0.0f)
+		return 0.0f;
+
+	float t = fmodf(time, mDuration);
+	return t < 0.0f ? t + mDuration : t;
+}
+
+void ClipCurves::SampleRoot(float time, aiVector3D& translation, aiQuaternion& rotation) const
+{
+	if (mRootKeys.empty())
+	{
+		translation = aiVector3D(0.0f, 0.0f, 0.0f);
+		rotation = aiQuaternion();
+		return;
+	}
+
+	float t = wrap(time);
+	std::vector<RootMotionKey>::const_iterator next = std::upper_bound(mRootKeys.begin(), mRootKeys.end(), t,
+		[](float value, const RootMotionKey& key) { return value < key.time; });
+	if (next == mRootKeys.begin() || next == mRootKeys.end())
+	{
+		const RootMotionKey& key = next == mRootKeys.end() ? mRootKeys.back() : mRootKeys.front();
+		translation = key.translation;
+		rotation = key.rotation;
+		return;
+	}
+
+	const RootMotionKey& a = *(next - 1);
+	const RootMotionKey& b = *next;
+	float Factor = (t - a.time) / (b.time - a.time);
+	translation = a.translation + (b.translation - a.translation) * Factor;
+	aiQuaternion::Interpolate(rotation, a.rotation, b.rotation, Factor);
+}
+
+void ClipCurves::RootDelta(float from, float to, aiVector3D& translation, aiQuaternion& rotation) const
+{
+	aiVector3D FromTranslation, ToTranslation;
+	aiQuaternion FromRotation, ToRotation;
+	SampleRoot(from, FromTranslation, FromRotation);
+	SampleRoot(to, ToTranslation, ToRotation);
+
+	int32_t Loops = mDuration > 0.0f ? (int32_t)floorf(to / mDuration) - (int32_t)floorf(from / mDuration) : 0;
+	if (Loops <= 0 || mRootKeys.empty())
+	{
+		translation = ToTranslation - FromTranslation;
+		rotation = ToRotation * inverse(FromRotation);
+		rotation.Normalize();
+		return;
+	}
+
+	// to the end of this loop, whole loops, then from the start of the last one
+	const RootMotionKey& First = mRootKeys.front();
+	const RootMotionKey& Last = mRootKeys.back();
+	aiVector3D LoopTranslation = Last.translation - First.translation;
+	aiQuaternion LoopRotation = Last.rotation * inverse(First.rotation);
+
+	translation = (Last.translation - FromTranslation) + LoopTranslation * (float)(Loops - 1) + (ToTranslation - First.translation);
+	rotation = Last.rotation * inverse(FromRotation);
+	for (int32_t i = 1; i < Loops; i++)
+	{
+		rotation = LoopRotation * rotation;
+	}
+	rotation = ToRotation * inverse(First.rotation) * rotation;
+	rotation.Normalize();
+}
+
+void ClipCurves::FindEvents(float from, float to, std::vector<const ClipEvent*>& events) const
+{
+	if (to <= from || mEvents.empty() || mDuration <= 0.0f)
+		return;
+
+	// one binary search per loop the range touches
+	for (float LoopStart = floorf(from / mDuration) * mDuration; LoopStart <= to; LoopStart += mDuration)
+	{
+		float Begin = (from > LoopStart ? from : LoopStart) - LoopStart;
+		float End = (to < LoopStart + mDuration ? to : LoopStart + mDuration) - LoopStart;
+
+		// an event at 0 belongs to this loop unless the range starts exactly there
+		std::vector<ClipEvent>::const_iterator first = LoopStart > from ?
+			std::lower_bound(mEvents.begin(), mEvents.end(), Begin, [](const ClipEvent& event, float value) { return event.time < value; }) :
+			std::upper_bound(mEvents.begin(), mEvents.end(), Begin, [](float value, const ClipEvent& event) { return value < event.time; });
+		std::vector<ClipEvent>::const_iterator last =
+			std::upper_bound(first, mEvents.end(), End, [](float value, const ClipEvent& event) { return value < event.time; });
+
+		for (; first != last; ++first)
+		{
+			events.push_back(&*first);
+		}
+	}
+}
+
+float ClipCurves::FindEvent(const char* name) const
+{
+	for (const ClipEvent& event : mEvents)
+	{
+		if (strcmp(event.name.c_str(), name) == 0)
+			return event.time;
+	}
+	return -1.0f;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <assimp/scene.h>
+
+struct RootMotionKey
+{
+	float		 time; // seconds
+	aiVector3D	 translation;
+	aiQuaternion rotation;
+};
+
+struct ClipEvent
+{
+	float		time; // seconds
+	std::string name;
+};
+
+// What gameplay wants to know about a clip without evaluating it: where its root node goes
+// and when its named events fire. Built once when the clip is added to an AnimationSet, the
+// root's model space transform is kept only at the keys linear interpolation needs to stay
+// within tolerance, so queries are a binary search over a handful of keys.
+// Times are in seconds and wrap like the clip does.
+class ClipCurves
+{
+public:
+	ClipCurves() : mDuration(0.0f), mRootNode(-1) {}
+
+	// pRoot holds the root node's model space transform at sampleCount evenly spaced times,
+	// the first at 0 and the last at duration
+	void BuildRootMotion(int32_t rootNode, const aiMatrix4x4* pRoot, uint32_t sampleCount, float duration, float translationError, float rotationError);
+
+	// kept sorted, time wraps into the clip
+	void AddEvent(const char* name, float time);
+
+	void SampleRoot(float time, aiVector3D& translation, aiQuaternion& rotation) const;
+
+	// How far the root moves from one time to a later one, in model space. Every loop
+	// boundary crossed adds the motion of the whole clip, so walking cycles keep moving.
+	void RootDelta(float from, float to, aiVector3D& translation, aiQuaternion& rotation) const;
+
+	// events in (from, to] in the order they fire, across loop boundaries
+	void FindEvents(float from, float to, std::vector<const ClipEvent*>& events) const;
+
+	// seconds of the first event with that name, -1 if there is none
+	float FindEvent(const char* name) const;
+
+	int32_t RootNode() const { return mRootNode; }
+	uint32_t RootKeyCount() const { return (uint32_t)mRootKeys.size(); }
+	uint32_t EventCount() const { return (uint32_t)mEvents.size(); }
+	float Duration() const { return mDuration; }
+
+private:
+	float wrap(float time) const;
+
+	std::vector<RootMotionKey> mRootKeys; // first at 0, last at mDuration
+	std::vector<ClipEvent> mEvents;		  // sorted by time
+	float mDuration;
+	int32_t mRootNode;
+};
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "PoseBlend.h"
+
+#include <assert.h>
+
+// 4 nodes worth of quaternions, one component per register
+struct Quat4
+{
+	__m128 x, y, z, w;
+};
+
+static inline Quat4 loadRotation(const float* const* pStreams, uint32_t i)
+{
+	Quat4 q = { _mm_load_ps(pStreams[AnimationClip::RX] + i), _mm_load_ps(pStreams[AnimationClip::RY] + i),
+				_mm_load_ps(pStreams[AnimationClip::RZ] + i), _mm_load_ps(pStreams[AnimationClip::RW] + i) };
+	return q;
+}
+
+static inline void storeRotation(float* const* pStreams, uint32_t i, const Quat4& q)
+{
+	_mm_store_ps(pStreams[AnimationClip::RX] + i, q.x);
+	_mm_store_ps(pStreams[AnimationClip::RY] + i, q.y);
+	_mm_store_ps(pStreams[AnimationClip::RZ] + i, q.z);
+	_mm_store_ps(pStreams[AnimationClip::RW] + i, q.w);
+}
+
+static inline __m128 dot(const Quat4& a, const Quat4& b)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_add_ps(_mm_mul_ps(a.z, b.z), _mm_mul_ps(a.w, b.w)));
+}
+
+// negates the lanes of q whose dot with reference is negative, q and -q are the same rotation
+static inline Quat4 alignHemisphere(const Quat4& reference, const Quat4& q)
+{
+	__m128 sign = _mm_and_ps(dot(reference, q), _mm_set1_ps(-0.0f));
+	Quat4 r = { _mm_xor_ps(q.x, sign), _mm_xor_ps(q.y, sign), _mm_xor_ps(q.z, sign), _mm_xor_ps(q.w, sign) };
+	return r;
+}
+
+static inline Quat4 normalize(const Quat4& q)
+{
+	__m128 length = _mm_sqrt_ps(_mm_max_ps(dot(q, q), _mm_set1_ps(1e-12f)));
+	__m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), length);
+	Quat4 r = { _mm_mul_ps(q.x, inv), _mm_mul_ps(q.y, inv), _mm_mul_ps(q.z, inv), _mm_mul_ps(q.w, inv) };
+	return r;
+}
+
+// Hamilton product, a applied after b
+static inline Quat4 multiply(const Quat4& a, const Quat4& b)
+{
+	Quat4 r;
+	r.x = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a.w, b.x), _mm_mul_ps(a.x, b.w)), _mm_mul_ps(a.y, b.z)), _mm_mul_ps(a.z, b.y));
+	r.y = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(a.w, b.y), _mm_mul_ps(a.x, b.z)), _mm_mul_ps(a.y, b.w)), _mm_mul_ps(a.z, b.x));
+	r.z = _mm_add_ps(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(a.w, b.z), _mm_mul_ps(a.x, b.y)), _mm_mul_ps(a.y, b.x)), _mm_mul_ps(a.z, b.w));
+	r.w = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(a.w, b.w), _mm_mul_ps(a.x, b.x)), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+	return r;
+}
+
+static inline __m128 layerWeight(const BoneMask* pMask, uint32_t i, float weight)
+{
+	__m128 w = _mm_set1_ps(weight);
+	return pMask ? _mm_mul_ps(w, _mm_load_ps(pMask->Weights() + i)) : w;
+}
+
+template <typename Pose, typename Float>
+static void streams(Pose& pose, Float** ppStreams)
+{
+	for (uint32_t s = 0; s < AnimationClip::STREAM_COUNT; s++)
+	{
+		ppStreams[s] = pose.Stream(s);
+	}
+}
+
+////////////////////////////////////////////// LOCAL POSE
+void LocalPose::Resize(uint32_t nodeCount)
+{
+	if (nodeCount == mNodeCount && !mData.empty())
+		return;
+
+	mNodeCount = nodeCount;
+	mStride = (nodeCount + 3) & ~3u;
+	mData.assign((size_t)AnimationClip::STREAM_COUNT * (mStride / 4), PoseFloat4());
+
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (uint32_t s : { AnimationClip::RW, AnimationClip::SX, AnimationClip::SY, AnimationClip::SZ })
+	{
+		for (uint32_t i = 0; i < mStride; i += 4)
+			_mm_store_ps(Stream(s) + i, one);
+	}
+}
+
+////////////////////////////////////////////// BONE MASK
+void BoneMask::Build(const Skeleton& skeleton)
+{
+	mWeights.assign((skeleton.NodeCount() + 3) / 4, PoseFloat4());
+}
+
+void BoneMask::SetSubtree(const Skeleton& skeleton, const char* nodeName, float weight)
+{
+	int32_t root = skeleton.FindNode(nodeName);
+	assert(root != INVALID_SKELETON_INDEX);
+
+	// depth first order keeps a subtree contiguous, it ends at the first node whose parent comes before the root
+	float* pWeights = mWeights.data()->v;
+	pWeights[root] = weight;
+	for (uint32_t i = root + 1; i < skeleton.NodeCount() && skeleton.Parent(i) >= root; i++)
+	{
+		pWeights[i] = weight;
+	}
+}
+
+////////////////////////////////////////////// KERNELS
+void AccumulatePose(LocalPose& dst, const LocalPose& src, float weight, bool first)
+{
+	assert(dst.Stride() == src.Stride());
+
+	float* d[AnimationClip::STREAM_COUNT];
+	const float* s[AnimationClip::STREAM_COUNT];
+	streams(dst, d);
+	streams(src, s);
+
+	const __m128 w = _mm_set1_ps(weight);
+	for (uint32_t i = 0; i < dst.Stride(); i += 4)
+	{
+		if (first)
+		{
+			for (uint32_t k = 0; k < AnimationClip::STREAM_COUNT; k++)
+				_mm_store_ps(d[k] + i, _mm_mul_ps(_mm_load_ps(s[k] + i), w));
+			continue;
+		}
+
+		for (uint32_t k : { AnimationClip::TX, AnimationClip::TY, AnimationClip::TZ, AnimationClip::SX, AnimationClip::SY, AnimationClip::SZ })
+			_mm_store_ps(d[k] + i, _mm_add_ps(_mm_load_ps(d[k] + i), _mm_mul_ps(_mm_load_ps(s[k] + i), w)));
+
+		Quat4 sum = loadRotation(d, i);
+		Quat4 q = alignHemisphere(sum, loadRotation(s, i));
+		sum.x = _mm_add_ps(sum.x, _mm_mul_ps(q.x, w));
+		sum.y = _mm_add_ps(sum.y, _mm_mul_ps(q.y, w));
+		sum.z = _mm_add_ps(sum.z, _mm_mul_ps(q.z, w));
+		sum.w = _mm_add_ps(sum.w, _mm_mul_ps(q.w, w));
+		storeRotation(d, i, sum);
+	}
+}
+
+void NormalizePose(LocalPose& dst, float totalWeight)
+{
+	float* d[AnimationClip::STREAM_COUNT];
+	streams(dst, d);
+
+	const __m128 inv = _mm_set1_ps(totalWeight > 0.0f ? 1.0f / totalWeight : 1.0f);
+	for (uint32_t i = 0; i < dst.Stride(); i += 4)
+	{
+		for (uint32_t k : { AnimationClip::TX, AnimationClip::TY, AnimationClip::TZ, AnimationClip::SX, AnimationClip::SY, AnimationClip::SZ })
+			_mm_store_ps(d[k] + i, _mm_mul_ps(_mm_load_ps(d[k] + i), inv));
+
+		storeRotation(d, i, normalize(loadRotation(d, i)));
+	}
+}
+
+void OverridePose(LocalPose& dst, const LocalPose& src, float weight, const BoneMask* pMask)
+{
+	assert(dst.Stride() == src.Stride());
+
+	float* d[AnimationClip::STREAM_COUNT];
+	const float* s[AnimationClip::STREAM_COUNT];
+	streams(dst, d);
+	streams(src, s);
+
+	for (uint32_t i = 0; i < dst.Stride(); i += 4)
+	{
+		const __m128 w = layerWeight(pMask, i, weight);
+
+		for (uint32_t k : { AnimationClip::TX, AnimationClip::TY, AnimationClip::TZ, AnimationClip::SX, AnimationClip::SY, AnimationClip::SZ })
+		{
+			__m128 a = _mm_load_ps(d[k] + i);
+			_mm_store_ps(d[k] + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(s[k] + i), a), w)));
+		}
+
+		Quat4 a = loadRotation(d, i);
+		Quat4 b = alignHemisphere(a, loadRotation(s, i));
+		a.x = _mm_add_ps(a.x, _mm_mul_ps(_mm_sub_ps(b.x, a.x), w));
+		a.y = _mm_add_ps(a.y, _mm_mul_ps(_mm_sub_ps(b.y, a.y), w));
+		a.z = _mm_add_ps(a.z, _mm_mul_ps(_mm_sub_ps(b.z, a.z), w));
+		a.w = _mm_add_ps(a.w, _mm_mul_ps(_mm_sub_ps(b.w, a.w), w));
+		storeRotation(d, i, normalize(a));
+	}
+}
+
+void AddPose(LocalPose& dst, const LocalPose& src, const LocalPose& reference, float weight, const BoneMask* pMask)
+{
+	assert(dst.Stride() == src.Stride() && dst.Stride() == reference.Stride());
+
+	float* d[AnimationClip::STREAM_COUNT];
+	const float* s[AnimationClip::STREAM_COUNT];
+	const float* r[AnimationClip::STREAM_COUNT];
+	streams(dst, d);
+	streams(src, s);
+	streams(reference, r);
+
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+	for (uint32_t i = 0; i < dst.Stride(); i += 4)
+	{
+		const __m128 w = layerWeight(pMask, i, weight);
+
+		for (uint32_t k : { AnimationClip::TX, AnimationClip::TY, AnimationClip::TZ })
+		{
+			__m128 delta = _mm_sub_ps(_mm_load_ps(s[k] + i), _mm_load_ps(r[k] + i));
+			_mm_store_ps(d[k] + i, _mm_add_ps(_mm_load_ps(d[k] + i), _mm_mul_ps(delta, w)));
+		}
+		for (uint32_t k : { AnimationClip::SX, AnimationClip::SY, AnimationClip::SZ })
+		{
+			__m128 delta = _mm_div_ps(_mm_load_ps(s[k] + i), _mm_load_ps(r[k] + i));
+			__m128 factor = _mm_add_ps(one, _mm_mul_ps(_mm_sub_ps(delta, one), w));
+			_mm_store_ps(d[k] + i, _mm_mul_ps(_mm_load_ps(d[k] + i), factor));
+		}
+
+		// delta = src * conjugate(reference), taken the short way round and scaled from the identity
+		Quat4 ref = loadRotation(r, i);
+		ref.x = _mm_xor_ps(ref.x, signBit);
+		ref.y = _mm_xor_ps(ref.y, signBit);
+		ref.z = _mm_xor_ps(ref.z, signBit);
+		Quat4 delta = multiply(loadRotation(s, i), ref);
+
+		__m128 sign = _mm_and_ps(delta.w, signBit);
+		delta.x = _mm_mul_ps(_mm_xor_ps(delta.x, sign), w);
+		delta.y = _mm_mul_ps(_mm_xor_ps(delta.y, sign), w);
+		delta.z = _mm_mul_ps(_mm_xor_ps(delta.z, sign), w);
+		delta.w = _mm_add_ps(one, _mm_mul_ps(_mm_sub_ps(_mm_xor_ps(delta.w, sign), one), w));
+
+		storeRotation(d, i, normalize(multiply(delta, loadRotation(d, i))));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <xmmintrin.h>
+
+#include "AnimationClip.h"
+#include "Skeleton.h"
+
+// element of the pose and mask buffers. std::vector<__m128> drops the vector type's alignment
+// attribute from the template argument, a plain aligned struct keeps it
+struct alignas(16) PoseFloat4
+{
+	float v[4];
+};
+
+// Node local transforms of a whole skeleton, SoA like the clip samples: every node's tx, then
+// every ty, tz, rx, ry, rz, rw, sx, sy, sz (AnimationClip::Stream order). Streams are padded to a
+// multiple of 4 nodes and 16 byte aligned so the blend kernels below handle 4 nodes per instruction.
+// Padding nodes hold the identity so they never produce NaNs.
+class LocalPose
+{
+public:
+	LocalPose() : mNodeCount(0), mStride(0) {}
+
+	void Resize(uint32_t nodeCount);
+
+	float* Stream(uint32_t stream) { return mData[(size_t)stream * (mStride / 4)].v; }
+	const float* Stream(uint32_t stream) const { return mData[(size_t)stream * (mStride / 4)].v; }
+
+	uint32_t NodeCount() const { return mNodeCount; }
+	uint32_t Stride() const { return mStride; }
+
+private:
+	std::vector<PoseFloat4> mData;
+	uint32_t mNodeCount;
+	uint32_t mStride; // floats per stream
+};
+
+// Per node weight of a partial body layer, nodes at 0 are left to the layers below.
+class BoneMask
+{
+public:
+	// every node starts at 0
+	void Build(const Skeleton& skeleton);
+
+	// the node and everything under it, e.g. "Spine" for an upper body layer
+	void SetSubtree(const Skeleton& skeleton, const char* nodeName, float weight);
+
+	const float* Weights() const { return mWeights.data()->v; }
+
+private:
+	std::vector<PoseFloat4> mWeights;
+};
+
+// N-way blend: call with first = true for the first pose, the sum is only a pose again after NormalizePose.
+// Rotations are flipped into the hemisphere of the running sum before they are added.
+void AccumulatePose(LocalPose& dst, const LocalPose& src, float weight, bool first);
+
+// divides translation and scale by the summed weight and normalizes the rotations
+void NormalizePose(LocalPose& dst, float totalWeight);
+
+// dst = lerp(dst, src, weight * mask), nlerp for rotations
+void OverridePose(LocalPose& dst, const LocalPose& src, float weight, const BoneMask* pMask);
+
+// adds the difference between src and reference on top of dst, scaled by weight * mask:
+// translation is offset, scale multiplied and rotation pre-multiplied by the delta rotation
+void AddPose(LocalPose& dst, const LocalPose& src, const LocalPose& reference, float weight, const BoneMask* pMask);
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "Skeleton.h"
+
+#include <string.h>
+
+#include "../../../Common/Renderer/CookedMesh.h"
+
+void Skeleton::Build(const aiScene* pScene)
+{
+	std::unordered_map<std::string, uint32_t> boneMapping;
+	std::vector<aiMatrix4x4> boneOffsets;
+	for (uint32_t m = 0; m < pScene->mNumMeshes; m++)
+	{
+		const aiMesh* pMesh = pScene->mMeshes[m];
+		for (uint32_t i = 0; i < pMesh->mNumBones; i++)
+		{
+			std::string BoneName(pMesh->mBones[i]->mName.data);
+			if (boneMapping.find(BoneName) == boneMapping.end())
+			{
+				boneMapping[BoneName] = (uint32_t)boneOffsets.size();
+				boneOffsets.push_back(pMesh->mBones[i]->mOffsetMatrix);
+			}
+		}
+	}
+
+	Build(pScene->mRootNode, boneMapping, boneOffsets);
+}
+
+void Skeleton::Build(const aiNode* pRoot, const std::unordered_map<std::string, uint32_t>& boneMapping, const std::vector<aiMatrix4x4>& boneOffsets)
+{
+	mBoneMapping = boneMapping;
+	mBoneOffsets = boneOffsets;
+	mGlobalInverseTransform = pRoot->mTransformation;
+	mGlobalInverseTransform.Inverse();
+
+	mParents.clear();
+	mBones.clear();
+	mBindTransforms.clear();
+	mNames.clear();
+
+	// explicit stack instead of recursion, children are pushed in reverse to keep the assimp order
+	struct StackEntry
+	{
+		const aiNode* pNode;
+		int32_t parent;
+	};
+	std::vector<StackEntry> stack;
+	stack.push_back({ pRoot, INVALID_SKELETON_INDEX });
+
+	while (!stack.empty())
+	{
+		StackEntry entry = stack.back();
+		stack.pop_back();
+
+		int32_t index = (int32_t)mParents.size();
+		std::string name(entry.pNode->mName.data);
+		auto bone = boneMapping.find(name);
+
+		mParents.push_back(entry.parent);
+		mBones.push_back(bone != boneMapping.end() ? (int32_t)bone->second : INVALID_SKELETON_INDEX);
+		mBindTransforms.push_back(entry.pNode->mTransformation);
+		mNames.push_back(name);
+
+		for (uint32_t i = entry.pNode->mNumChildren; i > 0; i--)
+		{
+			stack.push_back({ entry.pNode->mChildren[i - 1], index });
+		}
+	}
+
+	// children come after their parent, so one backwards pass finishes every subtree first
+	mHeights.assign(mParents.size(), 0);
+	for (size_t i = mParents.size(); i > 1; i--)
+	{
+		int32_t parent = mParents[i - 1];
+		if (parent != INVALID_SKELETON_INDEX && mHeights[parent] < mHeights[i - 1] + 1 && mHeights[i - 1] < 255)
+			mHeights[parent] = mHeights[i - 1] + 1;
+	}
+}
+
+void Skeleton::Write(CookedStreamWriter& stream) const
+{
+	stream.Write(mParents);
+	stream.Write(mBones);
+	stream.Write(mBindTransforms);
+	stream.Write(mHeights);
+	for (const std::string& name : mNames)
+	{
+		stream.Write(name);
+	}
+
+	stream.Write(mBoneOffsets);
+	stream.Write((uint32_t)mBoneMapping.size());
+	for (const auto& bone : mBoneMapping)
+	{
+		stream.Write(bone.first);
+		stream.Write(bone.second);
+	}
+	stream.Write(mGlobalInverseTransform);
+}
+
+bool Skeleton::Read(CookedStreamReader& stream)
+{
+	stream.Read(mParents);
+	stream.Read(mBones);
+	stream.Read(mBindTransforms);
+	stream.Read(mHeights);
+	mNames.resize(mParents.size());
+	for (std::string& name : mNames)
+	{
+		stream.Read(name);
+	}
+
+	stream.Read(mBoneOffsets);
+	uint32_t BoneCount = 0;
+	stream.Read(BoneCount);
+	mBoneMapping.clear();
+	for (uint32_t i = 0; i < BoneCount && stream.Ok(); i++)
+	{
+		std::string name;
+		uint32_t index = 0;
+		stream.Read(name);
+		stream.Read(index);
+		mBoneMapping[name] = index;
+	}
+	stream.Read(mGlobalInverseTransform);
+
+	if (!stream.Ok() || mBones.size() != mParents.size() || mBindTransforms.size() != mParents.size() || mHeights.size() != mParents.size())
+		return false;
+
+	// parents come before their children, evaluation reads them in one forward pass
+	const int32_t NumBones = (int32_t)mBoneOffsets.size();
+	for (uint32_t i = 0; i < NodeCount(); i++)
+	{
+		if (mParents[i] < INVALID_SKELETON_INDEX || mParents[i] >= (int32_t)i ||
+			mBones[i] < INVALID_SKELETON_INDEX || mBones[i] >= NumBones)
+			return false;
+	}
+	for (const auto& bone : mBoneMapping)
+	{
+		if (bone.second >= (uint32_t)NumBones)
+			return false;
+	}
+	return true;
+}
+
+void Skeleton::BindClip(const AnimationClip& clip, std::vector<int32_t>& nodeChannels) const
+{
+	nodeChannels.resize(NodeCount());
+	for (uint32_t i = 0; i < NodeCount(); i++)
+	{
+		nodeChannels[i] = clip.FindChannel(mNames[i].c_str());
+	}
+}
+
+int32_t Skeleton::FindNode(const char* name) const
+{
+	for (uint32_t i = 0; i < NodeCount(); i++)
+	{
+		if (strcmp(mNames[i].c_str(), name) == 0)
+			return (int32_t)i;
+	}
+	return INVALID_SKELETON_INDEX;
+}
+
+int32_t Skeleton::FindBone(const std::string& name) const
+{
+	auto bone = mBoneMapping.find(name);
+	return bone != mBoneMapping.end() ? (int32_t)bone->second : INVALID_SKELETON_INDEX;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <assimp/scene.h>
+
+#include "AnimationClip.h"
+
+#define INVALID_SKELETON_INDEX -1
+
+class CookedStreamWriter;
+class CookedStreamReader;
+
+// aiNode tree flattened into arrays in depth first order, every parent comes before its
+// children so one forward loop over the nodes evaluates the hierarchy.
+// Names are only kept for binding, nothing is looked up by name after load.
+class Skeleton
+{
+public:
+	// collects the bones of every mesh of the scene, palette indices in order of first use
+	void Build(const aiScene* pScene);
+
+	// boneMapping maps a bone name to its index in the skinning palette
+	void Build(const aiNode* pRoot, const std::unordered_map<std::string, uint32_t>& boneMapping, const std::vector<aiMatrix4x4>& boneOffsets);
+
+	// flat copy for cooked meshes, Read returns false on a truncated stream or out of range indices
+	void Write(CookedStreamWriter& stream) const;
+	bool Read(CookedStreamReader& stream);
+
+	// node -> channel of the clip, INVALID_SKELETON_INDEX where the clip does not animate the node
+	void BindClip(const AnimationClip& clip, std::vector<int32_t>& nodeChannels) const;
+
+	int32_t FindNode(const char* name) const;
+
+	// palette index of a bone, hashed, meant for load time only
+	int32_t FindBone(const std::string& name) const;
+
+	uint32_t NodeCount() const { return (uint32_t)mParents.size(); }
+	int32_t Parent(uint32_t node) const { return mParents[node]; }
+	int32_t Bone(uint32_t node) const { return mBones[node]; }
+	const aiMatrix4x4& BindTransform(uint32_t node) const { return mBindTransforms[node]; }
+	const std::string& NodeName(uint32_t node) const { return mNames[node]; }
+
+	// longest path from the node down to a leaf, leaves are 0. Animation LODs stop animating
+	// the lowest levels of the tree first.
+	uint32_t Height(uint32_t node) const { return mHeights[node]; }
+
+	uint32_t BoneCount() const { return (uint32_t)mBoneOffsets.size(); }
+	const aiMatrix4x4& BoneOffset(uint32_t bone) const { return mBoneOffsets[bone]; }
+	const aiMatrix4x4& GlobalInverseTransform() const { return mGlobalInverseTransform; }
+
+private:
+	std::vector<int32_t> mParents;
+	std::vector<int32_t> mBones;
+	std::vector<aiMatrix4x4> mBindTransforms;
+	std::vector<std::string> mNames;
+	std::vector<uint8_t> mHeights;
+
+	std::vector<aiMatrix4x4> mBoneOffsets;
+	std::unordered_map<std::string, uint32_t> mBoneMapping;
+	aiMatrix4x4 mGlobalInverseTransform;
+};
\ No newline at end of file
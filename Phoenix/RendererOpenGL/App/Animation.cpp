@@ -3,10 +3,15 @@
 #if ANIMATION
 
 #include "../Common.h"
+#include "../Animation/AnimationBatch.h"
 
 // lighting
 glm::vec3 lightPos(1.2f, 3.0f, 2.0f);
-static const uint32_t MAX_BONES = 100;
+
+// guards sharing one skeleton and clip, evaluated on the job system and drawn with one instanced call
+static const uint32_t CROWD_SIZE = 100;
+// background guards playing a baked clip, nothing is evaluated for them on the CPU
+static const uint32_t BAKED_CROWD_SIZE = 10000;
 
 glm::mat4 toGlmMat(aiMatrix4x4 aiMat)
 {
@@ -46,6 +51,8 @@ void Run()
 		"../../Phoenix/RendererOpenGL/App/Resources/Shaders/mesh.frag");
 	ShaderProgram skinningShader("../../Phoenix/RendererOpenGL/App/Resources/Shaders/skinning.vert",
 		"../../Phoenix/RendererOpenGL/App/Resources/Shaders/skinning.frag");
+	ShaderProgram bakedShader("../../Phoenix/RendererOpenGL/App/Resources/Shaders/baked_skinning.vert",
+		"../../Phoenix/RendererOpenGL/App/Resources/Shaders/skinning.frag");
 
 	OpenGLRenderer* pOpenglRenderer = new OpenGLRenderer();
 
@@ -59,11 +66,69 @@ void Run()
 	glUseProgram(skinningShader.mId);
 	skinningShader.SetUniform("isAnim", &mesh.mIsAnim);
 
+	SkinnedMesh crowd;
+	crowd.LoadMesh("../../Phoenix/RendererOpenGL/App/Resources/Objects/guard/boblampclean.md5mesh", CROWD_SIZE);
+
+	std::vector<glm::mat4> crowdModels(CROWD_SIZE);
+	std::vector<AnimationInstance> crowdInstances(CROWD_SIZE);
+	std::vector<AnimationPose> crowdPoses(CROWD_SIZE);
+	for (uint32_t i = 0; i < CROWD_SIZE; i++)
+	{
+		glm::mat4 model = glm::mat4(1.0f);
+		model = glm::translate(model, glm::vec3(-15.0f + 3.0f * (i % 10), -1.0f, -5.0f - 3.0f * (i / 10)));
+		model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+		model = glm::scale(model, glm::vec3(0.05f, 0.05f, 0.05f));
+		crowdModels[i] = model;
+
+		crowdInstances[i].clip = 0;
+		crowdInstances[i].time = 0.0f;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, crowd.instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * CROWD_SIZE, crowdModels.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	JobSystem jobSystem;
+	AnimationBatch crowdBatch(&jobSystem);
+
+	// distant and hidden guards update less often and skip their leaf bones
+	AnimationLod crowdLod;
+	std::vector<uint32_t> crowdLods(CROWD_SIZE);
+	uint32_t crowdLodCounts[ANIMATION_LOD_COUNT] = {};
+	uint32_t crowdFrame = 0;
+
+	SkinnedMesh bakedCrowd;
+	bakedCrowd.LoadMesh("../../Phoenix/RendererOpenGL/App/Resources/Objects/guard/boblampclean.md5mesh", BAKED_CROWD_SIZE);
+	BakedAnimation bakedGuard;
+	bakedGuard.Bake(bakedCrowd, 0);
+	{
+		// a square behind the crowd, random offsets so the guards don't march in step
+		const uint32_t Side = (uint32_t)ceilf(sqrtf((float)BAKED_CROWD_SIZE));
+		std::vector<glm::mat4> bakedModels(BAKED_CROWD_SIZE);
+		srand(7);
+		for (uint32_t i = 0; i < BAKED_CROWD_SIZE; i++)
+		{
+			glm::mat4 model = glm::mat4(1.0f);
+			model = glm::translate(model, glm::vec3(-1.5f * Side + 3.0f * (i % Side), -1.0f, -40.0f - 3.0f * (i / Side)));
+			model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+			model = glm::scale(model, glm::vec3(0.05f, 0.05f, 0.05f));
+			bakedModels[i] = BakedAnimation::PackInstance(model, (rand() % 1000) / 100.0f);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, bakedCrowd.instanceVBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * BAKED_CROWD_SIZE, bakedModels.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	// the single mesh plus every crowd instance, all uploaded with one map per frame
+	BonePaletteBuffer bonePalette(mesh.NumBones() + CROWD_SIZE * crowd.NumBones());
+
 	window.initGui();
 
 	float timer = 0.0f;
 	bool drawJoints = false;
 	bool drawBones = false;
+	bool drawCrowd = false;
+	bool crowdUseLod = true;
+	bool drawBakedCrowd = false;
 
 	int animationIndex = 0;
 	while (!window.windowShouldClose() && !exitOnESC)
@@ -111,8 +176,39 @@ void Run()
 			pOpenglRenderer->RenderSphere();
 
 			// skinning
+			bonePalette.BeginFrame();
+
 			tinystl::vector<aiMatrix4x4> Transforms, BoneTransforms;
 			mesh.BoneTransform(timer / 1000.0f, Transforms, BoneTransforms);
+			int meshPaletteBase = (int)bonePalette.Upload(Transforms.data(), (uint32_t)Transforms.size());
+
+			int crowdPaletteBase = 0;
+			if (drawCrowd)
+			{
+				for (uint32_t i = 0; i < CROWD_SIZE; i++)
+				{
+					crowdInstances[i].time = timer / 1000.0f + 0.37f * i;
+				}
+
+				// bounding sphere around the scaled guard, centered on its chest
+				crowdLod.SetCamera(view, projection);
+				memset(crowdLodCounts, 0, sizeof(crowdLodCounts));
+				for (uint32_t i = 0; i < CROWD_SIZE; i++)
+				{
+					crowdLods[i] = crowdUseLod ? crowdLod.Select(glm::vec3(crowdModels[i][3]) + glm::vec3(0.0f, 1.5f, 0.0f), 2.0f) : 0;
+					crowdLodCounts[crowdLods[i]]++;
+				}
+				crowdBatch.Evaluate(crowd.Animations(), crowdLod, crowdLods.data(), crowdFrame++, crowdInstances.data(), crowdPoses.data(), CROWD_SIZE);
+
+				aiMatrix4x4* pPalette;
+				crowdPaletteBase = (int)bonePalette.Allocate(CROWD_SIZE * crowd.NumBones(), &pPalette);
+				for (uint32_t i = 0; i < CROWD_SIZE; i++)
+				{
+					memcpy(pPalette + i * crowd.NumBones(), crowdPoses[i].skinning.data(), sizeof(aiMatrix4x4) * crowd.NumBones());
+				}
+			}
+
+			bonePalette.Commit();
 
 			model = glm::mat4(1.0f);
 			model = glm::translate(model, glm::vec3(0.0f, -1.0f, 0.0f));
@@ -124,12 +220,13 @@ void Run()
 			if (!drawJoints && !drawBones)
 			{
 				glUseProgram(skinningShader.mId);
-				for (uint32_t i = 0; i < Transforms.size(); i++)
-				{
-					assert(i < MAX_BONES);
-					std::string gBone = "gBones[" + std::to_string(i) + "]";
-					glUniformMatrix4fv(glGetUniformLocation(skinningShader.mId, gBone.c_str()), 1, GL_TRUE, (const GLfloat*)&Transforms[i]);
-				}
+				bonePalette.Bind(skinningShader);
+
+				int boneCount = (int)mesh.NumBones();
+				int isInstanced = 0;
+				skinningShader.SetUniform("gPaletteBase", &meshPaletteBase);
+				skinningShader.SetUniform("gBoneCount", &boneCount);
+				skinningShader.SetUniform("isInstanced", &isInstanced);
 
 				skinningShader.SetUniform("gEyeWorldPos", &camera.Position);
 
@@ -138,8 +235,30 @@ void Run()
 				skinningShader.SetUniform("model", &model);
 
 				mesh.Render(skinningShader);
+
+				if (drawCrowd)
+				{
+					boneCount = (int)crowd.NumBones();
+					isInstanced = 1;
+					skinningShader.SetUniform("gPaletteBase", &crowdPaletteBase);
+					skinningShader.SetUniform("gBoneCount", &boneCount);
+					skinningShader.SetUniform("isInstanced", &isInstanced);
+
+					crowd.Render(skinningShader);
+				}
+
+				if (drawBakedCrowd)
+				{
+					glUseProgram(bakedShader.mId);
+					bakedShader.SetUniform("projection", &projection);
+					bakedShader.SetUniform("view", &view);
+
+					pOpenglRenderer->RenderBakedInstanced(bakedCrowd, bakedGuard, bakedShader, timer / 1000.0f);
+				}
 			}
 
+			bonePalette.EndFrame();
+
 
 			if (drawJoints)
 			{
@@ -210,7 +329,12 @@ void Run()
 
 				ImGui::Checkbox("Draw Joints", &drawJoints);
 				ImGui::Checkbox("Draw Bones", &drawBones);
+				ImGui::Checkbox("Draw Crowd", &drawCrowd);
+				ImGui::Checkbox("Animation LOD", &crowdUseLod);
+				ImGui::Checkbox("Draw Baked Crowd", &drawBakedCrowd);
+				ImGui::Text("Crowd LODs %u / %u / %u / %u", crowdLodCounts[0], crowdLodCounts[1], crowdLodCounts[2], crowdLodCounts[3]);
 
+				ImGui::SliderFloat("Crossfade", &mesh.mCrossfadeDuration, 0.0f, 1.0f);
 				ImGui::InputInt("Animation Index", &animationIndex);
 				mesh.SetCurrentAnimation(animationIndex);
 
@@ -0,0 +1,577 @@
+#include "../Picker.h"
+
+#if ANIMATION_BENCHMARK
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../Animation/AnimationClip.h"
+#include "../Animation/Skeleton.h"
+#include "../Animation/AnimationBatch.h"
+
+// Compares sampling assimp key arrays the way SkinnedMesh used to (linear key search per
+// channel per call) against the resampled AnimationClip, then walking the aiNode tree by
+// name against the flattened Skeleton, and the compressed clip's size, error and cost.
+// Prints ns per bone per sample.
+// The crowd part evaluates many instances of one mesh through AnimationBatch
+// for a range of instance and thread counts, then with blend layers and with LODs.
+// Root motion queries are timed against the full evaluation they replace.
+
+static const uint32_t SAMPLE_COUNT = 4096;
+
+//////////////////////////////////////////////// LINEAR KEY SEARCH (old SkinnedMesh path)
+template <typename Key>
+static uint32_t findKey(float AnimationTime, const Key* pKeys, uint32_t numKeys)
+{
+	for (uint32_t i = 0; i < numKeys - 1; i++)
+	{
+		if (AnimationTime < (float)pKeys[i + 1].mTime)
+			return i;
+	}
+	return numKeys - 2;
+}
+
+template <typename Key>
+static float keyFactor(float AnimationTime, const Key* pKeys, uint32_t index)
+{
+	float DeltaTime = (float)(pKeys[index + 1].mTime - pKeys[index].mTime);
+	return (AnimationTime - (float)pKeys[index].mTime) / DeltaTime;
+}
+
+static void sampleLinear(const aiNodeAnim* pNodeAnim, float AnimationTime, aiVector3D& Translation, Quaternion& Rotation, aiVector3D& Scaling)
+{
+	if (pNodeAnim->mNumPositionKeys == 1)
+		Translation = pNodeAnim->mPositionKeys[0].mValue;
+	else
+	{
+		uint32_t i = findKey(AnimationTime, pNodeAnim->mPositionKeys, pNodeAnim->mNumPositionKeys);
+		const aiVector3D& Start = pNodeAnim->mPositionKeys[i].mValue;
+		Translation = Start + keyFactor(AnimationTime, pNodeAnim->mPositionKeys, i) * (pNodeAnim->mPositionKeys[i + 1].mValue - Start);
+	}
+
+	if (pNodeAnim->mNumRotationKeys == 1)
+		Rotation = pNodeAnim->mRotationKeys[0].mValue;
+	else
+	{
+		uint32_t i = findKey(AnimationTime, pNodeAnim->mRotationKeys, pNodeAnim->mNumRotationKeys);
+		Rotation = Quaternion::interpolate(pNodeAnim->mRotationKeys[i].mValue, pNodeAnim->mRotationKeys[i + 1].mValue, keyFactor(AnimationTime, pNodeAnim->mRotationKeys, i));
+	}
+
+	if (pNodeAnim->mNumScalingKeys == 1)
+		Scaling = pNodeAnim->mScalingKeys[0].mValue;
+	else
+	{
+		uint32_t i = findKey(AnimationTime, pNodeAnim->mScalingKeys, pNodeAnim->mNumScalingKeys);
+		const aiVector3D& Start = pNodeAnim->mScalingKeys[i].mValue;
+		Scaling = Start + keyFactor(AnimationTime, pNodeAnim->mScalingKeys, i) * (pNodeAnim->mScalingKeys[i + 1].mValue - Start);
+	}
+}
+
+//////////////////////////////////////////////// NODE TREE WALK (old ReadNodeHeirarchy path)
+struct TreeWalk
+{
+	const AnimationClip* pClip;
+	ClipCursor cursor;
+	std::unordered_map<std::string, uint32_t>* pBoneMapping;
+	std::vector<aiMatrix4x4>* pFinal;
+};
+
+static aiMatrix4x4 localTransform(const AnimationClip& clip, uint32_t channel, const ClipCursor& cursor)
+{
+	aiVector3D Translation, Scaling;
+	Quaternion Rotation;
+	clip.SampleChannel(channel, cursor, Translation, Rotation, Scaling);
+
+	aiMatrix4x4 ScalingM, TranslationM;
+	aiMatrix4x4::Scaling(Scaling, ScalingM);
+	aiMatrix4x4::Translation(Translation, TranslationM);
+	return TranslationM * Rotation.toAiRotationMatrix() * ScalingM;
+}
+
+static void walkTree(TreeWalk& walk, const aiNode* pNode, const aiMatrix4x4& ParentTransform)
+{
+	std::string NodeName(pNode->mName.data);
+	aiMatrix4x4 NodeTransformation(pNode->mTransformation);
+
+	for (uint32_t c = 0; c < walk.pClip->ChannelCount(); c++)
+	{
+		if (std::string(walk.pClip->ChannelName(c).c_str()) == NodeName)
+		{
+			NodeTransformation = localTransform(*walk.pClip, c, walk.cursor);
+			break;
+		}
+	}
+
+	aiMatrix4x4 GlobalTransformation = ParentTransform * NodeTransformation;
+	if (walk.pBoneMapping->find(NodeName) != walk.pBoneMapping->end())
+	{
+		(*walk.pFinal)[(*walk.pBoneMapping)[NodeName]] = GlobalTransformation;
+	}
+
+	for (uint32_t i = 0; i < pNode->mNumChildren; i++)
+	{
+		walkTree(walk, pNode->mChildren[i], GlobalTransformation);
+	}
+}
+
+//////////////////////////////////////////////// BENCHMARK
+static double elapsedNs(std::chrono::high_resolution_clock::time_point start)
+{
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static void benchmarkClip(const char* filename)
+{
+	Assimp::Importer importer;
+	const aiScene* pScene = importer.ReadFile(filename, 0);
+	if (!pScene || pScene->mNumAnimations == 0)
+	{
+		printf("%s: no animation (%s)\n", filename, importer.GetErrorString());
+		return;
+	}
+
+	const aiAnimation* pAnimation = pScene->mAnimations[0];
+	uint32_t keyCount = 0;
+	size_t keyBytes = 0;
+	for (uint32_t c = 0; c < pAnimation->mNumChannels; c++)
+	{
+		const aiNodeAnim* pChannel = pAnimation->mChannels[c];
+		keyCount += pChannel->mNumPositionKeys + pChannel->mNumRotationKeys + pChannel->mNumScalingKeys;
+		keyBytes += (pChannel->mNumPositionKeys + pChannel->mNumScalingKeys) * sizeof(aiVectorKey) + pChannel->mNumRotationKeys * sizeof(aiQuatKey);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	AnimationClip clip;
+	clip.Build(pAnimation);
+	double buildMs = elapsedNs(start) / 1e6;
+
+	const uint32_t channels = clip.ChannelCount();
+	const float duration = clip.Duration();
+
+	// same times for both paths, spread over the whole clip
+	float times[SAMPLE_COUNT];
+	for (uint32_t i = 0; i < SAMPLE_COUNT; i++)
+	{
+		times[i] = fmodf(i * 0.37f * duration / 64.0f, duration);
+	}
+
+	aiVector3D Translation, Scaling;
+	Quaternion Rotation;
+	float checksum = 0.0f;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < SAMPLE_COUNT; i++)
+	{
+		for (uint32_t c = 0; c < channels; c++)
+		{
+			sampleLinear(pAnimation->mChannels[c], times[i], Translation, Rotation, Scaling);
+			checksum += Translation.x + Scaling.y;
+		}
+	}
+	double linearNs = elapsedNs(start) / ((double)SAMPLE_COUNT * channels);
+
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < SAMPLE_COUNT; i++)
+	{
+		ClipCursor cursor = clip.Cursor(times[i]);
+		for (uint32_t c = 0; c < channels; c++)
+		{
+			clip.SampleChannel(c, cursor, Translation, Rotation, Scaling);
+			checksum += Translation.x + Scaling.y;
+		}
+	}
+	double clipNs = elapsedNs(start) / ((double)SAMPLE_COUNT * channels);
+
+	start = std::chrono::high_resolution_clock::now();
+	AnimationClip compressed;
+	compressed.Build(pAnimation);
+	compressed.Compress(ClipCompression());
+	double compressMs = elapsedNs(start) / 1e6;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < SAMPLE_COUNT; i++)
+	{
+		ClipCursor cursor = compressed.Cursor(times[i]);
+		for (uint32_t c = 0; c < channels; c++)
+		{
+			compressed.SampleChannel(c, cursor, Translation, Rotation, Scaling);
+			checksum += Translation.x + Scaling.y;
+		}
+	}
+	double compressedNs = elapsedNs(start) / ((double)SAMPLE_COUNT * channels);
+
+	// what compression adds on top of resampling
+	float compressedTranslationError = 0.0f, compressedRotationError = 0.0f;
+	for (uint32_t i = 0; i < SAMPLE_COUNT; i += 16)
+	{
+		ClipCursor cursor = clip.Cursor(times[i]);
+		for (uint32_t c = 0; c < channels; c++)
+		{
+			aiVector3D T0, T1, S0, S1;
+			Quaternion R0, R1;
+			clip.SampleChannel(c, cursor, T0, R0, S0);
+			compressed.SampleChannel(c, cursor, T1, R1, S1);
+			float dot = fabsf(R0.Dot(R1));
+			float angle = 2.0f * acosf(dot < 1.0f ? dot : 1.0f);
+			compressedTranslationError = (T0 - T1).Length() > compressedTranslationError ? (T0 - T1).Length() : compressedTranslationError;
+			compressedRotationError = angle > compressedRotationError ? angle : compressedRotationError;
+		}
+	}
+
+	// largest translation difference between the two paths, resampling error
+	float maxError = 0.0f;
+	for (uint32_t i = 0; i < SAMPLE_COUNT; i += 16)
+	{
+		ClipCursor cursor = clip.Cursor(times[i]);
+		for (uint32_t c = 0; c < channels; c++)
+		{
+			aiVector3D T0, T1, S0, S1;
+			Quaternion R0, R1;
+			sampleLinear(pAnimation->mChannels[c], times[i], T0, R0, S0);
+			clip.SampleChannel(c, cursor, T1, R1, S1);
+			float error = (T0 - T1).Length();
+			if (error > maxError)
+				maxError = error;
+		}
+	}
+
+	// whole pose, every animated node counts as a bone
+	std::unordered_map<std::string, uint32_t> boneMapping;
+	for (uint32_t c = 0; c < channels; c++)
+	{
+		boneMapping[clip.ChannelName(c)] = c;
+	}
+	std::vector<aiMatrix4x4> finalTransforms(channels);
+
+	Skeleton skeleton;
+	skeleton.Build(pScene->mRootNode, boneMapping, std::vector<aiMatrix4x4>(channels));
+	std::vector<int32_t> nodeChannels;
+	skeleton.BindClip(clip, nodeChannels);
+	std::vector<aiMatrix4x4> globalTransforms(skeleton.NodeCount());
+
+	const uint32_t poseCount = SAMPLE_COUNT / 8;
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < poseCount; i++)
+	{
+		TreeWalk walk = { &clip, clip.Cursor(times[i]), &boneMapping, &finalTransforms };
+		walkTree(walk, pScene->mRootNode, aiMatrix4x4());
+		checksum += finalTransforms[i % channels].a4;
+	}
+	double treeNs = elapsedNs(start) / ((double)poseCount * channels);
+
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < poseCount; i++)
+	{
+		ClipCursor cursor = clip.Cursor(times[i]);
+		for (uint32_t n = 0; n < skeleton.NodeCount(); n++)
+		{
+			aiMatrix4x4 NodeTransformation = nodeChannels[n] != INVALID_SKELETON_INDEX ? localTransform(clip, nodeChannels[n], cursor) : skeleton.BindTransform(n);
+			int32_t parent = skeleton.Parent(n);
+			globalTransforms[n] = parent != INVALID_SKELETON_INDEX ? globalTransforms[parent] * NodeTransformation : NodeTransformation;
+			if (skeleton.Bone(n) != INVALID_SKELETON_INDEX)
+				finalTransforms[skeleton.Bone(n)] = globalTransforms[n];
+		}
+		checksum += finalTransforms[i % channels].a4;
+	}
+	double flatNs = elapsedNs(start) / ((double)poseCount * channels);
+
+	printf("%s\n", filename);
+	printf("  channels %u, keys %u, duration %.1f ticks @ %.1f tps\n", channels, keyCount, duration, clip.TicksPerSecond());
+	printf("  clip: %u samples @ %.1f Hz, %.1f KB, built in %.3f ms\n", clip.SampleCount(), clip.SampleRate(), clip.SizeInBytes() / 1024.0f, buildMs);
+	printf("  linear key search: %7.2f ns / bone / sample\n", linearNs);
+	printf("  resampled clip   : %7.2f ns / bone / sample (%.1fx)\n", clipNs, linearNs / clipNs);
+	printf("  compressed clip  : %7.2f ns / bone / sample, %.1f KB (%.1fx smaller than the clip, %.1fx than the assimp keys), compressed in %.3f ms\n",
+		   compressedNs, compressed.SizeInBytes() / 1024.0f, (double)clip.SizeInBytes() / compressed.SizeInBytes(), (double)keyBytes / compressed.SizeInBytes(), compressMs);
+	printf("  compression error: translation %f, rotation %f rad\n", compressedTranslationError, compressedRotationError);
+	printf("  pose, node tree by name: %7.2f ns / bone / sample\n", treeNs);
+	printf("  pose, flattened skeleton: %6.2f ns / bone / sample (%.1fx, %u nodes)\n", flatNs, treeNs / flatNs, skeleton.NodeCount());
+	printf("  max translation error %f (checksum %f)\n\n", maxError, checksum);
+}
+
+static void benchmarkCrowd(const char* filename)
+{
+	Assimp::Importer importer;
+	const aiScene* pScene = importer.ReadFile(filename, 0);
+	if (!pScene || pScene->mNumAnimations == 0)
+	{
+		printf("%s: no animation (%s)\n", filename, importer.GetErrorString());
+		return;
+	}
+
+	AnimationSet set;
+	set.Build(pScene);
+	set.AddClip(pScene->mAnimations[0]);
+	const uint32_t boneCount = set.GetSkeleton().BoneCount();
+
+	printf("crowd, %s (%u bones, %u nodes)\n", filename, boneCount, set.GetSkeleton().NodeCount());
+	printf("  instances threads   ms/frame   ns/bone\n");
+
+	const uint32_t instanceCounts[] = { 1, 64, 1024, 8192 };
+	const uint32_t threadCounts[] = { 1, 2, 4, 8 };
+	const uint32_t frameCount = 16;
+
+	for (uint32_t threads : threadCounts)
+	{
+		JobSystem jobSystem(threads);
+		AnimationBatch batch(&jobSystem);
+
+		for (uint32_t instanceCount : instanceCounts)
+		{
+			std::vector<AnimationInstance> instances(instanceCount);
+			std::vector<AnimationPose> poses(instanceCount);
+			for (uint32_t i = 0; i < instanceCount; i++)
+			{
+				instances[i].clip = 0;
+				instances[i].time = i * 0.013f;
+			}
+
+			// first pass sizes the poses
+			batch.Evaluate(set, instances.data(), poses.data(), instanceCount);
+
+			auto start = std::chrono::high_resolution_clock::now();
+			for (uint32_t frame = 0; frame < frameCount; frame++)
+			{
+				for (AnimationInstance& instance : instances)
+				{
+					instance.time += 1.0f / 60.0f;
+				}
+				batch.Evaluate(set, instances.data(), poses.data(), instanceCount);
+			}
+			double frameNs = elapsedNs(start) / frameCount;
+
+			printf("  %9u %7u %10.3f %9.2f\n", instanceCount, threads, frameNs / 1e6, frameNs / ((double)instanceCount * boneCount));
+		}
+	}
+	printf("\n");
+}
+
+// Layered evaluation against building a full matrix pose per layer, the cost a matrix
+// based blend would start from before doing any blending at all.
+static void benchmarkBlending(const char* filename)
+{
+	Assimp::Importer importer;
+	const aiScene* pScene = importer.ReadFile(filename, 0);
+	if (!pScene || pScene->mNumAnimations == 0)
+	{
+		printf("%s: no animation (%s)\n", filename, importer.GetErrorString());
+		return;
+	}
+
+	AnimationSet set;
+	set.Build(pScene);
+	set.AddClip(pScene->mAnimations[0]);
+
+	printf("blending, %s (%u bones, %u nodes)\n", filename, set.GetSkeleton().BoneCount(), set.GetSkeleton().NodeCount());
+	printf("  layers  matrix pose per layer us  layered us\n");
+
+	const uint32_t layerCounts[] = { 1, 2, 4, 8 };
+	const uint32_t iterations = 2048;
+
+	AnimationPose pose;
+	PoseScratch scratch;
+	std::vector<aiMatrix4x4> globals(set.GetSkeleton().NodeCount());
+	for (uint32_t layerCount : layerCounts)
+	{
+		std::vector<AnimationLayer> layers(layerCount);
+		for (uint32_t i = 0; i < layerCount; i++)
+		{
+			layers[i].instance.clip = 0;
+			layers[i].instance.time = i * 0.17f;
+			layers[i].weight = 1.0f / layerCount;
+			layers[i].mode = ANIMATION_LAYER_BLEND;
+			layers[i].pMask = nullptr;
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t it = 0; it < iterations; it++)
+		{
+			for (AnimationLayer& layer : layers)
+			{
+				layer.instance.time += 1.0f / 60.0f;
+				set.EvaluatePose(layer.instance, pose, globals.data());
+			}
+		}
+		double matrixUs = elapsedNs(start) / iterations / 1000.0;
+
+		start = std::chrono::high_resolution_clock::now();
+		for (uint32_t it = 0; it < iterations; it++)
+		{
+			for (AnimationLayer& layer : layers)
+			{
+				layer.instance.time += 1.0f / 60.0f;
+			}
+			set.EvaluateLayers(layers.data(), layerCount, pose, scratch);
+		}
+		double layeredUs = elapsedNs(start) / iterations / 1000.0;
+
+		printf("  %6u %25.2f %11.2f\n", layerCount, matrixUs, layeredUs);
+	}
+	printf("\n");
+}
+
+// A crowd spread out in front of the camera, full rate against LOD driven evaluation.
+static void benchmarkLod(const char* filename)
+{
+	Assimp::Importer importer;
+	const aiScene* pScene = importer.ReadFile(filename, 0);
+	if (!pScene || pScene->mNumAnimations == 0)
+	{
+		printf("%s: no animation (%s)\n", filename, importer.GetErrorString());
+		return;
+	}
+
+	AnimationSet set;
+	set.Build(pScene);
+	set.AddClip(pScene->mAnimations[0]);
+
+	// 32 x 32 guards 4 units apart, the grid is wider than the view so some end up hidden
+	const uint32_t side = 32;
+	const uint32_t instanceCount = side * side;
+	const uint32_t frameCount = 64;
+
+	AnimationLod lod;
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 2.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	lod.SetCamera(view, projection);
+
+	std::vector<AnimationInstance> instances(instanceCount);
+	std::vector<uint32_t> lods(instanceCount), fullDetail(instanceCount, 0);
+	uint32_t lodCounts[ANIMATION_LOD_COUNT] = {};
+	for (uint32_t i = 0; i < instanceCount; i++)
+	{
+		instances[i].clip = 0;
+		instances[i].time = i * 0.013f;
+
+		glm::vec3 center(((float)(i % side) - side / 2.0f) * 4.0f, 1.5f, -2.0f - (float)(i / side) * 4.0f);
+		lods[i] = lod.Select(center, 2.0f);
+		lodCounts[lods[i]]++;
+	}
+
+	printf("lod, %s (%u instances, %u nodes)\n", filename, instanceCount, set.GetSkeleton().NodeCount());
+	printf("  instances per level %u / %u / %u / %u\n", lodCounts[0], lodCounts[1], lodCounts[2], lodCounts[3]);
+
+	JobSystem jobSystem(1);
+	AnimationBatch batch(&jobSystem);
+	AnimationLod fullRate;
+	for (uint32_t l = 0; l < ANIMATION_LOD_COUNT; l++)
+	{
+		fullRate.mUpdateInterval[l] = 1;
+		fullRate.mSkipHeight[l] = 0;
+	}
+
+	const AnimationLod* pSettings[] = { &fullRate, &lod };
+	const uint32_t* pLevels[] = { fullDetail.data(), lods.data() };
+	const char* names[] = { "full rate", "lod" };
+	double frameMs[2];
+	for (uint32_t run = 0; run < 2; run++)
+	{
+		std::vector<AnimationPose> poses(instanceCount);
+		batch.Evaluate(set, *pSettings[run], pLevels[run], 0, instances.data(), poses.data(), instanceCount);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 1; frame <= frameCount; frame++)
+		{
+			for (AnimationInstance& instance : instances)
+			{
+				instance.time += 1.0f / 60.0f;
+			}
+			batch.Evaluate(set, *pSettings[run], pLevels[run], frame, instances.data(), poses.data(), instanceCount);
+		}
+		frameMs[run] = elapsedNs(start) / frameCount / 1e6;
+		printf("  %-9s %8.3f ms/frame\n", names[run], frameMs[run]);
+	}
+	printf("  %.1fx\n\n", frameMs[0] / frameMs[1]);
+}
+
+static void benchmarkRootMotion(const char* filename)
+{
+	Assimp::Importer importer;
+	const aiScene* pScene = importer.ReadFile(filename, 0);
+	if (!pScene || pScene->mNumAnimations == 0)
+	{
+		printf("%s: no animation (%s)\n", filename, importer.GetErrorString());
+		return;
+	}
+
+	AnimationSet set;
+	set.Build(pScene);
+	set.AddClip(pScene->mAnimations[0]);
+
+	const ClipCurves& curves = set.Curves(0);
+	if (curves.RootNode() == INVALID_SKELETON_INDEX)
+	{
+		printf("%s: no animated root\n\n", filename);
+		return;
+	}
+
+	printf("root motion, %s (root %s)\n", filename, set.GetSkeleton().NodeName(curves.RootNode()).c_str());
+	printf("  %u keys from %u samples\n", curves.RootKeyCount(), set.Clip(0).SampleCount());
+
+	// the same root transform through the curve and through a whole evaluation
+	std::vector<aiMatrix4x4> globals(set.GetSkeleton().NodeCount());
+	AnimationPose pose;
+	float maxError = 0.0f;
+	for (uint32_t i = 0; i < SAMPLE_COUNT; i++)
+	{
+		AnimationInstance instance = { 0, curves.Duration() * i / SAMPLE_COUNT };
+		set.EvaluatePose(instance, pose, globals.data());
+
+		aiVector3D Scaling, Translation, CurveTranslation;
+		aiQuaternion Rotation, CurveRotation;
+		(set.GetSkeleton().GlobalInverseTransform() * globals[curves.RootNode()]).Decompose(Scaling, Rotation, Translation);
+		curves.SampleRoot(instance.time, CurveTranslation, CurveRotation);
+		maxError = fmaxf(maxError, (Translation - CurveTranslation).Length());
+	}
+
+	float checksum = 0.0f;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < SAMPLE_COUNT; i++)
+	{
+		AnimationInstance instance = { 0, i * 0.0137f };
+		set.EvaluatePose(instance, pose, globals.data());
+		checksum += globals[curves.RootNode()].a4;
+	}
+	double evaluateNs = elapsedNs(start) / SAMPLE_COUNT;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < SAMPLE_COUNT; i++)
+	{
+		aiVector3D Translation;
+		aiQuaternion Rotation;
+		curves.SampleRoot(i * 0.0137f, Translation, Rotation);
+		checksum += Translation.x;
+	}
+	double curveNs = elapsedNs(start) / SAMPLE_COUNT;
+
+	printf("  evaluate pose %10.1f ns\n", evaluateNs);
+	printf("  root curve    %10.1f ns (%.0fx)\n", curveNs, evaluateNs / curveNs);
+	printf("  max translation error %f (checksum %f)\n\n", maxError, checksum);
+}
+
+void Run()
+{
+	benchmarkClip("../../Phoenix/RendererOpenGL/App/Resources/Objects/guard/boblampclean.md5anim");
+	benchmarkClip("../../Phoenix/RendererOpenGL/App/Resources/Objects/Walking.fbx");
+	benchmarkClip("../../Phoenix/RendererOpenGL/App/Resources/Objects/Jumping.fbx");
+
+	benchmarkCrowd("../../Phoenix/RendererOpenGL/App/Resources/Objects/guard/boblampclean.md5mesh");
+	benchmarkCrowd("../../Phoenix/RendererOpenGL/App/Resources/Objects/Jumping.fbx");
+
+	benchmarkBlending("../../Phoenix/RendererOpenGL/App/Resources/Objects/Walking.fbx");
+
+	benchmarkLod("../../Phoenix/RendererOpenGL/App/Resources/Objects/guard/boblampclean.md5mesh");
+
+	benchmarkRootMotion("../../Phoenix/RendererOpenGL/App/Resources/Objects/Walking.fbx");
+	benchmarkRootMotion("../../Phoenix/RendererOpenGL/App/Resources/Objects/guard/boblampclean.md5anim");
+}
+
+#endif
\ No newline at end of file
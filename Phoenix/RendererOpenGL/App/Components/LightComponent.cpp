@@ -13,7 +13,5 @@ LightComponent::~LightComponent()
 }
 
 START_REGISTRATION(LightComponent)
-/*
-DEFINE_VARIABLE(ModelComponent, x)
-DEFINE_VARIABLE(ModelComponent, y)
-*/
\ No newline at end of file
+
+DEFINE_VARIABLE(LightComponent, light)
\ No newline at end of file
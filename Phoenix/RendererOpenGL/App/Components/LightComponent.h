@@ -24,5 +24,5 @@ END
 
 
 REGISTER_COMPONENT_CLASS(LightComponent)
-	// register variables
+	REGISTER_VARIABLE(light)
 END
\ No newline at end of file
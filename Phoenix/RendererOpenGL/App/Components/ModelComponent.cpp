@@ -12,6 +12,19 @@ ModelComponent::~ModelComponent()
 	delete pModel;
 }
 
+// component pools relocate their elements, the mesh is owned by whichever copy holds it
+ModelComponent::ModelComponent(ModelComponent&& other) : filepath(other.filepath), pModel(other.pModel)
+{
+	other.pModel = NULL;
+}
+
+ModelComponent& ModelComponent::operator=(ModelComponent&& other)
+{
+	std::swap(filepath, other.filepath);
+	std::swap(pModel, other.pModel);
+	return *this;
+}
+
 void ModelComponent::InitModel()
 {
 	if(filepath)
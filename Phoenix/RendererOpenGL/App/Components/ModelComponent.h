@@ -7,10 +7,13 @@ public:
 	ModelComponent();
 	~ModelComponent();
 
+	ModelComponent(ModelComponent&& other);
+	ModelComponent& operator=(ModelComponent&& other);
+
 	void InitModel();
 	void Draw(ShaderProgram program);
 
-	const char* filepath;
+	const char* filepath = NULL;
 	SkinnedMesh* pModel = NULL;
 END
 
@@ -0,0 +1,35 @@
+#include "TransformComponent.h"
+
+DEFINE_COMPONENT(TransformComponent)
+
+TransformComponent::TransformComponent() : position(0.0f), rotation(1.0f, 0.0f, 0.0f, 0.0f), scale(1.0f), world(1.0f)
+{
+}
+
+// translate * rotate * scale without going through three matrix products
+glm::mat4 TransformComponent::localMatrix() const
+{
+	glm::mat4 local = glm::mat4_cast(rotation);
+	local[0] *= scale.x;
+	local[1] *= scale.y;
+	local[2] *= scale.z;
+	local[3] = glm::vec4(position, 1.0f);
+	return local;
+}
+
+START_REGISTRATION(TransformComponent)
+
+DEFINE_VARIABLE(TransformComponent, position)
+DEFINE_VARIABLE(TransformComponent, rotation)
+DEFINE_VARIABLE(TransformComponent, scale)
+
+
+DEFINE_COMPONENT(HierarchyComponent)
+
+HierarchyComponent::HierarchyComponent() : parent(INVALID_ENTITY_ID), depth(0)
+{
+}
+
+START_REGISTRATION(HierarchyComponent)
+
+DEFINE_VARIABLE(HierarchyComponent, parent)
\ No newline at end of file
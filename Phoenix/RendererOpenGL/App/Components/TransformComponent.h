@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../../../../Middleware/ECS/Component.h"
+#include "../../../RendererOpenGL/RendererOpenGL.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+// Local transform relative to the parent in HierarchyComponent, or to the world without one.
+// Whoever edits position/rotation/scale calls EntityManager::markChanged<TransformComponent>,
+// the TransformSystem then recomputes world for the entity and everything below it.
+DECLARE_COMPONENT(TransformComponent)
+public:
+	TransformComponent();
+
+	glm::mat4 localMatrix() const;
+
+	glm::vec3 position;
+	glm::quat rotation;
+	glm::vec3 scale;
+
+	// written by the TransformSystem
+	glm::mat4 world;
+END
+
+
+REGISTER_COMPONENT_CLASS(TransformComponent)
+	REGISTER_VARIABLE(position)
+	REGISTER_VARIABLE(rotation)
+	REGISTER_VARIABLE(scale)
+END
+
+
+// Parent link of a transform, INVALID_ENTITY_ID makes it a root.
+// Reparenting goes through TransformSystem::SetParent (or markChanged<HierarchyComponent>).
+DECLARE_COMPONENT(HierarchyComponent)
+public:
+	HierarchyComponent();
+
+	EntityID parent;
+
+	// distance from the root, written by the TransformSystem
+	uint32 depth;
+END
+
+
+REGISTER_COMPONENT_CLASS(HierarchyComponent)
+	REGISTER_VARIABLE(parent)
+END
\ No newline at end of file
@@ -229,11 +229,15 @@ void Run()
 	ShaderProgram shaderLightBox("../../Phoenix/RendererOpenGL/App/Resources/Shaders/deferred_light_box.vert",
 								 "../../Phoenix/RendererOpenGL/App/Resources/Shaders/deferred_light_box.frag");
 
-	// load models
+	// load models, read and decoded on the workers, uploaded a few ms per frame so the
+	// scene fills in while the window is already up
 	// -----------
+	JobSystem jobSystem;
+	AssetLoader loader(&jobSystem);
+
 #if SCENE_SPONZA
 	SkinnedMesh myModel;
-	myModel.LoadMesh("../../Phoenix/RendererOpenGL/App/Resources/Objects/sponza/sponza.obj");
+	loader.LoadMesh(&myModel, "../../Phoenix/RendererOpenGL/App/Resources/Objects/sponza/sponza.obj");
 
 	glUseProgram(shaderGeometryPass.mId);
 	glm::mat4 model = glm::mat4(1.0f);
@@ -246,7 +250,7 @@ void Run()
 
 #if SCENE_NANOSUIT
 	SkinnedMesh myModel;
-	myModel.LoadMesh("../../Phoenix/RendererOpenGL/App/Resources/Objects/nanosuit/nanosuit.obj", 9);
+	loader.LoadMesh(&myModel, "../../Phoenix/RendererOpenGL/App/Resources/Objects/nanosuit/nanosuit.obj", 9);
 	tinystl::vector<glm::vec3> objectPositions;
 	objectPositions.push_back(glm::vec3(-3.0, -3.0, -3.0));
 	objectPositions.push_back(glm::vec3(0.0, -3.0, -3.0));
@@ -258,27 +262,56 @@ void Run()
 	objectPositions.push_back(glm::vec3(0.0, -3.0, 3.0));
 	objectPositions.push_back(glm::vec3(3.0, -3.0, 3.0));
 
-	// instance vertex buffer
+	// instance vertex buffer, filled once the loader has created it
 	const uint32_t total_nanosuits = (uint32_t)objectPositions.size();
+	tinystl::vector<glm::mat4> nanoModels(total_nanosuits);
+	for (uint32_t i = 0; i < total_nanosuits; ++i)
 	{
-		tinystl::vector<glm::mat4> nanoModels(total_nanosuits);
+		nanoModels[i] = glm::mat4(1.0f);
+		nanoModels[i] = glm::translate(nanoModels[i], objectPositions[i]);
+		nanoModels[i] = glm::scale(nanoModels[i], glm::vec3(0.25f));
+	}
+	bool instancesUploaded = false;
+
+	int instanced = 1;
+	glUseProgram(shaderGeometryPass.mId);
+	shaderGeometryPass.SetUniform("instanced", &instanced);
+#endif
+
+	// animated guards, skinned into world space once per frame and written to the
+	// g-buffer like static geometry, the geometry pass shader stays as it is
+	const uint32_t NR_GUARDS = 9;
+	const char* feedbackVaryings[] = { "SkinnedPosition", "SkinnedNormal", "SkinnedTexCoord" };
+	ShaderProgram skinningFeedback("../../Phoenix/RendererOpenGL/App/Resources/Shaders/skinning_feedback.vert", feedbackVaryings, 3);
 
-		for (uint32_t i = 0; i < total_nanosuits; ++i)
+	SkinnedMesh guards;
+	guards.LoadMesh("../../Phoenix/RendererOpenGL/App/Resources/Objects/guard/boblampclean.md5mesh", NR_GUARDS);
+	guards.EnablePreSkinning();
+	{
+		tinystl::vector<glm::mat4> guardModels(NR_GUARDS);
+		for (uint32_t i = 0; i < NR_GUARDS; ++i)
 		{
-			nanoModels[i] = glm::mat4(1.0f);
-			nanoModels[i] = glm::translate(nanoModels[i], objectPositions[i]);
-			nanoModels[i] = glm::scale(nanoModels[i], glm::vec3(0.25f));
+			guardModels[i] = glm::mat4(1.0f);
+#if SCENE_SPONZA
+			guardModels[i] = glm::translate(guardModels[i], glm::vec3(-0.5f + 0.5f * (i % 3), -2.0f, -3.0f + 3.0f * (i / 3)));
+#endif
+#if SCENE_NANOSUIT
+			guardModels[i] = glm::translate(guardModels[i], glm::vec3(-1.5f + 3.0f * (i % 3), -3.0f, -1.5f + 3.0f * (i / 3)));
+#endif
+			guardModels[i] = glm::rotate(guardModels[i], glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+			guardModels[i] = glm::scale(guardModels[i], glm::vec3(0.02f));
 		}
 
-		glBindBuffer(GL_ARRAY_BUFFER, myModel.instanceVBO);
-		glBufferData(GL_ARRAY_BUFFER, total_nanosuits * sizeof(glm::mat4), nanoModels.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, guards.instanceVBO);
+		glBufferData(GL_ARRAY_BUFFER, NR_GUARDS * sizeof(glm::mat4), guardModels.data(), GL_STATIC_DRAW);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
-	int instanced = 1;
-	glUseProgram(shaderGeometryPass.mId);
-	shaderGeometryPass.SetUniform("instanced", &instanced);
-#endif
+	BonePaletteBuffer bonePalette(NR_GUARDS * guards.NumBones());
+	AnimationPose guardPose;
+	std::vector<aiMatrix4x4> guardGlobals(guards.Animations().GetSkeleton().NodeCount());
+	bool drawGuards = true;
+	float timer = 0.0f;
 
 	// configure g-buffer framebuffer
 	// ------------------------------
@@ -327,7 +360,7 @@ void Run()
 	unsigned int uboLightsBlock;
 	glGenBuffers(1, &uboLightsBlock);
 	glBindBuffer(GL_UNIFORM_BUFFER, uboLightsBlock);
-	glBufferData(GL_UNIFORM_BUFFER, lightBlockSize * NR_LIGHTS, NULL, GL_STATIC_DRAW);
+	glBufferData(GL_UNIFORM_BUFFER, lightBlockSize * NR_LIGHTS, lights.data(), GL_DYNAMIC_DRAW);
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 	// define the range of the buffer that links to a uniform binding point
 	glBindBufferRange(GL_UNIFORM_BUFFER, 0, uboLightsBlock, 0, lightBlockSize * NR_LIGHTS);
@@ -345,6 +378,22 @@ void Run()
 	while (!window.windowShouldClose() && !exitOnESC)
 	{
 		window.startFrame();
+		timer += window.frameTime();
+
+		bool loading = !loader.IsIdle();
+		loader.Update();
+		if (loading && loader.IsIdle())
+			loader.PrintStats();
+
+#if SCENE_NANOSUIT
+		if (!instancesUploaded && myModel.IsLoaded())
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, myModel.instanceVBO);
+			glBufferData(GL_ARRAY_BUFFER, total_nanosuits * sizeof(glm::mat4), nanoModels.data(), GL_STATIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			instancesUploaded = true;
+		}
+#endif
 
 		window.beginGuiFrame();
 		bool truebool = true;
@@ -363,6 +412,35 @@ void Run()
 		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)window.windowWidth() / (float)window.windowHeight(), 0.1f, 100.0f);
 		glm::mat4 view = camera.GetViewMatrix();
 
+		// 0. skin every guard, each one a bit further into the clip
+		// ----------------------------------------------------------
+		if (drawGuards)
+		{
+			bonePalette.BeginFrame();
+			aiMatrix4x4* pPalette;
+			int paletteBase = (int)bonePalette.Allocate(NR_GUARDS * guards.NumBones(), &pPalette);
+			for (uint32_t i = 0; i < NR_GUARDS; ++i)
+			{
+				AnimationInstance instance = { 0, timer / 1000.0f + 0.37f * i };
+				guards.Animations().EvaluatePose(instance, guardPose, guardGlobals.data());
+				memcpy(pPalette + i * guards.NumBones(), guardPose.skinning.data(), sizeof(aiMatrix4x4) * guards.NumBones());
+			}
+			bonePalette.Commit();
+
+			glUseProgram(skinningFeedback.mId);
+			bonePalette.Bind(skinningFeedback);
+
+			int boneCount = (int)guards.NumBones();
+			int isInstanced = 1;
+			skinningFeedback.SetUniform("gPaletteBase", &paletteBase);
+			skinningFeedback.SetUniform("gBoneCount", &boneCount);
+			skinningFeedback.SetUniform("isInstanced", &isInstanced);
+			skinningFeedback.SetUniform("isAnim", &guards.mIsAnim);
+
+			guards.PreSkin();
+			bonePalette.EndFrame();
+		}
+
 		// 1. geometry pass: render scene's geometry/color data into gbuffer
 		// -----------------------------------------------------------------
 		glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
@@ -371,6 +449,24 @@ void Run()
 		shaderGeometryPass.SetUniform("projection", &projection);
 		shaderGeometryPass.SetUniform("view", &view);
 		myModel.Render(shaderGeometryPass);
+
+		if (drawGuards)
+		{
+			// already in world space
+			glm::mat4 identity = glm::mat4(1.0f);
+			int notInstanced = 0;
+			shaderGeometryPass.SetUniform("model", &identity);
+			shaderGeometryPass.SetUniform("instanced", &notInstanced);
+
+			guards.RenderPreSkinned(shaderGeometryPass);
+
+#if SCENE_SPONZA
+			shaderGeometryPass.SetUniform("model", &model);
+#endif
+#if SCENE_NANOSUIT
+			shaderGeometryPass.SetUniform("instanced", &instanced);
+#endif
+		}
 		
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
@@ -385,20 +481,18 @@ void Run()
 		glActiveTexture(GL_TEXTURE2);
 		glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
 
-		// send light relevant uniforms
+		// send light relevant uniforms, the block only changes with the attenuation sliders
+		if (linear != prevLinear || quadratic != prevQuadratic)
 		{
-			glBindBuffer(GL_UNIFORM_BUFFER, uboLightsBlock);
-			
-			if (linear != prevLinear || quadratic != prevQuadratic)
+			for (uint64_t i = 0; i < lights.size(); ++i)
 			{
-				for (uint64_t i = 0; i < lights.size(); ++i)
-				{
-					lights[i].Linear	= linear;
-					lights[i].Quadratic = quadratic;
-				}
-				prevLinear	  = linear;
-				prevQuadratic = quadratic;
+				lights[i].Linear	= linear;
+				lights[i].Quadratic = quadratic;
 			}
+			prevLinear	  = linear;
+			prevQuadratic = quadratic;
+
+			glBindBuffer(GL_UNIFORM_BUFFER, uboLightsBlock);
 			glBufferSubData(GL_UNIFORM_BUFFER, 0, lightBlockSize * NR_LIGHTS, lights.data());
 			glBindBuffer(GL_UNIFORM_BUFFER, 0);
 		}
@@ -441,6 +535,13 @@ void Run()
 		str = "actual fps: " + std::to_string(window.actualFrameRate());
 		ImGui::Text(str.c_str());
 
+		ImGui::Checkbox("Draw Guards", &drawGuards);
+
+		const AssetLoader::Stats& loadStats = loader.GetStats();
+		str = "loaded " + std::to_string(loadStats.meshCount) + " meshes, " + std::to_string(loadStats.textureCount) + " textures in " +
+			  std::to_string((int)loadStats.wallMs) + " ms, longest frame " + std::to_string(loadStats.maxFrameMs) + " ms";
+		ImGui::Text(str.c_str());
+
 		ImGui::End();
 
 		window.endGuiFrame();
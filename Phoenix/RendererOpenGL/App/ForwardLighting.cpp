@@ -9,6 +9,10 @@ glm::vec3 lightPos(-10.0f, 8.0f, -10.0f);
 
 OpenGLRenderer* pOpenGLRenderer = NULL;
 
+// skinned once per frame, both passes draw the result
+SkinnedMesh* pGuard = NULL;
+bool drawGuard = true;
+
 void RenderScene(ShaderProgram& shader)
 {
 	glm::mat4 model = glm::mat4(1.0f);
@@ -22,6 +26,15 @@ void RenderScene(ShaderProgram& shader)
 	shader.SetUniform("model", &model);
 
 	pOpenGLRenderer->RenderCube();
+
+	if (drawGuard)
+	{
+		model = glm::mat4(1.0f);
+		shader.SetUniform("model", &model);
+
+		// neither pass samples material textures, and unit 0 holds the shadow map
+		pGuard->RenderPreSkinned(shader, false);
+	}
 }
 
 void Run()
@@ -47,6 +60,21 @@ void Run()
 
 	ShaderProgram debugDepthQuad("../../Phoenix/RendererOpenGL/App/Resources/Shaders/shadow_debug.vert",
 								 "../../Phoenix/RendererOpenGL/App/Resources/Shaders/shadow_debug.frag");
+
+	const char* feedbackVaryings[] = { "SkinnedPosition", "SkinnedNormal", "SkinnedTexCoord" };
+	ShaderProgram skinningFeedback("../../Phoenix/RendererOpenGL/App/Resources/Shaders/skinning_feedback.vert", feedbackVaryings, 3);
+
+	SkinnedMesh guard;
+	guard.LoadMesh("../../Phoenix/RendererOpenGL/App/Resources/Objects/guard/boblampclean.md5mesh");
+	guard.EnablePreSkinning();
+	pGuard = &guard;
+
+	BonePaletteBuffer bonePalette(guard.NumBones());
+
+	glm::mat4 guardModel = glm::mat4(1.0f);
+	guardModel = glm::translate(guardModel, glm::vec3(3.0f, 0.5f, 0.0f));
+	guardModel = glm::rotate(guardModel, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+	guardModel = glm::scale(guardModel, glm::vec3(0.05f, 0.05f, 0.05f));
 	// configure depth map FBO
 	// -----------------------
 	const unsigned int SHADOW_WIDTH = 2048, SHADOW_HEIGHT = 2048;
@@ -79,9 +107,11 @@ void Run()
 
 	window.initGui();
 
+	float timer = 0.0f;
 	while (!window.windowShouldClose() && !exitOnESC)
 	{
 		window.startFrame();
+		timer += window.frameTime();
 
 		{
 			float near_plane = 0.1f, far_plane = 100.0f;
@@ -92,6 +122,31 @@ void Run()
 			glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		
+			// 0. skin the guard into world space, once for the shadow and the lighting pass
+			// ------------------------------------------------------------------------------
+			if (drawGuard)
+			{
+				bonePalette.BeginFrame();
+				tinystl::vector<aiMatrix4x4> Transforms, BoneTransforms;
+				guard.BoneTransform(timer / 1000.0f, Transforms, BoneTransforms);
+				int paletteBase = (int)bonePalette.Upload(Transforms.data(), (uint32_t)Transforms.size());
+				bonePalette.Commit();
+
+				glUseProgram(skinningFeedback.mId);
+				bonePalette.Bind(skinningFeedback);
+
+				int boneCount = (int)guard.NumBones();
+				int isInstanced = 0;
+				skinningFeedback.SetUniform("gPaletteBase", &paletteBase);
+				skinningFeedback.SetUniform("gBoneCount", &boneCount);
+				skinningFeedback.SetUniform("isInstanced", &isInstanced);
+				skinningFeedback.SetUniform("isAnim", &guard.mIsAnim);
+				skinningFeedback.SetUniform("model", &guardModel);
+
+				guard.PreSkin();
+				bonePalette.EndFrame();
+			}
+
 			// 1. render depth of scene to texture (from light's perspective)
 			// --------------------------------------------------------------
 			glm::mat4 lightProjection, lightView;
@@ -176,6 +231,8 @@ void Run()
 				
 				str = "actual fps: " + std::to_string(window.actualFrameRate());
 				ImGui::Text(str.c_str());
+
+				ImGui::Checkbox("Draw Guard", &drawGuard);
 				ImGui::End();
 
 				window.endGuiFrame();
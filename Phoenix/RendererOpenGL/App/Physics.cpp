@@ -4,16 +4,25 @@
 
 #include "../Common.h"
 #include "../../Middleware/ECS/EntityManager.h"
+#include "../../Middleware/ECS/SystemScheduler.h"
+#include "../../Middleware/Jobs/JobSystem.h"
 
 #include "Components/ModelComponent.h"
 
 #include "Components/LightComponent.h"
+#include "Components/TransformComponent.h"
 #include "Systems/LightingSystem.h"
+#include "Systems/LightAttenuationSystem.h"
+#include "Systems/TransformSystem.h"
 
 EntityManager* pEntityManager = NULL;
 OpenGLRenderer* pOpenGLRenderer = NULL;
 
+JobSystem* pJobSystem = NULL;
+SystemScheduler* pSystemScheduler = NULL;
 LightingSystem* pLightingSystem = NULL;
+LightAttenuationSystem* pLightAttenuationSystem = NULL;
+TransformSystem* pTransformSystem = NULL;
 
 const unsigned int NR_LIGHTS = 100;
 EntityID lights[NR_LIGHTS];
@@ -83,6 +92,15 @@ void Init()
 	pEntityManager = new EntityManager();
 	pOpenGLRenderer = new OpenGLRenderer();
 	pLightingSystem = new LightingSystem(pEntityManager);
+	pLightAttenuationSystem = new LightAttenuationSystem(pEntityManager);
+	pTransformSystem = new TransformSystem(pEntityManager);
+
+	// attenuation writes the lights the lighting system uploads, so they run in this order
+	pJobSystem = new JobSystem();
+	pSystemScheduler = new SystemScheduler(pJobSystem);
+	pSystemScheduler->RegisterSystem(pLightAttenuationSystem);
+	pSystemScheduler->RegisterSystem(pLightingSystem);
+	pSystemScheduler->RegisterSystem(pTransformSystem);
 
 	EntityID sponzaId = pEntityManager->createEntity();
 	Entity* pSponza = pEntityManager->getEntityByID(sponzaId);
@@ -93,6 +111,12 @@ void Init()
 	pSponzaModel->filepath = "../../Phoenix/RendererOpenGL/App/Resources/Objects/sponza/sponza.obj";
 	pSponzaModel->InitModel();
 
+	pEntityManager->addComponent<TransformComponent>(sponzaId);
+	TransformComponent* pSponzaTransform = pSponza->GetComponent<TransformComponent>();
+	pSponzaTransform->position = glm::vec3(0.0f, -2.0f, 0.0f);
+	pSponzaTransform->rotation = glm::angleAxis(glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	pSponzaTransform->scale = glm::vec3(0.01f);
+
 	// SHADERS
 	shaderGeometryPass = new ShaderProgram("../../Phoenix/RendererOpenGL/App/Resources/Shaders/g_buffer.vert",
 										   "../../Phoenix/RendererOpenGL/App/Resources/Shaders/g_buffer.frag");
@@ -131,7 +155,7 @@ void Init()
 		pLightComp->light.pad0 = pLightComp->light.pad1 = pLightComp->light.pad2 = pLightComp->light.pad3 = 0.0f;
 	}
 
-	pLightingSystem->AddLights(lights, NR_LIGHTS);
+	pLightingSystem->AddLights();
 
 
 	// shader configuration
@@ -142,17 +166,6 @@ void Init()
 	shaderLightingPass->SetUniform("gNormal", &one);
 	shaderLightingPass->SetUniform("gAlbedoSpec", &two);
 
-	{
-		glUseProgram(shaderGeometryPass->mId);
-
-		glm::mat4 model = glm::mat4(1.0f);
-		model = glm::mat4(1.0f);
-		model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-		model = glm::translate(model, glm::vec3(0.0, -2.0, 0.0));
-		model = glm::scale(model, glm::vec3(0.01f));
-		shaderGeometryPass->SetUniform("model", &model);
-	}
-
 	window.initGui();
 }
 
@@ -161,7 +174,11 @@ void Exit()
 	window.exitGui();
 	window.exitWindow();
 
+	delete pSystemScheduler;
+	delete pJobSystem;
+	delete pLightAttenuationSystem;
 	delete pLightingSystem;
+	delete pTransformSystem;
 	delete pOpenGLRenderer;
 	delete pEntityManager;
 	delete shaderGeometryPass;
@@ -171,7 +188,11 @@ void Exit()
 
 void Update()
 {
+	pLightAttenuationSystem->linear = linear;
+	pLightAttenuationSystem->quadratic = quadratic;
 
+	pEntityManager->beginFrame();
+	pSystemScheduler->Run(window.frameTime() / 1000.0f);
 }
 
 void Draw()
@@ -187,6 +208,15 @@ void Draw()
 
 	ImGui::End();
 
+	// GUI - ECS MEMORY
+	EntityManagerMemoryStats memoryStats = pEntityManager->memoryStats();
+	ImGui::Begin("ECS MEMORY", &truebool);
+	ImGui::Text("entities        live %8u KB  peak %8u KB  allocs/frame %u", (uint32)(memoryStats.entities.bytesLive / 1024), (uint32)(memoryStats.entities.highWaterMark / 1024), memoryStats.entities.allocationsLastFrame);
+	ImGui::Text("components      live %8u KB  peak %8u KB  allocs/frame %u", (uint32)(memoryStats.components.bytesLive / 1024), (uint32)(memoryStats.components.highWaterMark / 1024), memoryStats.components.allocationsLastFrame);
+	ImGui::Text("representations live %8u KB  peak %8u KB  allocs/frame %u", (uint32)(memoryStats.representations.bytesLive / 1024), (uint32)(memoryStats.representations.highWaterMark / 1024), memoryStats.representations.allocationsLastFrame);
+	ImGui::Text("frame arena     used %8u KB  peak %8u KB  allocs/frame %u", (uint32)(memoryStats.frameArena.bytesLive / 1024), (uint32)(memoryStats.frameArena.highWaterMark / 1024), memoryStats.frameArena.allocationsLastFrame);
+	ImGui::End();
+
 	glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -202,12 +232,11 @@ void Draw()
 	shaderGeometryPass->SetUniform("view", &view);
 	
 	//pSponzaModel->Draw(*shaderGeometryPass);
-	std::list<Component*> modelComps = pEntityManager->GetComponents(ModelComponent::getTypeStatic());
-	for (std::list<Component*>::iterator it = modelComps.begin(); it != modelComps.end(); ++it)
+	pEntityManager->view<ModelComponent, TransformComponent>().each([](EntityID id, ModelComponent& modelComp, TransformComponent& transform)
 	{
-		ModelComponent* pModelComp = static_cast<ModelComponent*>(*it);
-		pModelComp->Draw(*shaderGeometryPass);
-	}
+		shaderGeometryPass->SetUniform("model", &transform.world);
+		modelComp.Draw(*shaderGeometryPass);
+	});
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
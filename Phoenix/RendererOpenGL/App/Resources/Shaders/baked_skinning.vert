@@ -0,0 +1,59 @@
+#version 330
+
+layout (location = 0) in vec3 Position;
+layout (location = 1) in vec3 Normal;
+layout (location = 2) in vec2 TexCoord;
+layout (location = 3) in ivec4 BoneIDs;
+layout (location = 4) in vec4 Weights;
+layout (location = 5) in mat4 instanceModel; // bottom row holds the time offset, see BakedAnimation
+
+out vec2 TexCoord0;
+out vec3 Normal0;
+out vec3 WorldPos0;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// frame f of the clip is row f, three texels per bone, row gBakedFrameCount repeats row 0
+uniform sampler2D gBakedBones;
+uniform int gBakedFrameCount;
+uniform float gBakedFrameRate;
+uniform float gTime;
+
+mat4 bakedMatrix(int bone, int frame)
+{
+	int texel = bone * 3;
+	return transpose(mat4(texelFetch(gBakedBones, ivec2(texel, frame), 0),
+						  texelFetch(gBakedBones, ivec2(texel + 1, frame), 0),
+						  texelFetch(gBakedBones, ivec2(texel + 2, frame), 0),
+						  vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+mat4 boneMatrix(int bone, int frame, float blend)
+{
+	return mix(bakedMatrix(bone, frame), bakedMatrix(bone, frame + 1), blend);
+}
+
+void main()
+{
+	mat4 World = instanceModel;
+	float timeOffset = World[0][3];
+	World[0][3] = 0.0;
+
+	float frame = mod((gTime + timeOffset) * gBakedFrameRate, float(gBakedFrameCount));
+	int frame0 = min(int(frame), gBakedFrameCount - 1);
+	float blend = frame - float(frame0);
+
+	mat4 BoneTransform  = boneMatrix(BoneIDs[0], frame0, blend) * Weights[0];
+	BoneTransform      += boneMatrix(BoneIDs[1], frame0, blend) * Weights[1];
+	BoneTransform      += boneMatrix(BoneIDs[2], frame0, blend) * Weights[2];
+	BoneTransform      += boneMatrix(BoneIDs[3], frame0, blend) * Weights[3];
+
+	vec4 PosL    = BoneTransform * vec4(Position, 1.0);
+	vec4 NormalL = BoneTransform * vec4(Normal, 0.0);
+
+	gl_Position = projection * view * World * PosL;
+	TexCoord0   = TexCoord;
+	Normal0     = (World * NormalL).xyz;
+	WorldPos0   = (World * PosL).xyz;
+}
\ No newline at end of file
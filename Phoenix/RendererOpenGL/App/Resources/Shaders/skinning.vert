@@ -5,32 +5,48 @@ layout (location = 1) in vec3 Normal;
 layout (location = 2) in vec2 TexCoord;                                             
 layout (location = 3) in ivec4 BoneIDs;
 layout (location = 4) in vec4 Weights;
+layout (location = 5) in mat4 instanceModel;
 
 out vec2 TexCoord0;
 out vec3 Normal0;                                                                   
 out vec3 WorldPos0;                                                                 
 
-const int MAX_BONES = 100;
-
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
-uniform mat4 gBones[MAX_BONES];
+// every skinned draw of the frame shares one palette buffer, a draw's matrices
+// start at gPaletteBase and every instance owns gBoneCount of them
+uniform samplerBuffer gBonePalette;
+uniform int gPaletteBase;
+uniform int gBoneCount;
 
 uniform bool isAnim;
+uniform bool isInstanced;
+
+mat4 boneMatrix(int bone)
+{
+	// stored as aiMatrix4x4, one row per texel
+	int texel = (gPaletteBase + gl_InstanceID * gBoneCount + bone) * 4;
+	return transpose(mat4(texelFetch(gBonePalette, texel),
+						  texelFetch(gBonePalette, texel + 1),
+						  texelFetch(gBonePalette, texel + 2),
+						  texelFetch(gBonePalette, texel + 3)));
+}
 
 void main()
 {       
+	mat4 World = isInstanced ? instanceModel : model;
+
 	vec4 PosL = vec4(0.0, 0.0, 0.0, 0.0);
 
 	mat4 BoneTransform;
 	if(isAnim)
 	{
-		BoneTransform = gBones[BoneIDs[0]] * Weights[0];
-		BoneTransform     += gBones[BoneIDs[1]] * Weights[1];
-		BoneTransform     += gBones[BoneIDs[2]] * Weights[2];
-		BoneTransform     += gBones[BoneIDs[3]] * Weights[3];
+		BoneTransform = boneMatrix(BoneIDs[0]) * Weights[0];
+		BoneTransform     += boneMatrix(BoneIDs[1]) * Weights[1];
+		BoneTransform     += boneMatrix(BoneIDs[2]) * Weights[2];
+		BoneTransform     += boneMatrix(BoneIDs[3]) * Weights[3];
 		
 		PosL = BoneTransform * vec4(Position, 1.0);
 	}
@@ -39,17 +55,17 @@ void main()
 		PosL = vec4(Position, 1.0);
 	}
 
-    gl_Position  = projection * view * model * PosL;
+    gl_Position  = projection * view * World * PosL;
     TexCoord0    = TexCoord;
 	if(isAnim)
 	{
 		vec4 NormalL = BoneTransform * vec4(Normal, 0.0);
-		Normal0      = (model * NormalL).xyz;
+		Normal0      = (World * NormalL).xyz;
 	}
 	else
 	{
 		vec4 NormalL = vec4(Normal, 0.0);
-		Normal0      = (model * NormalL).xyz;
+		Normal0      = (World * NormalL).xyz;
 	}
-    WorldPos0    = (model * PosL).xyz;
+    WorldPos0    = (World * PosL).xyz;
 }
\ No newline at end of file
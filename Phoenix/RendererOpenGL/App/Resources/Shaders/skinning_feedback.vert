@@ -0,0 +1,51 @@
+#version 330
+
+layout (location = 0) in vec3 Position;
+layout (location = 1) in vec3 Normal;
+layout (location = 2) in vec2 TexCoord;
+layout (location = 3) in ivec4 BoneIDs;
+layout (location = 4) in vec4 Weights;
+layout (location = 5) in mat4 instanceModel;
+
+// captured with transform feedback, interleaved in this order; nothing is rasterized
+out vec3 SkinnedPosition;
+out vec3 SkinnedNormal;
+out vec2 SkinnedTexCoord;
+
+uniform mat4 model;
+
+// same palette layout as skinning.vert
+uniform samplerBuffer gBonePalette;
+uniform int gPaletteBase;
+uniform int gBoneCount;
+
+uniform bool isAnim;
+uniform bool isInstanced;
+
+mat4 boneMatrix(int bone)
+{
+	int texel = (gPaletteBase + gl_InstanceID * gBoneCount + bone) * 4;
+	return transpose(mat4(texelFetch(gBonePalette, texel),
+						  texelFetch(gBonePalette, texel + 1),
+						  texelFetch(gBonePalette, texel + 2),
+						  texelFetch(gBonePalette, texel + 3)));
+}
+
+void main()
+{
+	mat4 World = isInstanced ? instanceModel : model;
+
+	mat4 BoneTransform = mat4(1.0);
+	if(isAnim)
+	{
+		BoneTransform  = boneMatrix(BoneIDs[0]) * Weights[0];
+		BoneTransform += boneMatrix(BoneIDs[1]) * Weights[1];
+		BoneTransform += boneMatrix(BoneIDs[2]) * Weights[2];
+		BoneTransform += boneMatrix(BoneIDs[3]) * Weights[3];
+	}
+
+	// world space, the passes reading this draw it with an identity model matrix
+	SkinnedPosition = (World * BoneTransform * vec4(Position, 1.0)).xyz;
+	SkinnedNormal   = (World * BoneTransform * vec4(Normal, 0.0)).xyz;
+	SkinnedTexCoord = TexCoord;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "LightAttenuationSystem.h"
+#include "../Components/LightComponent.h"
+
+#include "../../../../Middleware/ECS/EntityManager.h"
+
+LightAttenuationSystem::LightAttenuationSystem(EntityManager* pEM) : System(pEM)
+{
+	Writes<LightComponent>();
+}
+
+void LightAttenuationSystem::Update(float dt)
+{
+	if (linear == appliedLinear && quadratic == appliedQuadratic)
+		return;
+
+	float newLinear = linear, newQuadratic = quadratic;
+	EntityManager* pEM = pEntityManager;
+	pEntityManager->view<LightComponent>().each([pEM, newLinear, newQuadratic](EntityID id, LightComponent& lightComp)
+	{
+		lightComp.light.Linear = newLinear;
+		lightComp.light.Quadratic = newQuadratic;
+		pEM->markChanged<LightComponent>(id);
+	});
+
+	appliedLinear = newLinear;
+	appliedQuadratic = newQuadratic;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../../../../Middleware/ECS/System.h"
+
+class EntityManager;
+class LightAttenuationSystem : public System
+{
+public:
+	LightAttenuationSystem(EntityManager* pEM);
+
+	// applies linear and quadratic to every light when they change
+	virtual void Update(float dt) override;
+
+	float linear = -10.0f;
+	float quadratic = 19.1f;
+
+private:
+	float appliedLinear = -10.0f;
+	float appliedQuadratic = 19.1f;
+};
@@ -10,38 +10,61 @@ struct instancedData
 	glm::vec3 lightColor;
 };
 
-unsigned int uboLightsBlock;
-unsigned int instanceVBO;
-tinystl::vector<instancedData> mInstanceData;
+unsigned int uboLightsBlock = 0;
+unsigned int instanceVBO = 0;
 
 tinystl::vector<LightBlock> mLights;
 
+LightingSystem::LightingSystem(EntityManager* pEM) : System(pEM)
+{
+	Reads<LightComponent>();
+	RunOnMainThread();
+}
+
 LightingSystem::~LightingSystem()
 {
 	glDeleteBuffers(1, &uboLightsBlock);
+	glDeleteBuffers(1, &instanceVBO);
+}
+
+static instancedData makeInstanceData(const LightBlock& lightBlock)
+{
+	instancedData instanceData;
+	instanceData.lightModel = glm::mat4(1.0f);
+	instanceData.lightModel = glm::translate(instanceData.lightModel, glm::vec3(lightBlock.lightPosition.x, lightBlock.lightPosition.y, lightBlock.lightPosition.z));
+	instanceData.lightModel = glm::scale(instanceData.lightModel, glm::vec3(0.03f));
+	instanceData.lightColor = lightBlock.lightColor;
+	return instanceData;
 }
 
-void LightingSystem::AddLights(uint32_t* lights, uint64_t noOfLights)
+void LightingSystem::AddLights()
 {
-	for (uint64_t i = 0; i < noOfLights; ++i)
+	ComponentPool<LightComponent>* pLightPool = pEntityManager->getPool<LightComponent>();
+	if (!pLightPool)
+		return;
+
+	uint64_t noOfLights = pLightPool->size();
+	mLights.clear();
+	mLights.reserve(noOfLights);
+
+	// instance data only lives until it is uploaded
+	instancedData* pInstanceData = pEntityManager->frameArena().allocateArray<instancedData>((uint32_t)noOfLights);
+
+	// light components are packed in one array, stream over them linearly
+	for (LightComponent& lightComp : *pLightPool)
 	{
-		Entity* pLight = pEntityManager->getEntityByID(lights[i]);
-		LightBlock lightBlock = pLight->GetComponent<LightComponent>()->light;
-		mLights.push_back(lightBlock);
-		
-		instancedData instanceData;
-		instanceData.lightModel = glm::mat4(1.0f);
-		instanceData.lightModel = glm::translate(instanceData.lightModel, glm::vec3(lightBlock.lightPosition.x, lightBlock.lightPosition.y, lightBlock.lightPosition.z));
-		instanceData.lightModel = glm::scale(instanceData.lightModel, glm::vec3(0.03f));
-		instanceData.lightColor = lightBlock.lightColor;
-		mInstanceData.push_back(instanceData);
+		pInstanceData[mLights.size()] = makeInstanceData(lightComp.light);
+		mLights.push_back(lightComp.light);
 	}
 
+	glDeleteBuffers(1, &uboLightsBlock);
+	glDeleteBuffers(1, &instanceVBO);
+
 	// lights uniform buffer block
 	int64_t lightBlockSize = sizeof(LightBlock);
 	glGenBuffers(1, &uboLightsBlock);
 	glBindBuffer(GL_UNIFORM_BUFFER, uboLightsBlock);
-	glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)lightBlockSize * noOfLights, mLights.data(), GL_STATIC_DRAW);
+	glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)lightBlockSize * noOfLights, mLights.data(), GL_DYNAMIC_DRAW);
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 	// define the range of the buffer that links to a uniform binding point
 	glBindBufferRange(GL_UNIFORM_BUFFER, 0, uboLightsBlock, 0, (GLsizeiptr)(lightBlockSize * noOfLights));
@@ -49,7 +72,7 @@ void LightingSystem::AddLights(uint32_t* lights, uint64_t noOfLights)
 	// lights instancing buffer
 	glGenBuffers(1, &instanceVBO);
 	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-	glBufferData(GL_ARRAY_BUFFER, noOfLights * sizeof(instancedData), mInstanceData.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, noOfLights * sizeof(instancedData), pInstanceData, GL_DYNAMIC_DRAW);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 	/*
@@ -81,4 +104,58 @@ void LightingSystem::AddLights(uint32_t* lights, uint64_t noOfLights)
 	}
 	glBindVertexArray(0);
 	*/
+}
+
+void LightingSystem::Update(float dt)
+{
+	ComponentPool<LightComponent>* pLightPool = pEntityManager->getPool<LightComponent>();
+	if (!pLightPool)
+		return;
+
+	// buffers mirror the packed pool, a light was added or removed so rebuild them
+	if (pLightPool->size() != mLights.size())
+	{
+		AddLights();
+		return;
+	}
+
+	// the pool leads the view so changed lights come in ascending packed order,
+	// neighbouring ones are merged into one upload. Their instance data is staged
+	// in the frame arena, at the same packed index, once the first light changed
+	const uint32_t NO_RUN = 0xFFFFFFFF;
+	uint32_t runFirst = NO_RUN, runLast = NO_RUN;
+	instancedData* pInstanceData = nullptr;
+	pEntityManager->view<Changed<LightComponent>>(lastRunTick()).each([&](EntityID id, LightComponent& lightComp)
+	{
+		if (!pInstanceData)
+			pInstanceData = pEntityManager->frameArena().allocateArray<instancedData>((uint32_t)mLights.size());
+
+		uint32_t index = pLightPool->indexOf(id);
+		mLights[index] = lightComp.light;
+		pInstanceData[index] = makeInstanceData(lightComp.light);
+
+		if (runFirst != NO_RUN && index == runLast + 1)
+		{
+			runLast = index;
+			return;
+		}
+		if (runFirst != NO_RUN)
+			uploadRange(runFirst, runLast, pInstanceData);
+		runFirst = runLast = index;
+	});
+	if (runFirst != NO_RUN)
+		uploadRange(runFirst, runLast, pInstanceData);
+}
+
+void LightingSystem::uploadRange(uint32_t first, uint32_t last, const instancedData* pInstanceData)
+{
+	uint32_t count = last - first + 1;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, uboLightsBlock);
+	glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr)(sizeof(LightBlock) * first), (GLsizeiptr)(sizeof(LightBlock) * count), &mLights[first]);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(sizeof(instancedData) * first), (GLsizeiptr)(sizeof(instancedData) * count), &pInstanceData[first]);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
\ No newline at end of file
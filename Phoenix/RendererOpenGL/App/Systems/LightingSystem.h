@@ -1,15 +1,23 @@
 #pragma once
 
 #include <stdint.h>
+#include "../../../../Middleware/ECS/System.h"
 
 class EntityManager;
-class LightingSystem
+struct instancedData;
+class LightingSystem : public System
 {
 public:
-	LightingSystem(EntityManager* pEM) : pEntityManager(pEM) {}
+	LightingSystem(EntityManager* pEM);
 	~LightingSystem();
 
-	void AddLights(uint32_t* lights, uint64_t noOfLights);
-	
-	EntityManager* pEntityManager = NULL;
-};
\ No newline at end of file
+	// uploads every LightComponent of the entity manager, (re)creating the buffers
+	void AddLights();
+
+	// keeps the lights uniform block and instance buffer in sync with the components,
+	// only lights changed since the last run are uploaded, needs the GL context
+	virtual void Update(float dt) override;
+
+private:
+	void uploadRange(uint32_t first, uint32_t last, const instancedData* pInstanceData);
+};
@@ -0,0 +1,176 @@
+#include "TransformSystem.h"
+
+#include "../../../../Middleware/ECS/EntityManager.h"
+
+#include <assert.h>
+
+#define NO_PARENT 0xFFFFFFFF
+
+TransformSystem::TransformSystem(EntityManager* pEM) : System(pEM), mLastUpdatedCount(0), mForceRebuild(true)
+{
+	Writes<TransformComponent>();
+	Writes<HierarchyComponent>();
+}
+
+void TransformSystem::SetParent(EntityID child, EntityID parent)
+{
+	HierarchyComponent* pHierarchy = pEntityManager->getComponent<HierarchyComponent>(child);
+	if (!pHierarchy)
+	{
+		pEntityManager->addComponent<HierarchyComponent>(child);
+		pHierarchy = pEntityManager->getComponent<HierarchyComponent>(child);
+		if (!pHierarchy)
+			return;
+	}
+
+	pHierarchy->parent = parent;
+	pEntityManager->markChanged<HierarchyComponent>(child);
+	pEntityManager->markChanged<TransformComponent>(child);
+}
+
+bool TransformSystem::orderOutdated()
+{
+	ComponentPool<TransformComponent>* pTransforms = pEntityManager->getPool<TransformComponent>();
+	uint32 transformCount = pTransforms ? pTransforms->size() : 0;
+	if (mForceRebuild || transformCount != mEntities.size())
+		return true;
+
+	// a remove and an add in between runs keep the count but shuffle the pool
+	bool outdated = false;
+	pEntityManager->view<Added<TransformComponent>>(lastRunTick()).each([&outdated](EntityID id, TransformComponent& transform)
+	{
+		outdated = true;
+	});
+	pEntityManager->view<Changed<HierarchyComponent>>(lastRunTick()).each([&outdated](EntityID id, HierarchyComponent& hierarchy)
+	{
+		outdated = true;
+	});
+	return outdated;
+}
+
+// counting sort on depth, so the rebuild stays O(n)
+void TransformSystem::rebuildOrder()
+{
+	mForceRebuild = false;
+	mEntities.clear();
+	mPoolIndices.clear();
+	mParents.clear();
+
+	ComponentPool<TransformComponent>* pTransforms = pEntityManager->getPool<TransformComponent>();
+	if (!pTransforms)
+	{
+		mWorld.clear();
+		mDirty.clear();
+		return;
+	}
+
+	const uint32 count = pTransforms->size();
+	const EntityID* pEntities = pTransforms->entities();
+
+	// resolve depths, walking up to the first ancestor that already has one
+	tinystl::vector<uint32> depths(count, NO_PARENT);
+	tinystl::vector<uint32> parentIndices(count, NO_PARENT);
+	tinystl::vector<uint32> chain;
+	uint32 maxDepth = 0;
+	for (uint32 i = 0; i < count; ++i)
+	{
+		uint32 index = i;
+		chain.clear();
+		while (depths[index] == NO_PARENT)
+		{
+			chain.push_back(index);
+			assert(chain.size() <= count && "TransformSystem: hierarchy has a cycle");
+
+			HierarchyComponent* pHierarchy = pEntityManager->getComponent<HierarchyComponent>(pEntities[index]);
+			uint32 parentIndex = pHierarchy ? pTransforms->indexOf(pHierarchy->parent) : INVALID_DENSE_INDEX;
+			if (parentIndex == INVALID_DENSE_INDEX || chain.size() > count)
+			{
+				// no parent, or the parent has no transform, it's a root
+				depths[index] = 0;
+				chain.pop_back();
+				break;
+			}
+			parentIndices[index] = parentIndex;
+			index = parentIndex;
+		}
+
+		uint32 depth = depths[index];
+		while (!chain.empty())
+		{
+			depths[chain.back()] = ++depth;
+			chain.pop_back();
+		}
+		if (depth > maxDepth)
+			maxDepth = depth;
+	}
+
+	tinystl::vector<uint32> depthStart(maxDepth + 2, 0);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		++depthStart[depths[i] + 1];
+	}
+	for (uint32 d = 1; d < depthStart.size(); ++d)
+	{
+		depthStart[d] += depthStart[d - 1];
+	}
+
+	tinystl::vector<uint32> orderOfPoolIndex(count, 0);
+	mEntities.resize(count);
+	mPoolIndices.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		uint32 position = depthStart[depths[i]]++;
+		orderOfPoolIndex[i] = position;
+		mEntities[position] = pEntities[i];
+		mPoolIndices[position] = i;
+
+		HierarchyComponent* pHierarchy = pEntityManager->getComponent<HierarchyComponent>(pEntities[i]);
+		if (pHierarchy)
+			pHierarchy->depth = depths[i];
+	}
+
+	mParents.resize(count);
+	for (uint32 position = 0; position < count; ++position)
+	{
+		uint32 parentIndex = parentIndices[mPoolIndices[position]];
+		mParents[position] = parentIndex == NO_PARENT ? NO_PARENT : orderOfPoolIndex[parentIndex];
+	}
+
+	mWorld.resize(count);
+	mDirty.resize(count);
+}
+
+void TransformSystem::Update(float dt)
+{
+	bool rebuilt = orderOutdated();
+	if (rebuilt)
+		rebuildOrder();
+
+	ComponentPool<TransformComponent>* pTransforms = pEntityManager->getPool<TransformComponent>();
+	if (!pTransforms)
+		return;
+
+	// parents sit before their children, so their dirty flag and world are final when a child reads them
+	const uint32 count = (uint32)mEntities.size();
+	const uint32 sinceTick = lastRunTick();
+	const uint32* pPoolIndices = mPoolIndices.data();
+	const uint32* pParents = mParents.data();
+	glm::mat4* pWorld = mWorld.data();
+	uint8_t* pDirty = mDirty.data();
+	uint32 updated = 0;
+	for (uint32 i = 0; i < count; ++i)
+	{
+		uint32 parent = pParents[i];
+		uint32 poolIndex = pPoolIndices[i];
+		bool dirty = rebuilt || pTransforms->changedTick(poolIndex) > sinceTick || (parent != NO_PARENT && pDirty[parent]);
+		pDirty[i] = dirty;
+		if (!dirty)
+			continue;
+
+		TransformComponent& transform = (*pTransforms)[poolIndex];
+		pWorld[i] = parent == NO_PARENT ? transform.localMatrix() : pWorld[parent] * transform.localMatrix();
+		transform.world = pWorld[i];
+		++updated;
+	}
+	mLastUpdatedCount = updated;
+}
\ No newline at end of file
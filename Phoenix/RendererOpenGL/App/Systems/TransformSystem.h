@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../../../../Middleware/ECS/System.h"
+#include "../../../../Middleware/ECS/EntityID.h"
+
+#include "../Components/TransformComponent.h"
+
+class EntityManager;
+
+// Propagates TransformComponent::world down the HierarchyComponent links.
+// Transforms are kept sorted by depth so every parent comes before its children and one
+// linear pass over contiguous arrays updates the whole scene. Only subtrees under a
+// transform marked changed since the last run are recomputed.
+// The order is rebuilt when transforms are added or removed or a hierarchy changes.
+class TransformSystem : public System
+{
+public:
+	TransformSystem(EntityManager* pEM);
+
+	virtual void Update(float dt) override;
+
+	// adds the HierarchyComponent when needed, INVALID_ENTITY_ID detaches
+	void SetParent(EntityID child, EntityID parent);
+
+	uint32 nodeCount() const { return (uint32)mEntities.size(); }
+	uint32 lastUpdatedCount() const { return mLastUpdatedCount; }
+
+private:
+	void rebuildOrder();
+	bool orderOutdated();
+
+	// one entry per transform, in depth order
+	tinystl::vector<EntityID>  mEntities;
+	tinystl::vector<uint32>	   mPoolIndices;	// packed slot in the transform pool
+	tinystl::vector<uint32>	   mParents;		// position of the parent in this order, NO_PARENT for roots
+	tinystl::vector<glm::mat4> mWorld;
+	tinystl::vector<uint8_t>   mDirty;
+
+	uint32 mLastUpdatedCount;
+	bool   mForceRebuild;
+};
\ No newline at end of file
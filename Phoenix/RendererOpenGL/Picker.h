@@ -6,4 +6,6 @@ void Run();
 	#define SCENE_SPONZA   0
 #define PHYSICS 0
 #define ANIMATION 0
+#define ANIMATION_BENCHMARK 0
+#define MESH_LOAD_BENCHMARK 0
 #define PBR 1
\ No newline at end of file
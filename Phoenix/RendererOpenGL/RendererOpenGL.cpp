@@ -4,12 +4,14 @@
 #include <sstream>
 #include <fstream>
 #include <functional>
+#include <algorithm>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #include <iostream>
 #include "../../Common/Thirdparty/TINYSTL/unordered_map.h"
+#include "../../Common/Renderer/CookedMeshIOSystem.h"
 
 #include "Quaternion.h"
 
@@ -102,49 +104,32 @@ void Camera::updateCameraVectors()
 
 std::hash<std::string> hasher;
 
-ShaderProgram::ShaderProgram(std::string vertexShaderPath, std::string fragmentShaderPath)
+static int compileShader(GLenum type, const std::string& path)
 {
 	std::string line;
-	std::stringstream ss[2];
-	int vertexShader, fragmentShader;
-
-	// vert
+	std::stringstream ss;
+	std::ifstream stream(path.c_str());
+	while (getline(stream, line))
 	{
-		std::ifstream vertStream(vertexShaderPath.c_str());
-		while (getline(vertStream, line))
-		{
-			ss[0] << line << '\n';
-		}
-		std::string vertexShaderSource = ss[0].str();
-		const char* charData = vertexShaderSource.c_str();
-
-		vertexShader = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertexShader, 1, &charData, NULL);
-		glCompileShader(vertexShader);
-		
-		int success;
-		glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-		assert(success);
+		ss << line << '\n';
 	}
+	std::string source = ss.str();
+	const char* charData = source.c_str();
 
-	// frag
-	{
-		std::ifstream fragStream(fragmentShaderPath.c_str());
-		while (getline(fragStream, line))
-		{
-			ss[1] << line << '\n';
-		}
-		std::string fragmentShaderSource = ss[1].str().c_str();
-		const char* charData = fragmentShaderSource.c_str();
+	int shader = glCreateShader(type);
+	glShaderSource(shader, 1, &charData, NULL);
+	glCompileShader(shader);
 
-		fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragmentShader, 1, &charData, NULL);
-		glCompileShader(fragmentShader);
-		
-		int success;
-		glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-		assert(success);
-	}
+	int success;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	assert(success);
+	return shader;
+}
+
+ShaderProgram::ShaderProgram(std::string vertexShaderPath, std::string fragmentShaderPath)
+{
+	int vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderPath);
+	int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderPath);
 
 	mId = glCreateProgram();
 	glAttachShader(mId, vertexShader);
@@ -157,6 +142,29 @@ ShaderProgram::ShaderProgram(std::string vertexShaderPath, std::string fragmentS
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
 
+	reflectUniforms();
+}
+
+ShaderProgram::ShaderProgram(std::string vertexShaderPath, const char* const* pFeedbackVaryings, uint32_t varyingCount)
+{
+	int vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderPath);
+
+	mId = glCreateProgram();
+	glAttachShader(mId, vertexShader);
+	// has to be known before linking
+	glTransformFeedbackVaryings(mId, varyingCount, pFeedbackVaryings, GL_INTERLEAVED_ATTRIBS);
+	glLinkProgram(mId);
+
+	int success;
+	glGetProgramiv(mId, GL_LINK_STATUS, &success);
+	assert(success);
+	glDeleteShader(vertexShader);
+
+	reflectUniforms();
+}
+
+void ShaderProgram::reflectUniforms()
+{
 	int32_t count, length, size;
 	GLenum type;
 	const uint32_t bufferSize = 256;
@@ -317,6 +325,7 @@ void ShaderProgram::SetUniform(const char* name, void* data)
 		case GL_SAMPLER_1D:
 		case GL_SAMPLER_2D:
 		case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_BUFFER:
 			glUniform1iv(uniformInfo.location, 1, (int*)data);
 			break;
 		case GL_SAMPLER_3D: break;
@@ -329,7 +338,77 @@ void ShaderProgram::SetUniform(const char* name, void* data)
 	}
 }
 
-uint32_t LoadTexture(const char* path, bool isHDR)
+// decoded pixels of a texture in the asset cache, see CookedMesh.h
+#define COOKED_TEXTURE_INFO	  COOKED_CHUNK_ID('T', 'E', 'X', 'I')
+#define COOKED_TEXTURE_PIXELS COOKED_CHUNK_ID('P', 'I', 'X', 'L')
+
+bool gUseTextureCache = true;
+
+TextureImage::~TextureImage()
+{
+	if (pDecoded)
+		stbi_image_free(pDecoded);
+}
+
+bool DecodeTexture(const char* path, TextureImage& image, AssetTimings* pTimings)
+{
+	Clock::time_point Start = Clock::now();
+
+	std::vector<uint8_t> source;
+	if (!CookedMeshReadSource(path, source))
+		return false;
+
+	// decoding is most of the cost, so the pixels are cached on the image's bytes and the flip.
+	// every caller flips, so workers setting stb's global flag at once is harmless
+	const int Flip = 1;
+	stbi_set_flip_vertically_on_load(Flip);
+	uint64_t key = CookedMeshHash(source.data(), source.size(), CookedMeshHash(&Flip, sizeof(Flip)));
+	std::string cachedPath = CookedMeshCachePath(key, "gltex");
+
+	int info[3] = {}; // width, height, channels
+	if (gUseTextureCache && image.cached.Open(cachedPath) && image.cached.Matches(key, source.size()))
+	{
+		size_t infoSize = 0, pixelSize = 0;
+		const int* pInfo = (const int*)image.cached.Chunk(COOKED_TEXTURE_INFO, &infoSize);
+		const unsigned char* pPixels = (const unsigned char*)image.cached.Chunk(COOKED_TEXTURE_PIXELS, &pixelSize);
+		if (pInfo && infoSize == sizeof(info) && pPixels && pixelSize == (size_t)pInfo[0] * pInfo[1] * pInfo[2])
+		{
+			image.width = pInfo[0];
+			image.height = pInfo[1];
+			image.channels = pInfo[2];
+			image.pPixels = pPixels;
+		}
+	}
+
+	Clock::time_point Read = Clock::now();
+	if (pTimings)
+		pTimings->read += std::chrono::duration<double, std::milli>(Read - Start).count();
+	if (image.pPixels)
+		return true;
+
+	image.pDecoded = stbi_load_from_memory(source.data(), (int)source.size(), &info[0], &info[1], &info[2], 0);
+	if (!image.pDecoded)
+		return false;
+
+	image.width = info[0];
+	image.height = info[1];
+	image.channels = info[2];
+	image.pPixels = image.pDecoded;
+
+	if (gUseTextureCache)
+	{
+		CookedMeshWriter writer;
+		writer.AddChunk(COOKED_TEXTURE_INFO, info, sizeof(info));
+		writer.AddChunk(COOKED_TEXTURE_PIXELS, image.pDecoded, (size_t)info[0] * info[1] * info[2]);
+		writer.Write(cachedPath, key, source.size());
+	}
+
+	if (pTimings)
+		pTimings->decode += elapsedMs(Read);
+	return true;
+}
+
+uint32_t UploadTexture(const TextureImage& image, bool isHDR)
 {
 	unsigned int texture;
 	glGenTextures(1, &texture);
@@ -340,14 +419,8 @@ uint32_t LoadTexture(const char* path, bool isHDR)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	
-	int width, height, nrChannels;
-	stbi_set_flip_vertically_on_load(true);
-	unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
-	
-	assert(data);
-	
 	int internal_format = 0;
-	switch (nrChannels)
+	switch (image.channels)
 	{
 	case 4: internal_format = GL_RGBA; break;
 	case 3: internal_format = GL_RGB;  break;
@@ -358,20 +431,97 @@ uint32_t LoadTexture(const char* path, bool isHDR)
 
 	if (isHDR)
 	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.pPixels);
 	}
 	else
 	{
-		glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, internal_format, GL_UNSIGNED_BYTE, data);
+		glTexImage2D(GL_TEXTURE_2D, 0, internal_format, image.width, image.height, 0, internal_format, GL_UNSIGNED_BYTE, image.pPixels);
 	}
 	
 	glGenerateMipmap(GL_TEXTURE_2D);
-	
-	stbi_image_free(data);
 
 	return texture;
 }
 
+uint32_t LoadTexture(const char* path, bool isHDR)
+{
+	TextureImage image;
+	bool decoded = DecodeTexture(path, image);
+	assert(decoded);
+
+	return UploadTexture(image, isHDR);
+}
+
+//////////////////////////////////////////////// TEXTURE REGISTRY
+TextureRegistry gTextureRegistry;
+
+std::string TextureRegistry::Key(const char* path, bool isHDR)
+{
+	// every load flips, so the format is the only setting that differs between textures
+	return CookedMeshCanonicalPath(path) + (isHDR ? "|hdr" : "|ldr");
+}
+
+uint32_t TextureRegistry::Acquire(const char* path, bool isHDR)
+{
+	uint32_t id = Find(path, isHDR);
+	if (id != 0)
+		return id;
+
+	return Add(path, LoadTexture(path, isHDR), isHDR);
+}
+
+uint32_t TextureRegistry::Find(const char* path, bool isHDR)
+{
+	std::unordered_map<std::string, Entry>::iterator itr = mEntries.find(Key(path, isHDR));
+	if (itr == mEntries.end())
+		return 0;
+
+	itr->second.refs++;
+	mShared++;
+	return itr->second.id;
+}
+
+uint32_t TextureRegistry::Add(const char* path, uint32_t id, bool isHDR)
+{
+	std::string key = Key(path, isHDR);
+	std::unordered_map<std::string, Entry>::iterator itr = mEntries.find(key);
+	if (itr != mEntries.end())
+	{
+		glDeleteTextures(1, &id);
+		itr->second.refs++;
+		mShared++;
+		return itr->second.id;
+	}
+
+	Entry entry = { id, 1 };
+	mEntries.emplace(key, entry);
+	mKeys.emplace(id, key);
+	return id;
+}
+
+void TextureRegistry::AddRef(uint32_t id)
+{
+	std::unordered_map<uint32_t, std::string>::iterator itr = mKeys.find(id);
+	if (itr != mKeys.end())
+		mEntries[itr->second].refs++;
+}
+
+void TextureRegistry::Release(uint32_t id)
+{
+	std::unordered_map<uint32_t, std::string>::iterator itr = mKeys.find(id);
+	if (itr == mKeys.end())
+		return;
+
+	Entry& entry = mEntries[itr->second];
+	assert(entry.refs > 0);
+	if (--entry.refs == 0)
+	{
+		glDeleteTextures(1, &entry.id);
+		mEntries.erase(itr->second);
+		mKeys.erase(itr);
+	}
+}
+
 
 #pragma region BASIC_SHAPES
 
@@ -714,6 +864,16 @@ void OpenGLRenderer::RenderSphereInstanced(int numOfInstances)
 
 #pragma endregion BASIC_SHAPES
 
+void OpenGLRenderer::RenderBakedInstanced(SkinnedMesh& mesh, BakedAnimation& animation, ShaderProgram& shader, float time)
+{
+	glUseProgram(shader.mId);
+	animation.Bind(shader);
+	shader.SetUniform("gTime", &time);
+
+	// a single instanced draw per mesh entry, the instance matrices never change
+	mesh.Render(shader);
+}
+
 
 glm::mat4 OpenGLRenderer::ModelMatForLineBWTwoPoints(glm::vec3 A, glm::vec3 B)
 {
@@ -740,6 +900,17 @@ glm::mat4 OpenGLRenderer::ModelMatForLineBWTwoPoints(glm::vec3 A, glm::vec3 B)
 #define BONE_ID_LOCATION     3
 #define BONE_WEIGHT_LOCATION 4
 
+// chunks of a cooked SkinnedMesh, see CookedMesh.h
+#define COOKED_POSITIONS COOKED_CHUNK_ID('P', 'O', 'S', ' ')
+#define COOKED_NORMALS	 COOKED_CHUNK_ID('N', 'R', 'M', ' ')
+#define COOKED_TEXCOORDS COOKED_CHUNK_ID('U', 'V', ' ', ' ')
+#define COOKED_BONES	 COOKED_CHUNK_ID('B', 'O', 'N', 'E')
+#define COOKED_INDICES	 COOKED_CHUNK_ID('I', 'D', 'X', ' ')
+#define COOKED_ENTRIES	 COOKED_CHUNK_ID('E', 'N', 'T', 'R')
+#define COOKED_MATERIALS COOKED_CHUNK_ID('M', 'A', 'T', 'L')
+#define COOKED_SKELETON	 COOKED_CHUNK_ID('S', 'K', 'E', 'L')
+#define COOKED_CLIP		 COOKED_CHUNK_ID('C', 'L', 'I', 'P')
+
 void SkinnedMesh::VertexBoneData::AddBoneData(uint32_t BoneID, float Weight)
 {
  	uint32_t size = sizeof(IDs) / sizeof(IDs[0]);
@@ -757,17 +928,22 @@ void SkinnedMesh::VertexBoneData::AddBoneData(uint32_t BoneID, float Weight)
 	assert(0);
 }
 
+ClipCompression SkinnedMesh::sClipCompression;
+
 SkinnedMesh::SkinnedMesh()
 {
 	m_VAO = 0;
 	memset(m_Buffers, 0, sizeof(m_Buffers) / sizeof(m_Buffers[0]));
-	m_NumBones = 0;
-	m_pScene = NULL;
+	mAnimationSet.mCompression = sClipCompression;
 }
 
 
 SkinnedMesh::~SkinnedMesh()
 {
+	// nothing the loader still has queued may touch the mesh after this
+	if (mpLoader)
+		mpLoader->Cancel(this);
+
 	//for (uint32_t i = 0; i < m_Textures.size(); i++)
 	//{
 	//	//SAFE_DELETE(m_Textures[i]);
@@ -784,97 +960,149 @@ SkinnedMesh::~SkinnedMesh()
 		m_VAO = 0;
 	}
 
-	m_pScene->~aiScene();
+	if (mSkinnedVAO != 0)
+	{
+		glDeleteVertexArrays(1, &mSkinnedVAO);
+		glDeleteBuffers(1, &mSkinnedBuffer);
+	}
+
+	for (tinystl::unordered_map<uint32_t, tinystl::vector<Texture>>::iterator itr = mMeshTexturesMap.begin(); itr != mMeshTexturesMap.end(); ++itr)
+	{
+		for (unsigned int j = 0; j < itr->second.size(); j++)
+		{
+			gTextureRegistry.Release(itr->second[j].id);
+		}
+	}
 }
 
-bool SkinnedMesh::LoadMesh(const std::string& Filename, uint32_t instanceCount)
+uint64_t SkinnedMesh::CacheSeed()
 {
-	mInstanceCount = instanceCount;
-	directory = Filename.substr(0, Filename.find_last_of('/'));
-
-	// Create the VAO
-	glGenVertexArrays(1, &m_VAO);
-	glBindVertexArray(m_VAO);
-
-	// Create the buffers for the vertices attributes
-	glGenBuffers(sizeof(m_Buffers) / sizeof(m_Buffers[0]), m_Buffers);
-
-	bool Ret = false;
+	const uint32_t Settings[] = { SKINNED_MESH_IMPORT_FLAGS, MESH_OPTIMIZER_VERSION };
+	const float Tolerances[] = { sClipCompression.translationError, sClipCompression.rotationError, sClipCompression.scaleError };
+	return CookedMeshHash(Tolerances, sizeof(Tolerances), CookedMeshHash(Settings, sizeof(Settings)));
+}
 
-	m_pScene = m_Importer.ReadFile(Filename.c_str(), aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices);
-	m_pScene = m_Importer.GetOrphanedScene();
+bool SkinnedMesh::LoadMesh(const std::string& Filename, uint32_t instanceCount)
+{
+	CookedMeshFile cooked;
+	if (!Cook(Filename, mUseCookedMesh, cooked))
+		return false;
 
-	if (m_pScene)
-	{
-		m_GlobalInverseTransform = m_pScene->mRootNode->mTransformation;
-		m_GlobalInverseTransform.Inverse();
-		Ret = InitFromScene(m_pScene, Filename);
+	return InitFromCooked(Filename, cooked, instanceCount, true);
+}
 
-		if (m_pScene->mNumAnimations > 0)
-		{
-			mIsAnim = true;
-			mAnimations.push_back(m_pScene->mAnimations[0]);
-		}
-	}
-	else
+bool SkinnedMesh::Cook(const std::string& Filename, bool useCache, CookedMeshFile& cooked, AssetTimings* pTimings)
+{
+	Clock::time_point Start = Clock::now();
+
+	// keyed on the source bytes and the import flags, an edited source simply misses.
+	// Files the source pulled in (materials) are rehashed from the list in the blob
+	uint64_t Key = 0, SourceSize = 0;
+	const bool HasSource = useCache && CookedMeshHashSource(Filename, CacheSeed(), Key, SourceSize);
+	const std::string CookedPath = CookedMeshCachePath(Key, "glmesh");
+	const bool Cached = HasSource && cooked.Open(CookedPath) && cooked.Matches(Key, SourceSize) && CookedMeshDependenciesMatch(cooked) &&
+						isValidCooked(cooked);
+
+	Clock::time_point Read = Clock::now();
+	if (pTimings)
+		pTimings->read += std::chrono::duration<double, std::milli>(Read - Start).count();
+	if (Cached)
+		return true;
+	// a stale blob stays mapped otherwise, and can't be replaced on Windows
+	cooked.Close();
+
+	std::vector<std::string> Dependencies;
+	Assimp::Importer Importer;
+	Importer.SetIOHandler(new CookedMeshIOSystem(Filename, &Dependencies));
+	const aiScene* pScene = Importer.ReadFile(Filename.c_str(), SKINNED_MESH_IMPORT_FLAGS);
+	if (!pScene)
 	{
-		printf("Error parsing '%s': '%s'\n", Filename.c_str(), m_Importer.GetErrorString());
+		printf("Error parsing '%s': '%s'\n", Filename.c_str(), Importer.GetErrorString());
+		return false;
 	}
 
-	// Make sure the VAO is not changed from the outside
-	glBindVertexArray(0);
+	CookedMeshWriter writer;
+	CookScene(pScene, writer);
+	CookedMeshAddDependencies(writer, Dependencies);
+
+	std::vector<uint8_t> bytes;
+	writer.Serialize(Key, SourceSize, bytes);
+	if (HasSource && !CookedMeshWriteFile(CookedPath, bytes))
+		printf("Error writing '%s'\n", CookedPath.c_str());
+
+	bool Ret = cooked.Open(bytes) && isValidCooked(cooked);
 
+	if (pTimings)
+		pTimings->decode += elapsedMs(Read);
 	return Ret;
 }
 
 void SkinnedMesh::AddAnimation(const std::string& Filename)
 {
-	const aiScene* anim = m_Importer.ReadFile(Filename.c_str(), aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices);
-	anim = m_Importer.GetOrphanedScene();
-	if (anim->mNumAnimations > 0)
+	// the clip keeps its own copy of the keys, the scene goes away with the importer
+	Assimp::Importer importer;
+	const aiScene* anim = importer.ReadFile(Filename.c_str(), SKINNED_MESH_IMPORT_FLAGS);
+	if (anim && anim->mNumAnimations > 0)
 	{
 		mIsAnim = true;
-		mAnimations.push_back(anim->mAnimations[0]);
+		mAnimationSet.AddClip(anim->mAnimations[0]);
+	}
+}
+
+// MaterialTexture::type indexes these
+static const aiTextureType MATERIAL_TEXTURE_TYPES[] = { aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_HEIGHT, aiTextureType_AMBIENT };
+static const char* MATERIAL_TEXTURE_NAMES[] = { "texture_diffuse", "texture_specular", "texture_normal", "texture_height" };
+
+void SkinnedMesh::InitMaterials(const MaterialTexture* pTextures, uint32_t count, bool loadTextures)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const MaterialTexture& material = pTextures[i];
+		std::string fullPath = this->directory + "/" + material.path;
+
+		// textures any model already loaded are shared, the rest load now or are left to SetTexture
+		Texture texture;
+		texture.id = loadTextures ? gTextureRegistry.Acquire(fullPath.c_str()) : gTextureRegistry.Find(fullPath.c_str());
+		texture.type = MATERIAL_TEXTURE_NAMES[material.type];
+		texture.path = material.path;
+		mMeshTexturesMap[material.material].push_back(texture);
 	}
 }
 
-tinystl::vector<Texture> SkinnedMesh::InitMaterials(const aiMaterial* material, aiTextureType type, std::string typeName)
+void SkinnedMesh::SetTexture(const std::string& path, uint32_t id)
 {
-	tinystl::vector<Texture> textures;
-	for (unsigned int i = 0; i < material->GetTextureCount(type); i++)
+	for (tinystl::unordered_map<uint32_t, tinystl::vector<Texture>>::iterator itr = mMeshTexturesMap.begin(); itr != mMeshTexturesMap.end(); ++itr)
 	{
-		aiString str;
-		material->GetTexture(type, i, &str);
-		// check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-		bool skip = false;
-		for (unsigned int j = 0; j < textures_loaded.size(); j++)
+		for (unsigned int j = 0; j < itr->second.size(); j++)
 		{
-			if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
+			if (itr->second[j].id == 0 && itr->second[j].path == path)
 			{
-				textures.push_back(textures_loaded[j]);
-				skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-				break;
+				gTextureRegistry.AddRef(id);
+				itr->second[j].id = id;
 			}
 		}
-		if (!skip)
-		{   // if texture hasn't been loaded already, load it
-			Texture texture;
-			std::string fullPath = this->directory + "/" + str.C_Str();
-			texture.id = LoadTexture(fullPath.c_str());
-			texture.type = typeName;
-			texture.path = str.C_Str();
-			textures.push_back(texture);
-			textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
+	}
+}
+
+void SkinnedMesh::PendingTextures(std::vector<std::string>& paths) const
+{
+	for (tinystl::unordered_map<uint32_t, tinystl::vector<Texture>>::const_iterator itr = mMeshTexturesMap.begin(); itr != mMeshTexturesMap.end(); ++itr)
+	{
+		for (unsigned int j = 0; j < itr->second.size(); j++)
+		{
+			if (itr->second[j].id == 0 && std::find(paths.begin(), paths.end(), itr->second[j].path) == paths.end())
+				paths.push_back(itr->second[j].path);
 		}
 	}
-	return textures;
 }
 
-bool SkinnedMesh::InitFromScene(const aiScene* pScene, const std::string& Filename)
+void SkinnedMesh::CookScene(const aiScene* pScene, CookedMeshWriter& writer)
 {
-	m_Entries.resize(pScene->mNumMeshes);
-	//m_Textures.resize(pScene->mNumMaterials);
+	// skeleton first, LoadBones needs the palette indices
+	Skeleton skeleton;
+	skeleton.Build(pScene);
 
+	tinystl::vector<MeshEntry> Entries(pScene->mNumMeshes);
 	tinystl::vector<aiVector3D> Positions;
 	tinystl::vector<aiVector3D> Normals;
 	tinystl::vector<aiVector2D> TexCoords;
@@ -885,15 +1113,15 @@ bool SkinnedMesh::InitFromScene(const aiScene* pScene, const std::string& Filena
 	uint32_t NumIndices = 0;
 
 	// Count the number of vertices and indices
-	for (uint32_t i = 0; i < m_Entries.size(); i++)
+	for (uint32_t i = 0; i < Entries.size(); i++)
 	{
-		m_Entries[i].MaterialIndex = pScene->mMeshes[i]->mMaterialIndex;
-		m_Entries[i].NumIndices = pScene->mMeshes[i]->mNumFaces * 3;
-		m_Entries[i].BaseVertex = NumVertices;
-		m_Entries[i].BaseIndex = NumIndices;
+		Entries[i].MaterialIndex = pScene->mMeshes[i]->mMaterialIndex;
+		Entries[i].NumIndices = pScene->mMeshes[i]->mNumFaces * 3;
+		Entries[i].BaseVertex = NumVertices;
+		Entries[i].BaseIndex = NumIndices;
 
 		NumVertices += pScene->mMeshes[i]->mNumVertices;
-		NumIndices += m_Entries[i].NumIndices;
+		NumIndices += Entries[i].NumIndices;
 	}
 
 	// Reserve space in the vectors for the vertex attributes and indices
@@ -904,59 +1132,244 @@ bool SkinnedMesh::InitFromScene(const aiScene* pScene, const std::string& Filena
 	Indices.reserve(NumIndices);
 
 	// Initialize the meshes in the scene one by one
-	for (uint32_t i = 0; i < m_Entries.size(); i++)
+	for (uint32_t i = 0; i < Entries.size(); i++)
 	{
 		const aiMesh* paiMesh = pScene->mMeshes[i];
-		InitMesh(i, paiMesh, Positions, Normals, TexCoords, Bones, Indices);
+		InitMesh(Entries[i].BaseVertex, paiMesh, skeleton, Positions, Normals, TexCoords, Bones, Indices);
+	}
+
+	// cache, overdraw then fetch order per entry, see MeshOptimizer.h
+	std::vector<uint32_t> Remap;
+	for (uint32_t i = 0; i < Entries.size(); i++)
+	{
+		if (Entries[i].NumIndices == 0)
+			continue;
+
+		const uint32_t Base = Entries[i].BaseVertex;
+		const uint32_t Count = pScene->mMeshes[i]->mNumVertices;
+		uint32_t* pIndices = &Indices[Entries[i].BaseIndex];
+		MeshOptimizeVertexCache(pIndices, Entries[i].NumIndices, Count);
+		MeshOptimizeOverdraw(pIndices, Entries[i].NumIndices, &Positions[Base].x, sizeof(aiVector3D), Count);
+
+		MeshOptimizeVertexFetch(pIndices, Entries[i].NumIndices, Count, Remap);
+		MeshRemapVertices(&Positions[Base], sizeof(aiVector3D), Count, Remap.data());
+		MeshRemapVertices(&Normals[Base], sizeof(aiVector3D), Count, Remap.data());
+		MeshRemapVertices(&TexCoords[Base], sizeof(aiVector2D), Count, Remap.data());
+		MeshRemapVertices(&Bones[Base], sizeof(VertexBoneData), Count, Remap.data());
 	}
 
+	// texture paths of every material some mesh uses, in the order they bind
+	std::vector<MaterialTexture> Materials;
+	std::vector<bool> MaterialSeen(pScene->mNumMaterials, false);
 	for (uint32_t i = 0; i < pScene->mNumMeshes; ++i)
 	{
-		aiMesh* mesh = pScene->mMeshes[i];
-		uint32_t materialIndex = mesh->mMaterialIndex;
-		aiMaterial* material = pScene->mMaterials[materialIndex];
-		tinystl::vector<Texture> textures;
+		uint32_t materialIndex = pScene->mMeshes[i]->mMaterialIndex;
+		if (MaterialSeen[materialIndex])
+			continue;
+		MaterialSeen[materialIndex] = true;
+
+		const aiMaterial* material = pScene->mMaterials[materialIndex];
+		for (uint32_t type = 0; type < sizeof(MATERIAL_TEXTURE_TYPES) / sizeof(MATERIAL_TEXTURE_TYPES[0]); type++)
+		{
+			for (unsigned int t = 0; t < material->GetTextureCount(MATERIAL_TEXTURE_TYPES[type]); t++)
+			{
+				aiString str;
+				material->GetTexture(MATERIAL_TEXTURE_TYPES[type], t, &str);
+
+				MaterialTexture texture = {};
+				texture.material = materialIndex;
+				texture.type = type;
+				strncpy(texture.path, str.C_Str(), sizeof(texture.path) - 1);
+				Materials.push_back(texture);
+			}
+		}
+	}
+
+	writer.AddChunk(COOKED_POSITIONS, &Positions[0], sizeof(Positions[0]) * Positions.size());
+	writer.AddChunk(COOKED_NORMALS, &Normals[0], sizeof(Normals[0]) * Normals.size());
+	writer.AddChunk(COOKED_TEXCOORDS, &TexCoords[0], sizeof(TexCoords[0]) * TexCoords.size());
+	writer.AddChunk(COOKED_BONES, &Bones[0], sizeof(Bones[0]) * Bones.size());
+	writer.AddChunk(COOKED_INDICES, &Indices[0], sizeof(Indices[0]) * Indices.size());
+	writer.AddChunk(COOKED_ENTRIES, &Entries[0], sizeof(Entries[0]) * Entries.size());
+	writer.AddChunk(COOKED_MATERIALS, Materials);
+
+	CookedStreamWriter SkeletonStream;
+	skeleton.Write(SkeletonStream);
+	writer.AddChunk(COOKED_SKELETON, SkeletonStream.Data());
+
+	// the first clip, compressed with the tolerances AddAnimation uses
+	if (pScene->mNumAnimations > 0)
+	{
+		AnimationClip clip;
+		clip.Build(pScene->mAnimations[0]);
+		clip.Compress(sClipCompression);
 
-		tinystl::vector<Texture> diffuseMaps = InitMaterials(material, aiTextureType_DIFFUSE, "texture_diffuse");
-		textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+		CookedStreamWriter ClipStream;
+		clip.Write(ClipStream);
+		writer.AddChunk(COOKED_CLIP, ClipStream.Data());
+	}
+}
 
-		tinystl::vector<Texture> specularMaps = InitMaterials(material, aiTextureType_SPECULAR, "texture_specular");
-		textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+bool SkinnedMesh::isValidCooked(const CookedMeshFile& cooked)
+{
+	uint32_t NumVertices = 0, NumNormals = 0, NumTexCoords = 0, NumBones = 0, NumIndices = 0, NumEntries = 0, NumMaterials = 0;
+	const aiVector3D* pPositions = cooked.Chunk<aiVector3D>(COOKED_POSITIONS, NumVertices);
+	const aiVector3D* pNormals = cooked.Chunk<aiVector3D>(COOKED_NORMALS, NumNormals);
+	const aiVector2D* pTexCoords = cooked.Chunk<aiVector2D>(COOKED_TEXCOORDS, NumTexCoords);
+	const VertexBoneData* pBones = cooked.Chunk<VertexBoneData>(COOKED_BONES, NumBones);
+	const uint32_t* pIndices = cooked.Chunk<uint32_t>(COOKED_INDICES, NumIndices);
+	const MeshEntry* pEntries = cooked.Chunk<MeshEntry>(COOKED_ENTRIES, NumEntries);
+	const MaterialTexture* pMaterials = cooked.Chunk<MaterialTexture>(COOKED_MATERIALS, NumMaterials);
+
+	if (!pPositions || !pNormals || !pTexCoords || !pBones || !pIndices || !pEntries || !pMaterials || !cooked.Chunk(COOKED_SKELETON) ||
+		NumVertices == 0 || NumNormals != NumVertices || NumTexCoords != NumVertices || NumBones != NumVertices || NumIndices == 0)
+		return false;
+
+	// every index has to land in the vertices, relative to its entry's base vertex
+	for (uint32_t i = 0; i < NumEntries; i++)
+	{
+		const MeshEntry& entry = pEntries[i];
+		if ((uint64_t)entry.BaseIndex + entry.NumIndices > NumIndices || entry.BaseVertex >= NumVertices)
+			return false;
+		for (uint32_t j = entry.BaseIndex; j < entry.BaseIndex + entry.NumIndices; j++)
+		{
+			if (pIndices[j] >= NumVertices - entry.BaseVertex)
+				return false;
+		}
+	}
+	for (uint32_t i = 0; i < NumMaterials; i++)
+	{
+		if (pMaterials[i].type >= sizeof(MATERIAL_TEXTURE_NAMES) / sizeof(MATERIAL_TEXTURE_NAMES[0]) ||
+			memchr(pMaterials[i].path, 0, sizeof(pMaterials[i].path)) == NULL)
+			return false;
+	}
 
-		tinystl::vector<Texture> normalMaps = InitMaterials(material, aiTextureType_HEIGHT, "texture_normal");
-		textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+	// the skeleton and clip validate their own indices while they read back
+	size_t SkeletonSize = 0;
+	const void* pSkeleton = cooked.Chunk(COOKED_SKELETON, &SkeletonSize);
+	CookedStreamReader SkeletonStream(pSkeleton, SkeletonSize);
+	Skeleton skeleton;
+	if (!skeleton.Read(SkeletonStream))
+		return false;
+
+	size_t ClipSize = 0;
+	const void* pClip = cooked.Chunk(COOKED_CLIP, &ClipSize);
+	if (pClip)
+	{
+		CookedStreamReader ClipStream(pClip, ClipSize);
+		AnimationClip clip;
+		if (!clip.Read(ClipStream))
+			return false;
+	}
 
-		tinystl::vector<Texture> heightMaps = InitMaterials(material, aiTextureType_AMBIENT, "texture_height");
-		textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+	// bone slots without weight are left at ID 0, even in a mesh without bones
+	const uint32_t BoneCount = skeleton.BoneCount();
+	for (uint32_t i = 0; i < NumBones; i++)
+	{
+		for (uint32_t k = 0; k < NUM_BONES_PER_VEREX; k++)
+		{
+			if (pBones[i].IDs[k] >= BoneCount && (pBones[i].IDs[k] != 0 || pBones[i].Weights[k] != 0.0f))
+				return false;
+		}
+	}
+	return true;
+}
 
-		mMeshTexturesMap[materialIndex] = textures;
+bool SkinnedMesh::InitFromCooked(const std::string& Filename, const CookedMeshFile& cooked, uint32_t instanceCount, bool loadTextures)
+{
+	uint32_t NumVertices = 0, NumIndices = 0, NumEntries = 0, NumMaterials = 0;
+	const aiVector3D* pPositions = cooked.Chunk<aiVector3D>(COOKED_POSITIONS, NumVertices);
+	const aiVector3D* pNormals = cooked.Chunk<aiVector3D>(COOKED_NORMALS, NumVertices);
+	const aiVector2D* pTexCoords = cooked.Chunk<aiVector2D>(COOKED_TEXCOORDS, NumVertices);
+	const VertexBoneData* pBones = cooked.Chunk<VertexBoneData>(COOKED_BONES, NumVertices);
+	const uint32_t* pIndices = cooked.Chunk<uint32_t>(COOKED_INDICES, NumIndices);
+	const MeshEntry* pEntries = cooked.Chunk<MeshEntry>(COOKED_ENTRIES, NumEntries);
+	const MaterialTexture* pMaterials = cooked.Chunk<MaterialTexture>(COOKED_MATERIALS, NumMaterials);
+
+	// nothing is touched until the skeleton and clip read back
+	size_t SkeletonSize = 0;
+	const void* pSkeleton = cooked.Chunk(COOKED_SKELETON, &SkeletonSize);
+	CookedStreamReader SkeletonStream(pSkeleton, SkeletonSize);
+	Skeleton skeleton;
+	if (!skeleton.Read(SkeletonStream))
+		return false;
+
+	size_t ClipSize = 0;
+	const void* pClip = cooked.Chunk(COOKED_CLIP, &ClipSize);
+	AnimationClip clip;
+	if (pClip)
+	{
+		CookedStreamReader ClipStream(pClip, ClipSize);
+		if (!clip.Read(ClipStream))
+			return false;
+	}
+
+	mInstanceCount = instanceCount;
+	directory = Filename.substr(0, Filename.find_last_of('/'));
+
+	mAnimationSet.Build(skeleton);
+	mGlobalTransforms.resize(mAnimationSet.GetSkeleton().NodeCount());
+	if (pClip)
+	{
+		mIsAnim = true;
+		mAnimationSet.AddClip(clip);
+	}
+
+	for (uint32_t i = 0; i < NumEntries; i++)
+	{
+		mMeshTexturesMap[pEntries[i].MaterialIndex];
 	}
+	InitMaterials(pMaterials, NumMaterials, loadTextures);
+
+	// Create the VAO
+	glGenVertexArrays(1, &m_VAO);
+	glBindVertexArray(m_VAO);
+
+	// Create the buffers for the vertices attributes
+	glGenBuffers(sizeof(m_Buffers) / sizeof(m_Buffers[0]), m_Buffers);
+
+	// straight from the mapping, the driver copies it once
+	InitBuffers(pPositions, pNormals, pTexCoords, pBones, NumVertices, pIndices, NumIndices);
+
+	// last, Render draws nothing until the entries are there
+	m_Entries.resize(NumEntries);
+	for (uint32_t i = 0; i < NumEntries; i++)
+	{
+		m_Entries[i] = pEntries[i];
+	}
+
+	return glGetError() == GL_NO_ERROR;
+}
+
+void SkinnedMesh::InitBuffers(const aiVector3D* pPositions, const aiVector3D* pNormals, const aiVector2D* pTexCoords, const VertexBoneData* pBones, uint32_t NumVertices, const uint32_t* pIndices, uint32_t NumIndices)
+{
+	mNumVertices = NumVertices;
 
 	// Generate and populate the buffers with vertex attributes and the indices
 	glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[POS_VB]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Positions[0]) * Positions.size(), &Positions[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(pPositions[0]) * NumVertices, pPositions, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(POSITION_LOCATION);
 	glVertexAttribPointer(POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
 	glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[TEXCOORD_VB]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(TexCoords[0]) * TexCoords.size(), &TexCoords[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(pTexCoords[0]) * NumVertices, pTexCoords, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(TEX_COORD_LOCATION);
 	glVertexAttribPointer(TEX_COORD_LOCATION, 2, GL_FLOAT, GL_FALSE, 0, 0);
 
 	glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[NORMAL_VB]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Normals[0]) * Normals.size(), &Normals[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(pNormals[0]) * NumVertices, pNormals, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(NORMAL_LOCATION);
 	glVertexAttribPointer(NORMAL_LOCATION, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
 	glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[BONE_VB]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Bones[0]) * Bones.size(), &Bones[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(pBones[0]) * NumVertices, pBones, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(BONE_ID_LOCATION);
 	glVertexAttribIPointer(BONE_ID_LOCATION, 4, GL_INT, sizeof(VertexBoneData), (const GLvoid*)0);
 	glEnableVertexAttribArray(BONE_WEIGHT_LOCATION);
 	glVertexAttribPointer(BONE_WEIGHT_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(VertexBoneData), (const GLvoid*)16);
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Buffers[INDEX_BUFFER]);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Indices[0]) * Indices.size(), &Indices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(pIndices[0]) * NumIndices, pIndices, GL_STATIC_DRAW);
 
 	if (mInstanceCount != 0)
 	{
@@ -982,12 +1395,11 @@ bool SkinnedMesh::InitFromScene(const aiScene* pScene, const std::string& Filena
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 	glBindVertexArray(0);
-
-	return glGetError();
 }
 
-void SkinnedMesh::InitMesh(uint32_t MeshIndex,
+void SkinnedMesh::InitMesh(uint32_t BaseVertex,
 	const aiMesh* paiMesh,
+	const Skeleton& skeleton,
 	tinystl::vector<aiVector3D>& Positions,
 	tinystl::vector<aiVector3D>& Normals,
 	tinystl::vector<aiVector2D>& TexCoords,
@@ -1008,7 +1420,7 @@ void SkinnedMesh::InitMesh(uint32_t MeshIndex,
 		TexCoords.push_back(aiVector2D(pTexCoord->x, pTexCoord->y));
 	}
 
-	LoadBones(MeshIndex, paiMesh, Bones);
+	LoadBones(BaseVertex, paiMesh, skeleton, Bones);
 
 	// Populate the index buffer
 	for (uint32_t i = 0; i < paiMesh->mNumFaces; i++)
@@ -1022,78 +1434,66 @@ void SkinnedMesh::InitMesh(uint32_t MeshIndex,
 }
 
 
-void SkinnedMesh::LoadBones(uint32_t MeshIndex, const aiMesh* pMesh, tinystl::vector<VertexBoneData>& Bones)
+void SkinnedMesh::LoadBones(uint32_t BaseVertex, const aiMesh* pMesh, const Skeleton& skeleton, tinystl::vector<VertexBoneData>& Bones)
 {
 	for (uint32_t i = 0; i < pMesh->mNumBones; i++)
 	{
-		uint32_t BoneIndex = 0;
-		std::string BoneName(pMesh->mBones[i]->mName.data);
-		
-		if (m_BoneMapping.find(BoneName) == m_BoneMapping.end())
-		{
-			// Allocate an index for a new bone
-			BoneIndex = m_NumBones;
-			m_NumBones++;
-			BoneInfo bi;
-			m_BoneInfo.push_back(bi);
-			m_BoneInfo[BoneIndex].BoneOffset = pMesh->mBones[i]->mOffsetMatrix;
-			m_BoneMapping[BoneName] = BoneIndex;
-		}
-		else
-		{
-			BoneIndex = m_BoneMapping[BoneName];
-		}
+		uint32_t BoneIndex = skeleton.FindBone(pMesh->mBones[i]->mName.data);
 
 		for (uint32_t j = 0; j < pMesh->mBones[i]->mNumWeights; j++)
 		{
-			uint32_t VertexID = m_Entries[MeshIndex].BaseVertex + pMesh->mBones[i]->mWeights[j].mVertexId;
+			uint32_t VertexID = BaseVertex + pMesh->mBones[i]->mWeights[j].mVertexId;
 			float Weight = pMesh->mBones[i]->mWeights[j].mWeight;
 			Bones[VertexID].AddBoneData(BoneIndex, Weight);
 		}
 	}
 }
 
-void SkinnedMesh::Render(ShaderProgram shader)
+void SkinnedMesh::BindTextures(ShaderProgram& shader, uint32_t MaterialIndex)
 {
-	glBindVertexArray(m_VAO);
+	tinystl::unordered_map<uint32_t, tinystl::vector<Texture>>::iterator itr = mMeshTexturesMap.find(MaterialIndex);
 
-	for (uint32_t i = 0; i < m_Entries.size(); i++)
+	if (itr != mMeshTexturesMap.end())
 	{
-		const uint32_t MaterialIndex = m_Entries[i].MaterialIndex;
-		tinystl::unordered_map<uint32_t, tinystl::vector<Texture>>::iterator itr = mMeshTexturesMap.find(MaterialIndex);
-
-		if (itr != mMeshTexturesMap.end())
+		tinystl::vector<Texture>& textures = itr->second;
+
+		// bind appropriate textures
+		unsigned int diffuseNr = 1;
+		unsigned int specularNr = 1;
+		unsigned int normalNr = 1;
+		unsigned int heightNr = 1;
+		for (unsigned int i = 0; i < textures.size(); i++)
 		{
-			tinystl::vector<Texture>& textures = itr->second;
-
-			// bind appropriate textures
-			unsigned int diffuseNr = 1;
-			unsigned int specularNr = 1;
-			unsigned int normalNr = 1;
-			unsigned int heightNr = 1;
-			for (unsigned int i = 0; i < textures.size(); i++)
-			{
-				glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-				// retrieve texture number (the N in diffuse_textureN)
-				std::string number;
-				std::string name = textures[i].type;
-				if (name == "texture_diffuse")
-					number = std::to_string(diffuseNr++).c_str();
-				else if (name == "texture_specular")
-					number = std::to_string(specularNr++).c_str(); // transfer unsigned int to stream
-				else if (name == "texture_normal")
-					number = std::to_string(normalNr++).c_str(); // transfer unsigned int to stream
-				else if (name == "texture_height")
-					number = std::to_string(heightNr++).c_str(); // transfer unsigned int to stream
-
-														 // now set the sampler to the correct texture unit
-				//glUniform1i(glGetUniformLocation(shader.mID, (name + number).c_str()), i);
-				
-				shader.SetUniform((name + number).c_str(), &i);
-				// and finally bind the texture
-				glBindTexture(GL_TEXTURE_2D, textures[i].id);
-			}
+			glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
+			// retrieve texture number (the N in diffuse_textureN)
+			std::string number;
+			std::string name = textures[i].type;
+			if (name == "texture_diffuse")
+				number = std::to_string(diffuseNr++).c_str();
+			else if (name == "texture_specular")
+				number = std::to_string(specularNr++).c_str(); // transfer unsigned int to stream
+			else if (name == "texture_normal")
+				number = std::to_string(normalNr++).c_str(); // transfer unsigned int to stream
+			else if (name == "texture_height")
+				number = std::to_string(heightNr++).c_str(); // transfer unsigned int to stream
+
+													 // now set the sampler to the correct texture unit
+			//glUniform1i(glGetUniformLocation(shader.mID, (name + number).c_str()), i);
+			
+			shader.SetUniform((name + number).c_str(), &i);
+			// and finally bind the texture
+			glBindTexture(GL_TEXTURE_2D, textures[i].id);
 		}
+	}
+}
+
+void SkinnedMesh::Render(ShaderProgram& shader)
+{
+	glBindVertexArray(m_VAO);
+
+	for (uint32_t i = 0; i < m_Entries.size(); i++)
+	{
+		BindTextures(shader, m_Entries[i].MaterialIndex);
 
 		if (mInstanceCount != 0)
 		{
@@ -1118,262 +1518,620 @@ void SkinnedMesh::Render(ShaderProgram shader)
 	glBindVertexArray(0);
 }
 
+#define SKINNED_VERTEX_SIZE (8 * sizeof(float))
 
-uint32_t SkinnedMesh::FindPosition(float AnimationTime, const aiNodeAnim* pNodeAnim)
+void SkinnedMesh::EnablePreSkinning()
 {
-	for (uint32_t i = 0; i < pNodeAnim->mNumPositionKeys - 1; i++)
+	if (mSkinnedVAO != 0)
+		return;
+
+	const uint32_t Instances = mInstanceCount != 0 ? mInstanceCount : 1;
+	glGenBuffers(1, &mSkinnedBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, mSkinnedBuffer);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)mNumVertices * Instances * SKINNED_VERTEX_SIZE, NULL, GL_STREAM_COPY);
+
+	// same attribute locations as the skinning VAO so every existing vertex shader can read it
+	glGenVertexArrays(1, &mSkinnedVAO);
+	glBindVertexArray(mSkinnedVAO);
+	glEnableVertexAttribArray(POSITION_LOCATION);
+	glVertexAttribPointer(POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, SKINNED_VERTEX_SIZE, (const GLvoid*)0);
+	glEnableVertexAttribArray(NORMAL_LOCATION);
+	glVertexAttribPointer(NORMAL_LOCATION, 3, GL_FLOAT, GL_FALSE, SKINNED_VERTEX_SIZE, (const GLvoid*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(TEX_COORD_LOCATION);
+	glVertexAttribPointer(TEX_COORD_LOCATION, 2, GL_FLOAT, GL_FALSE, SKINNED_VERTEX_SIZE, (const GLvoid*)(6 * sizeof(float)));
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Buffers[INDEX_BUFFER]);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// an instance is just another copy of the vertices further into the buffer,
+	// one multi draw per entry covers all of them
+	const size_t DrawCount = m_Entries.size() * Instances;
+	mPreSkinnedCounts.resize(DrawCount);
+	mPreSkinnedOffsets.resize(DrawCount);
+	mPreSkinnedBaseVertices.resize(DrawCount);
+	for (uint32_t i = 0; i < m_Entries.size(); i++)
 	{
-		if (AnimationTime < (float)pNodeAnim->mPositionKeys[i + 1].mTime)
+		for (uint32_t j = 0; j < Instances; j++)
 		{
-			return i;
+			mPreSkinnedCounts[i * Instances + j] = m_Entries[i].NumIndices;
+			mPreSkinnedOffsets[i * Instances + j] = (const GLvoid*)(sizeof(uint32_t) * m_Entries[i].BaseIndex);
+			mPreSkinnedBaseVertices[i * Instances + j] = m_Entries[i].BaseVertex + j * mNumVertices;
 		}
 	}
+}
 
-	assert(0);
+void SkinnedMesh::PreSkin()
+{
+	assert(mSkinnedVAO != 0);
 
-	return 0;
-}
+	// one point per vertex, instances come out one after the other in draw order
+	glEnable(GL_RASTERIZER_DISCARD);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, mSkinnedBuffer);
+	glBindVertexArray(m_VAO);
 
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArraysInstanced(GL_POINTS, 0, mNumVertices, mInstanceCount != 0 ? mInstanceCount : 1);
+	glEndTransformFeedback();
+
+	glBindVertexArray(0);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glDisable(GL_RASTERIZER_DISCARD);
+}
 
-uint32_t SkinnedMesh::FindRotation(float AnimationTime, const aiNodeAnim* pNodeAnim)
+void SkinnedMesh::RenderPreSkinned(ShaderProgram& shader, bool bindTextures)
 {
-	assert(pNodeAnim->mNumRotationKeys > 0);
+	assert(mSkinnedVAO != 0);
+	glBindVertexArray(mSkinnedVAO);
 
-	for (uint32_t i = 0; i < pNodeAnim->mNumRotationKeys - 1; i++)
+	const uint32_t Instances = mInstanceCount != 0 ? mInstanceCount : 1;
+	for (uint32_t i = 0; i < m_Entries.size(); i++)
 	{
-		if (AnimationTime < (float)pNodeAnim->mRotationKeys[i + 1].mTime)
-		{
-			return i;
-		}
-	}
+		if (bindTextures)
+			BindTextures(shader, m_Entries[i].MaterialIndex);
 
-	assert(0);
+		glMultiDrawElementsBaseVertex(GL_TRIANGLES, &mPreSkinnedCounts[i * Instances], GL_UNSIGNED_INT, &mPreSkinnedOffsets[i * Instances],
+									  Instances, &mPreSkinnedBaseVertices[i * Instances]);
+	}
 
-	return 0;
+	glBindVertexArray(0);
 }
 
-
-uint32_t SkinnedMesh::FindScaling(float AnimationTime, const aiNodeAnim* pNodeAnim)
+void SkinnedMesh::BoneTransform(float TimeInSeconds, tinystl::vector<aiMatrix4x4>& Transforms, tinystl::vector<aiMatrix4x4>& BoneTransforms)
 {
-	assert(pNodeAnim->mNumScalingKeys > 0);
+	if (mPreviousAnimationIndex >= 0 && mCrossfadeStart < 0.0f)
+		mCrossfadeStart = TimeInSeconds;
 
-	for (uint32_t i = 0; i < pNodeAnim->mNumScalingKeys - 1; i++)
+	float Fade = 1.0f;
+	if (mPreviousAnimationIndex >= 0 && mCrossfadeDuration > 0.0f)
+	{
+		Fade = (TimeInSeconds - mCrossfadeStart) / mCrossfadeDuration;
+		Fade = Fade < 0.0f ? 0.0f : Fade;
+	}
+
+	const aiMatrix4x4* pGlobals = mGlobalTransforms.data();
+	if (Fade < 1.0f)
+	{
+		// both clips keep running on the same clock while the weight moves over
+		AnimationLayer Layers[2] = {
+			{ { (uint32_t)mPreviousAnimationIndex, TimeInSeconds }, 1.0f - Fade, ANIMATION_LAYER_BLEND, nullptr },
+			{ { (uint32_t)mCurrentAnimationIndex, TimeInSeconds }, Fade, ANIMATION_LAYER_BLEND, nullptr }
+		};
+		mAnimationSet.EvaluateLayers(Layers, 2, mPose, mBlendScratch);
+		pGlobals = mBlendScratch.globals.data();
+	}
+	else
+	{
+		mPreviousAnimationIndex = -1;
+		AnimationInstance instance = { (uint32_t)mCurrentAnimationIndex, TimeInSeconds };
+		mAnimationSet.EvaluatePose(instance, mPose, mGlobalTransforms.data());
+	}
+
+	// pGlobals still holds every node, parents give the start of each bone line
+	const Skeleton& skeleton = mAnimationSet.GetSkeleton();
+	mLineSegments.clear();
+	for (uint32_t i = 0; i < skeleton.NodeCount(); i++)
 	{
-		if (AnimationTime < (float)pNodeAnim->mScalingKeys[i + 1].mTime) {
-			return i;
+		int32_t BoneIndex = skeleton.Bone(i);
+		if (BoneIndex != INVALID_SKELETON_INDEX)
+		{
+			aiMatrix4x4 ParentTransform;
+			if (skeleton.Parent(i) != INVALID_SKELETON_INDEX)
+				ParentTransform = pGlobals[skeleton.Parent(i)];
+
+			mLineSegments.emplace_back(LineSegment(skeleton.GlobalInverseTransform() * ParentTransform, mPose.bones[BoneIndex]));
 		}
 	}
 
-	assert(0);
+	Transforms.resize(NumBones());
+	BoneTransforms.resize(NumBones());
 
-	return 0;
+	for (uint32_t i = 0; i < NumBones(); i++)
+	{
+		Transforms[i] = mPose.skinning[i];
+		BoneTransforms[i] = mPose.bones[i];
+	}
 }
 
-
-void SkinnedMesh::CalcInterpolatedPosition(aiVector3D& Out, float AnimationTime, const aiNodeAnim* pNodeAnim)
+void SkinnedMesh::SetCurrentAnimation(int& index)
 {
-	if (pNodeAnim->mNumPositionKeys == 1) {
-		Out = pNodeAnim->mPositionKeys[0].mValue;
-		return;
-	}
+	if (index >= (int)mAnimationSet.ClipCount())
+		index = 0;
+	else if (index < 0)
+		index = (int)mAnimationSet.ClipCount()-1;
 
-	uint32_t PositionIndex = FindPosition(AnimationTime, pNodeAnim);
-	uint32_t NextPositionIndex = (PositionIndex + 1);
-	assert(NextPositionIndex < pNodeAnim->mNumPositionKeys);
-	float DeltaTime = (float)(pNodeAnim->mPositionKeys[NextPositionIndex].mTime - pNodeAnim->mPositionKeys[PositionIndex].mTime);
-	float Factor = (AnimationTime - (float)pNodeAnim->mPositionKeys[PositionIndex].mTime) / DeltaTime;
-	assert(Factor >= 0.0f && Factor <= 1.0f);
-	const aiVector3D& Start = pNodeAnim->mPositionKeys[PositionIndex].mValue;
-	const aiVector3D& End = pNodeAnim->mPositionKeys[NextPositionIndex].mValue;
-	aiVector3D Delta = End - Start;
-	Out = Start + Factor * Delta;
+	if (index != mCurrentAnimationIndex)
+	{
+		// a switch mid fade starts a new fade from the clip that was fading in
+		mPreviousAnimationIndex = mCurrentAnimationIndex;
+		mCrossfadeStart = -1.0f;
+		mCurrentAnimationIndex = index;
+	}
 }
 
-
-void SkinnedMesh::CalcInterpolatedRotation(Quaternion& Out, float AnimationTime, const aiNodeAnim* pNodeAnim)
+//////////////////////////////////////////////// BONE PALETTE
+BonePaletteBuffer::BonePaletteBuffer(uint32_t matricesPerFrame) : mMatricesPerFrame(matricesPerFrame)
 {
-	// we need at least two values to interpolate...
-	if (pNodeAnim->mNumRotationKeys == 1) {
-		Out = pNodeAnim->mRotationKeys[0].mValue;
-		return;
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	assert((GLint64)matricesPerFrame * 4 * BONE_PALETTE_FRAMES <= (GLint64)maxTexels);
+
+	GLsizeiptr size = (GLsizeiptr)sizeof(aiMatrix4x4) * matricesPerFrame * BONE_PALETTE_FRAMES;
+
+	glGenBuffers(1, &mBuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, mBuffer);
+	if (GLAD_GL_VERSION_4_4)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_TEXTURE_BUFFER, size, NULL, flags);
+		mpPersistent = (uint8_t*)glMapBufferRange(GL_TEXTURE_BUFFER, 0, size, flags);
+	}
+	else
+	{
+		glBufferData(GL_TEXTURE_BUFFER, size, NULL, GL_STREAM_DRAW);
 	}
 
-	uint32_t RotationIndex = FindRotation(AnimationTime, pNodeAnim);
-	uint32_t NextRotationIndex = (RotationIndex + 1);
-	assert(NextRotationIndex < pNodeAnim->mNumRotationKeys);
-	float DeltaTime = (float)(pNodeAnim->mRotationKeys[NextRotationIndex].mTime - pNodeAnim->mRotationKeys[RotationIndex].mTime);
-	float Factor = (AnimationTime - (float)pNodeAnim->mRotationKeys[RotationIndex].mTime) / DeltaTime;
-	assert(Factor >= 0.0f && Factor <= 1.0f);
-	const Quaternion& StartRotationQ = pNodeAnim->mRotationKeys[RotationIndex].mValue;
-	const Quaternion& EndRotationQ = pNodeAnim->mRotationKeys[NextRotationIndex].mValue;
-	Out = Quaternion::interpolate(StartRotationQ, EndRotationQ, Factor);
-	Out.Normalize();
+	// one row of a matrix per texel
+	glGenTextures(1, &mTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, mTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, mBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
 }
 
-
-void SkinnedMesh::CalcInterpolatedScaling(aiVector3D& Out, float AnimationTime, const aiNodeAnim* pNodeAnim)
+BonePaletteBuffer::~BonePaletteBuffer()
 {
-	if (pNodeAnim->mNumScalingKeys == 1) {
-		Out = pNodeAnim->mScalingKeys[0].mValue;
-		return;
+	for (GLsync fence : mFences)
+	{
+		if (fence)
+			glDeleteSync(fence);
 	}
 
-	uint32_t ScalingIndex = FindScaling(AnimationTime, pNodeAnim);
-	uint32_t NextScalingIndex = (ScalingIndex + 1);
-	assert(NextScalingIndex < pNodeAnim->mNumScalingKeys);
-	float DeltaTime = (float)(pNodeAnim->mScalingKeys[NextScalingIndex].mTime - pNodeAnim->mScalingKeys[ScalingIndex].mTime);
-	float Factor = (AnimationTime - (float)pNodeAnim->mScalingKeys[ScalingIndex].mTime) / DeltaTime;
-	assert(Factor >= 0.0f && Factor <= 1.0f);
-	const aiVector3D& Start = pNodeAnim->mScalingKeys[ScalingIndex].mValue;
-	const aiVector3D& End = pNodeAnim->mScalingKeys[NextScalingIndex].mValue;
-	aiVector3D Delta = End - Start;
-	Out = Start + Factor * Delta;
-}
+	if (mpPersistent || mpMapped)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, mBuffer);
+		glUnmapBuffer(GL_TEXTURE_BUFFER);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
 
+	glDeleteTextures(1, &mTexture);
+	glDeleteBuffers(1, &mBuffer);
+}
 
-void SkinnedMesh::ReadNodeHeirarchy(float AnimationTime, const aiNode* pNode, const aiMatrix4x4& ParentTransform)
+void BonePaletteBuffer::BeginFrame()
 {
-	std::string NodeName(pNode->mName.data);
-
-	const aiAnimation* pAnimation = mAnimations[mCurrentAnimationIndex];
-	
-	aiMatrix4x4 NodeTransformation(pNode->mTransformation);
+	mFrame = (mFrame + 1) % BONE_PALETTE_FRAMES;
+	mUsed = 0;
 
-	const aiNodeAnim* pNodeAnim = FindNodeAnim(pAnimation, NodeName);
-
-	if (pNodeAnim)
+	// only blocks when the GPU is more than BONE_PALETTE_FRAMES - 1 frames behind
+	GLsync& fence = mFences[mFrame];
+	if (fence)
 	{
-		// Interpolate scaling and generate scaling transformation matrix
-		aiVector3D Scaling;
-		CalcInterpolatedScaling(Scaling, AnimationTime, pNodeAnim);
-		aiMatrix4x4 ScalingM;
-		aiMatrix4x4::Scaling(Scaling, ScalingM);
-
-		// Interpolate rotation and generate rotation transformation matrix
-		Quaternion RotationQ;
-		CalcInterpolatedRotation(RotationQ, AnimationTime, pNodeAnim);
-		aiMatrix4x4 RotationM = RotationQ.toAiRotationMatrix();
-
-		// Interpolate translation and generate translation transformation matrix
-		aiVector3D Translation;
-		CalcInterpolatedPosition(Translation, AnimationTime, pNodeAnim);
-		aiMatrix4x4 TranslationM;
-		aiMatrix4x4::Translation(Translation, TranslationM);
-		
-		// Combine the above transformations
-		NodeTransformation = TranslationM * RotationM * ScalingM;
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+		glDeleteSync(fence);
+		fence = 0;
 	}
 
-	aiMatrix4x4 GlobalTransformation = ParentTransform * NodeTransformation;
-
-	if (m_BoneMapping.find(NodeName) != m_BoneMapping.end())
+	GLintptr offset = (GLintptr)sizeof(aiMatrix4x4) * mMatricesPerFrame * mFrame;
+	if (mpPersistent)
 	{
-		uint32_t BoneIndex = m_BoneMapping[NodeName];
-		m_BoneInfo[BoneIndex].FinalTransformation = m_GlobalInverseTransform * GlobalTransformation * m_BoneInfo[BoneIndex].BoneOffset;	
-		m_BoneInfo[BoneIndex].m_BoneInverseTransform = m_GlobalInverseTransform * GlobalTransformation;
-		mLineSegments.emplace_back(LineSegment( m_GlobalInverseTransform*ParentTransform, m_BoneInfo[BoneIndex].m_BoneInverseTransform ));
+		mpMapped = mpPersistent + offset;
 	}
-	
-	for (uint32_t i = 0; i < pNode->mNumChildren; i++)
+	else
 	{
-		ReadNodeHeirarchy(AnimationTime, pNode->mChildren[i], GlobalTransformation);
+		// the fence already guarantees the GPU is done with the segment
+		glBindBuffer(GL_TEXTURE_BUFFER, mBuffer);
+		mpMapped = (uint8_t*)glMapBufferRange(GL_TEXTURE_BUFFER, offset, (GLsizeiptr)sizeof(aiMatrix4x4) * mMatricesPerFrame,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
 	}
 }
 
+uint32_t BonePaletteBuffer::Allocate(uint32_t count, aiMatrix4x4** ppMatrices)
+{
+	assert(mpMapped && "Allocate() outside of BeginFrame() / Commit()");
+	assert(mUsed + count <= mMatricesPerFrame);
 
-void SkinnedMesh::BoneTransform(float TimeInSeconds, tinystl::vector<aiMatrix4x4>& Transforms, tinystl::vector<aiMatrix4x4>& BoneTransforms)
+	*ppMatrices = (aiMatrix4x4*)mpMapped + mUsed;
+	uint32_t first = mMatricesPerFrame * mFrame + mUsed;
+	mUsed += count;
+	return first;
+}
+
+uint32_t BonePaletteBuffer::Upload(const aiMatrix4x4* pMatrices, uint32_t count)
 {
-	aiMatrix4x4 Identity;
+	aiMatrix4x4* pDst;
+	uint32_t first = Allocate(count, &pDst);
+	memcpy(pDst, pMatrices, sizeof(aiMatrix4x4) * count);
+	return first;
+}
 
-	float TicksPerSecond = (float)(mAnimations[mCurrentAnimationIndex]->mTicksPerSecond != 0 ? mAnimations[mCurrentAnimationIndex]->mTicksPerSecond : 25.0f);
-	float TimeInTicks = TimeInSeconds * TicksPerSecond;
-	float AnimationTime = fmod(TimeInTicks, (float)mAnimations[mCurrentAnimationIndex]->mDuration);
+void BonePaletteBuffer::Commit()
+{
+	if (!mpPersistent && mpMapped)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, mBuffer);
+		glUnmapBuffer(GL_TEXTURE_BUFFER);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+	mpMapped = nullptr;
+}
 
-	mLineSegments.clear();
-	ReadNodeHeirarchy(AnimationTime, m_pScene->mRootNode, Identity);
+void BonePaletteBuffer::EndFrame()
+{
+	mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
 
-	Transforms.resize(m_NumBones);
-	BoneTransforms.resize(m_NumBones);
+void BonePaletteBuffer::Bind(ShaderProgram& shader)
+{
+	int unit = BONE_PALETTE_TEXTURE_UNIT;
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_BUFFER, mTexture);
+	shader.SetUniform("gBonePalette", &unit);
+	glActiveTexture(GL_TEXTURE0);
+}
 
-	for (uint32_t i = 0; i < m_NumBones; i++)
+BakedAnimation::~BakedAnimation()
+{
+	if (mTexture != 0)
 	{
-		Transforms[i] = m_BoneInfo[i].FinalTransformation;
-		BoneTransforms[i] = m_BoneInfo[i].m_BoneInverseTransform;
+		glDeleteTextures(1, &mTexture);
 	}
 }
 
-const aiNodeAnim* SkinnedMesh::FindNodeAnim(const aiAnimation* pAnimation, const std::string NodeName)
+void BakedAnimation::Bake(const SkinnedMesh& mesh, uint32_t clip, float framesPerSecond)
 {
-	for (uint32_t i = 0; i < pAnimation->mNumChannels; i++)
+	const AnimationSet& set = mesh.Animations();
+	assert(clip < set.ClipCount());
+
+	const AnimationClip& Clip = set.Clip(clip);
+	const float Seconds = Clip.Duration() / Clip.TicksPerSecond();
+	mBoneCount = set.GetSkeleton().BoneCount();
+	mFrameCount = (uint32_t)ceilf(Seconds * framesPerSecond);
+	if (mFrameCount == 0)
+		mFrameCount = 1;
+	// a clip without duration is one pose, a rate of 0 keeps the shader on frame 0 instead of dividing by 0
+	mFrameRate = Seconds > 0.0f ? mFrameCount / Seconds : 0.0f;
+
+	int32_t maxSize;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+	assert(mBoneCount * 3 <= (uint32_t)maxSize && mFrameCount + 1 <= (uint32_t)maxSize);
+
+	const uint32_t RowTexels = mBoneCount * 3;
+	std::vector<glm::vec4> texels((size_t)(mFrameCount + 1) * RowTexels);
+
+	AnimationPose pose;
+	std::vector<aiMatrix4x4> globals(set.GetSkeleton().NodeCount());
+	for (uint32_t f = 0; f < mFrameCount; f++)
 	{
-		const aiNodeAnim* pNodeAnim = pAnimation->mChannels[i];
+		AnimationInstance instance = { clip, mFrameRate > 0.0f ? f / mFrameRate : 0.0f };
+		set.EvaluatePose(instance, pose, globals.data());
 
-		if (std::string(pNodeAnim->mNodeName.data) == NodeName)
+		glm::vec4* pRow = &texels[(size_t)f * RowTexels];
+		for (uint32_t b = 0; b < mBoneCount; b++)
 		{
-			return pNodeAnim;
+			const aiMatrix4x4& m = pose.skinning[b];
+			pRow[b * 3 + 0] = glm::vec4(m.a1, m.a2, m.a3, m.a4);
+			pRow[b * 3 + 1] = glm::vec4(m.b1, m.b2, m.b3, m.b4);
+			pRow[b * 3 + 2] = glm::vec4(m.c1, m.c2, m.c3, m.c4);
 		}
 	}
+	// wrap around row for the lerp out of the last frame
+	memcpy(&texels[(size_t)mFrameCount * RowTexels], &texels[0], sizeof(glm::vec4) * RowTexels);
+
+	if (mTexture == 0)
+		glGenTextures(1, &mTexture);
+	glBindTexture(GL_TEXTURE_2D, mTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, RowTexels, mFrameCount + 1, 0, GL_RGBA, GL_FLOAT, texels.data());
+	// only ever texelFetch'ed
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void BakedAnimation::Bind(ShaderProgram& shader)
+{
+	int unit = BAKED_ANIMATION_TEXTURE_UNIT;
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, mTexture);
+	shader.SetUniform("gBakedBones", &unit);
+	glActiveTexture(GL_TEXTURE0);
 
-	return NULL;
+	int frameCount = (int)mFrameCount;
+	shader.SetUniform("gBakedFrameCount", &frameCount);
+	shader.SetUniform("gBakedFrameRate", &mFrameRate);
 }
 
-void SkinnedMesh::SetCurrentAnimation(int& index)
+//////////////////////////////////////////////// ASSET LOADER
+struct AssetLoader::Item
 {
-	if (index >= (int)mAnimations.size())
+	enum Type
 	{
-		mCurrentAnimationIndex = 0;
-		index = mCurrentAnimationIndex;
+		MESH,
+		TEXTURE
+	};
+
+	Type type;
+	std::string path;
+	AssetLoader* pLoader = NULL;
+	bool ok = false;
+	AssetTimings timings;
+
+	// MESH
+	SkinnedMesh* pMesh = NULL;
+	uint32_t instanceCount = 0;
+	bool useCache = true;
+	CookedMeshFile cooked;
+
+	// TEXTURE, every mesh waiting on it with the path its materials use
+	TextureImage image;
+	std::vector<std::pair<SkinnedMesh*, std::string>> users;
+};
+
+AssetLoader::AssetLoader(JobSystem* pJobSystem) : mpJobSystem(pJobSystem)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+	mpJobSystem->Wait(&mCounter);
+
+	for (std::pair<SkinnedMesh* const, uint32_t>& waiting : mWaiting)
+	{
+		waiting.first->mpLoader = NULL;
 	}
-	else if (index < 0)
+
+	for (Item* pItem : mReady)
 	{
-		mCurrentAnimationIndex = (int)mAnimations.size()-1;
-		index = mCurrentAnimationIndex;
+		delete pItem;
+	}
+	for (Item* pItem : mUploads)
+	{
+		delete pItem;
 	}
-	else
-		mCurrentAnimationIndex = index;
 }
 
-PBRMat_Tex::~PBRMat_Tex()
+void AssetLoader::LoadMesh(SkinnedMesh* pMesh, const std::string& Filename, uint32_t instanceCount)
 {
-	if (albedo != (unsigned int)INVALID_TEXTURE_ID)
+	Item* pItem = new Item();
+	pItem->type = Item::MESH;
+	pItem->path = Filename;
+	pItem->pMesh = pMesh;
+	pItem->instanceCount = instanceCount;
+	pItem->useCache = pMesh->mUseCookedMesh;
+
+	pMesh->mpLoader = this;
+	mWaiting[pMesh]++;
+	mMeshes.push_back(pItem);
+	schedule(pItem);
+}
+
+void AssetLoader::Cancel(SkinnedMesh* pMesh)
+{
+	// mesh items only hand pMesh to upload, the workers never read it
+	for (Item* pItem : mMeshes)
+	{
+		if (pItem->pMesh == pMesh)
+			pItem->pMesh = NULL;
+	}
+	for (std::pair<const std::string, Item*>& texture : mTextures)
+	{
+		std::vector<std::pair<SkinnedMesh*, std::string>>& users = texture.second->users;
+		users.erase(std::remove_if(users.begin(), users.end(),
+								   [pMesh](const std::pair<SkinnedMesh*, std::string>& user) { return user.first == pMesh; }),
+					users.end());
+	}
+
+	mWaiting.erase(pMesh);
+	pMesh->mpLoader = NULL;
+}
+
+void AssetLoader::release(SkinnedMesh* pMesh)
+{
+	std::unordered_map<SkinnedMesh*, uint32_t>::iterator itr = mWaiting.find(pMesh);
+	if (itr != mWaiting.end() && --itr->second == 0)
 	{
-		glDeleteTextures(1, &albedo);
+		pMesh->mpLoader = NULL;
+		mWaiting.erase(itr);
 	}
-	if (metallic != (unsigned int)INVALID_TEXTURE_ID)
+}
+
+void AssetLoader::schedule(Item* pItem)
+{
+	if (mPending++ == 0)
+		mStart = Clock::now();
+
+	pItem->pLoader = this;
+	mpJobSystem->Run(loadJob, pItem, 0, &mCounter);
+}
+
+void AssetLoader::loadJob(void* pData, uint32 index)
+{
+	Item* pItem = (Item*)pData;
+	if (pItem->type == Item::MESH)
+		pItem->ok = SkinnedMesh::Cook(pItem->path, pItem->useCache, pItem->cooked, &pItem->timings);
+	else
+		pItem->ok = DecodeTexture(pItem->path.c_str(), pItem->image, &pItem->timings);
+
+	AssetLoader* pLoader = pItem->pLoader;
+	std::lock_guard<std::mutex> lock(pLoader->mReadyMutex);
+	pLoader->mReady.push_back(pItem);
+}
+
+void AssetLoader::Update(float budgetMs)
+{
+	if (mPending == 0)
+		return;
+
+	Clock::time_point start = Clock::now();
+
+	// no workers, the render thread does the loading as well
+	if (mpJobSystem->threadCount() == 1)
+		mpJobSystem->RunPendingJob();
+
 	{
-		glDeleteTextures(1, &metallic);
+		std::lock_guard<std::mutex> lock(mReadyMutex);
+		mUploads.insert(mUploads.end(), mReady.begin(), mReady.end());
+		mReady.clear();
 	}
-	if (roughness != (unsigned int)INVALID_TEXTURE_ID)
+
+	if (mUploads.empty())
+		return;
+
+	do
+	{
+		Item* pItem = mUploads.front();
+		mUploads.pop_front();
+		upload(pItem);
+	} while (!mUploads.empty() && elapsedMs(start) < budgetMs);
+
+	double frameMs = elapsedMs(start);
+	mStats.frames++;
+	mStats.maxFrameMs = frameMs > mStats.maxFrameMs ? frameMs : mStats.maxFrameMs;
+	mStats.wallMs = elapsedMs(mStart);
+}
+
+void AssetLoader::upload(Item* pItem)
+{
+	Clock::time_point start = Clock::now();
+
+	if (pItem->type == Item::MESH)
 	{
-		glDeleteTextures(1, &roughness);
+		mMeshes.erase(std::find(mMeshes.begin(), mMeshes.end(), pItem));
+		// a mesh deleted while it was loading is just dropped
+		if (pItem->pMesh && pItem->ok && pItem->pMesh->InitFromCooked(pItem->path, pItem->cooked, pItem->instanceCount, false))
+		{
+			// textures follow as jobs of their own, one per file however many meshes use it
+			std::vector<std::string> paths;
+			pItem->pMesh->PendingTextures(paths);
+			for (const std::string& path : paths)
+			{
+				std::string fullPath = pItem->pMesh->Directory() + "/" + path;
+				std::string key = TextureRegistry::Key(fullPath.c_str());
+				std::unordered_map<std::string, Item*>::iterator itr = mTextures.find(key);
+				if (itr == mTextures.end())
+				{
+					Item* pTexture = new Item();
+					pTexture->type = Item::TEXTURE;
+					pTexture->path = fullPath;
+					itr = mTextures.emplace(key, pTexture).first;
+					schedule(pTexture);
+				}
+				itr->second->users.push_back(std::make_pair(pItem->pMesh, path));
+				mWaiting[pItem->pMesh]++;
+			}
+		}
+		else if (pItem->pMesh)
+		{
+			printf("Error loading '%s'\n", pItem->path.c_str());
+		}
+		if (pItem->pMesh)
+			release(pItem->pMesh);
+
+		pItem->timings.upload += elapsedMs(start);
+		mStats.meshes.read += pItem->timings.read;
+		mStats.meshes.decode += pItem->timings.decode;
+		mStats.meshes.upload += pItem->timings.upload;
+		mStats.meshCount++;
 	}
-	if (ao != (unsigned int)INVALID_TEXTURE_ID)
+	else
 	{
-		glDeleteTextures(1, &ao);
+		if (pItem->ok)
+		{
+			// the loader's reference only lasts until every waiting mesh took its own
+			uint32_t id = gTextureRegistry.Add(pItem->path.c_str(), UploadTexture(pItem->image));
+			for (std::pair<SkinnedMesh*, std::string>& user : pItem->users)
+			{
+				user.first->SetTexture(user.second, id);
+			}
+			gTextureRegistry.Release(id);
+		}
+		else
+		{
+			printf("Error loading '%s'\n", pItem->path.c_str());
+		}
+		for (std::pair<SkinnedMesh*, std::string>& user : pItem->users)
+		{
+			release(user.first);
+		}
+		mTextures.erase(TextureRegistry::Key(pItem->path.c_str()));
+
+		pItem->timings.upload += elapsedMs(start);
+		mStats.textures.read += pItem->timings.read;
+		mStats.textures.decode += pItem->timings.decode;
+		mStats.textures.upload += pItem->timings.upload;
+		mStats.textureCount++;
 	}
+
+	mPending--;
+	delete pItem;
+}
+
+void AssetLoader::PrintStats() const
+{
+	printf("asset loader: %u meshes, %u textures in %.1f ms over %u frames, longest frame %.2f ms\n",
+		mStats.meshCount, mStats.textureCount, mStats.wallMs, mStats.frames, mStats.maxFrameMs);
+	printf("  meshes   read %8.1f ms  import %8.1f ms  upload %8.1f ms\n", mStats.meshes.read, mStats.meshes.decode, mStats.meshes.upload);
+	printf("  textures read %8.1f ms  decode %8.1f ms  upload %8.1f ms\n", mStats.textures.read, mStats.textures.decode, mStats.textures.upload);
+	printf("  %u textures resident, %u references shared\n", gTextureRegistry.ResidentCount(), gTextureRegistry.SharedCount());
+}
+
+PBRMat_Tex::~PBRMat_Tex()
+{
+	// the registry ignores INVALID_TEXTURE_ID
+	gTextureRegistry.Release(albedo);
+	gTextureRegistry.Release(normal);
+	gTextureRegistry.Release(metallic);
+	gTextureRegistry.Release(roughness);
+	gTextureRegistry.Release(ao);
 }
 
 void PBRMat_Tex::LoadPBRTexture(const char* filepath, PBRTextureType type)
 {
-	unsigned int texture_id = (unsigned int)LoadTexture(filepath);
+	unsigned int* pSlot = NULL;
 	switch (type)
 	{
 	case ALBEDO:
-		albedo = texture_id;
+		pSlot = &albedo;
 		break;
 	case NORMAL:
-		normal = texture_id;
+		pSlot = &normal;
 		break;
 	case METALLIC:
-		metallic = texture_id;
+		pSlot = &metallic;
 		break;
 	case ROUGHNESS:
-		roughness = texture_id;
+		pSlot = &roughness;
 		break;
 	case AO:
-		ao = texture_id;
+		pSlot = &ao;
 		break;
 	}
+
+	unsigned int texture_id = (unsigned int)gTextureRegistry.Acquire(filepath);
+	gTextureRegistry.Release(*pSlot);
+	*pSlot = texture_id;
 }
 
 void PBRMat_Tex::BindTextures()
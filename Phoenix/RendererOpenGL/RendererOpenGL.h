@@ -1,5 +1,7 @@
 #pragma once
 
+#include <deque>
+#include <mutex>
 #include <unordered_map>
 #include <string>
 
@@ -7,6 +9,8 @@
 #include "../../Common/Thirdparty/TINYSTL/vector.h"
 #include "../../Common/Thirdparty/TINYSTL/unordered_map.h"
 #include "../../Common/Renderer/keyBindings.h"
+#include "../../Common/Renderer/CookedMesh.h"
+#include "../../Common/Renderer/MeshOptimizer.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -19,6 +23,9 @@
 #include <assimp/postprocess.h>
 
 #include "Quaternion.h"
+#include "Animation/AnimationSet.h"
+#include "../../Middleware/Jobs/JobSystem.h"
+#include "../../Middleware/Profiling/Timer.h"
 
 struct Uniform
 {
@@ -30,12 +37,17 @@ class ShaderProgram
 {
 public:
 	ShaderProgram(std::string vertexShaderPath, std::string fragmentShaderPath);
+	// vertex only, the named outputs are captured interleaved by transform feedback
+	ShaderProgram(std::string vertexShaderPath, const char* const* pFeedbackVaryings, uint32_t varyingCount);
 	~ShaderProgram();
 
 	void SetUniform(const char*, void*);
 
 	int mId;
 	std::unordered_map<size_t, Uniform> mUniformVarMap;
+
+private:
+	void reflectUniforms();
 };
 
 
@@ -48,6 +60,19 @@ struct Texture
 	std::string path;
 };
 
+// milliseconds spent in each stage of loading an asset, summed over the threads that ran it
+struct AssetTimings
+{
+	double read = 0.0;	 // file I/O, hashing and mapping the asset cache
+	double decode = 0.0; // assimp import and cooking, image decode
+	double upload = 0.0; // GL calls, render thread only
+};
+
+// part of the asset cache key, see SkinnedMesh::LoadMesh
+#define SKINNED_MESH_IMPORT_FLAGS (aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices)
+
+class AssetLoader;
+
 class SkinnedMesh
 {
 public:
@@ -56,15 +81,71 @@ public:
 	~SkinnedMesh();
 
 	bool LoadMesh(const std::string& Filename, uint32_t instanceCount = 0);
+
+	// LoadMesh in two halves so the first one can run on a worker, see AssetLoader.
+	// Cook maps the mesh from the asset cache or imports it through assimp, any thread.
+	static bool Cook(const std::string& Filename, bool useCache, CookedMeshFile& cooked, AssetTimings* pTimings = NULL);
+	// creates the GL buffers, textures are loaded right away or left to SetTexture
+	bool InitFromCooked(const std::string& Filename, const CookedMeshFile& cooked, uint32_t instanceCount, bool loadTextures);
+
+	// material texture paths, relative to Directory(), still waiting for SetTexture
+	void PendingTextures(std::vector<std::string>& paths) const;
+	// id is a gTextureRegistry texture, every slot using path takes a reference
+	void SetTexture(const std::string& path, uint32_t id);
+
+	// false until the buffers are up, Render draws nothing before that
+	bool IsLoaded() const
+	{
+		return !m_Entries.empty();
+	}
+
+	const std::string& Directory() const
+	{
+		return directory;
+	}
+
+	// what the source's bytes are hashed on top of to find its entry in the asset cache
+	static uint64_t CacheSeed();
+
+	// tolerances of every clip a mesh loads, cooked or added with AddAnimation. They are part of
+	// CacheSeed so cooked clips are redone when they change, set them before loading anything
+	static ClipCompression sClipCompression;
+
 	void AddAnimation(const std::string& Filename);
 
-	void Render(ShaderProgram shader);
+	void Render(ShaderProgram& shader);
+
+	// Pre-skinning: every vertex of every instance is skinned once per frame into a world space
+	// buffer, the passes after that draw it like static geometry (model identity, isAnim and
+	// isInstanced off) instead of skinning again in each of them.
+	void EnablePreSkinning();
+
+	// call with the transform feedback program (skinning_feedback.vert) in use, the bone
+	// palette bound and model/isAnim/isInstanced set like for Render
+	void PreSkin();
+	// depth only passes can skip the material textures
+	void RenderPreSkinned(ShaderProgram& shader, bool bindTextures = true);
 
 	uint32_t NumBones() const
 	{
-		return m_NumBones;
+		return mAnimationSet.GetSkeleton().BoneCount();
+	}
+
+	// Skeleton and clips, shared by every instance drawn with this mesh.
+	// Evaluate crowds through an AnimationBatch with one AnimationInstance/AnimationPose each.
+	const AnimationSet& Animations() const
+	{
+		return mAnimationSet;
 	}
 
+	// named marker at seconds into a clip, queried through Animations().Curves(clip)
+	void AddAnimationEvent(uint32_t clip, const char* name, float seconds)
+	{
+		mAnimationSet.AddEvent(clip, name, seconds);
+	}
+
+	// Evaluates the mesh's own instance (SetCurrentAnimation), crossfading for mCrossfadeDuration
+	// after a switch. Also fills mLineSegments.
 	void BoneTransform(float TimeInSeconds, tinystl::vector<aiMatrix4x4>& Transforms, tinystl::vector<aiMatrix4x4>& BoneTransforms);
 
 	struct LineSegment
@@ -78,33 +159,38 @@ public:
 	};
 	std::vector<LineSegment> mLineSegments;
 
-	std::vector<const aiAnimation*> mAnimations;
 	void SetCurrentAnimation(int& index);
 
 	bool mIsAnim = false;
 	unsigned int instanceVBO;
 
+	// load from / write to the asset cache, off always imports through assimp
+	bool mUseCookedMesh = true;
+
+	// seconds, 0 cuts straight to the new clip
+	float mCrossfadeDuration = 0.3f;
+
 private:
+	friend class AssetLoader;
+	AssetLoader* mpLoader = NULL; // while the loader still has the mesh or its textures queued
+
 	int mCurrentAnimationIndex = 0;
+	int mPreviousAnimationIndex = -1; // clip fading out, -1 when not crossfading
+	float mCrossfadeStart = -1.0f;	  // set by the first BoneTransform after a switch
 
 	std::string directory;
-	tinystl::vector<Texture> textures_loaded;
-	tinystl::vector<Texture> InitMaterials(const aiMaterial* material, aiTextureType type, std::string typeName);
-
-#define NUM_BONES_PER_VEREX 4
 
-	struct BoneInfo
+	// one texture of a material, fixed size so the table cooks as is. Every slot holds its own
+	// reference in gTextureRegistry, released with the mesh
+	struct MaterialTexture
 	{
-		aiMatrix4x4 BoneOffset;
-		aiMatrix4x4 FinalTransformation;
-		aiMatrix4x4 m_BoneInverseTransform;
-
-		BoneInfo()
-		{
-			//BoneOffset.SetZero();
-			//FinalTransformation.SetZero();
-		}
+		uint32_t material;
+		uint32_t type; // index into the diffuse, specular, normal, height type names
+		char path[248];
 	};
+	void InitMaterials(const MaterialTexture* pTextures, uint32_t count, bool loadTextures);
+
+#define NUM_BONES_PER_VEREX 4
 
 	struct VertexBoneData
 	{
@@ -127,23 +213,18 @@ private:
 		void AddBoneData(uint32_t BoneID, float Weight);
 	};
 
-	void CalcInterpolatedScaling(aiVector3D& Out, float AnimationTime, const aiNodeAnim* pNodeAnim);
-	void CalcInterpolatedRotation(Quaternion& Out, float AnimationTime, const aiNodeAnim* pNodeAnim);
-	void CalcInterpolatedPosition(aiVector3D& Out, float AnimationTime, const aiNodeAnim* pNodeAnim);
-	uint32_t FindScaling(float AnimationTime, const aiNodeAnim* pNodeAnim);
-	uint32_t FindRotation(float AnimationTime, const aiNodeAnim* pNodeAnim);
-	uint32_t FindPosition(float AnimationTime, const aiNodeAnim* pNodeAnim);
-	const aiNodeAnim* FindNodeAnim(const aiAnimation* pAnimation, const std::string NodeName);
-	void ReadNodeHeirarchy(float AnimationTime, const aiNode* pNode, const aiMatrix4x4& ParentTransform);
-	bool InitFromScene(const aiScene* pScene, const std::string& Filename);
-	void InitMesh(uint32_t MeshIndex,
+	static void CookScene(const aiScene* pScene, CookedMeshWriter& writer);
+	static bool isValidCooked(const CookedMeshFile& cooked);
+	void InitBuffers(const aiVector3D* pPositions, const aiVector3D* pNormals, const aiVector2D* pTexCoords, const VertexBoneData* pBones, uint32_t NumVertices, const uint32_t* pIndices, uint32_t NumIndices);
+	static void InitMesh(uint32_t BaseVertex,
 		const aiMesh* paiMesh,
+		const Skeleton& skeleton,
 		tinystl::vector<aiVector3D>& Positions,
 		tinystl::vector<aiVector3D>& Normals,
 		tinystl::vector<aiVector2D>& TexCoords,
 		tinystl::vector<VertexBoneData>& Bones,
 		tinystl::vector<unsigned int>& Indices);
-	void LoadBones(uint32_t MeshIndex, const aiMesh* paiMesh, tinystl::vector<VertexBoneData>& Bones);
+	static void LoadBones(uint32_t BaseVertex, const aiMesh* paiMesh, const Skeleton& skeleton, tinystl::vector<VertexBoneData>& Bones);
 
 #define INVALID_MATERIAL 0xFFFFFFFF
 
@@ -159,6 +240,17 @@ private:
 	uint32_t m_VAO;
 	uint32_t m_Buffers[NUM_VBs];
 	uint32_t mInstanceCount = 0;
+	uint32_t mNumVertices = 0;
+
+	// interleaved position, normal, texcoord per vertex, instance after instance
+	uint32_t mSkinnedBuffer = 0;
+	uint32_t mSkinnedVAO = 0;
+	// multi draw arguments of RenderPreSkinned, Instances per entry one after the other
+	tinystl::vector<GLsizei> mPreSkinnedCounts;
+	tinystl::vector<const GLvoid*> mPreSkinnedOffsets;
+	tinystl::vector<GLint> mPreSkinnedBaseVertices;
+
+	void BindTextures(ShaderProgram& shader, uint32_t MaterialIndex);
 
 
 	struct MeshEntry {
@@ -180,13 +272,172 @@ private:
 	//tinystl::vector<Texture> m_Textures;
 	tinystl::unordered_map<uint32_t, tinystl::vector<Texture>> mMeshTexturesMap;
 
-	std::unordered_map<std::string, uint32_t> m_BoneMapping; // maps a bone name to its index
-	uint32_t m_NumBones;
-	tinystl::vector<BoneInfo> m_BoneInfo;
-	aiMatrix4x4 m_GlobalInverseTransform;
+	AnimationSet mAnimationSet;
+	AnimationPose mPose;
+	std::vector<aiMatrix4x4> mGlobalTransforms; // per node, reused every evaluation
+	PoseScratch mBlendScratch;
+};
+
+
+/////////////////////
+// BONE PALETTE
+#define BONE_PALETTE_FRAMES		  3
+#define BONE_PALETTE_TEXTURE_UNIT 15
+
+// Skinning matrices of every skinned draw of a frame, in one texture buffer.
+// The buffer is split into BONE_PALETTE_FRAMES segments used round robin, each fenced
+// once the GPU is done with it so writing never waits on the frame in flight.
+// Persistently mapped when the context has GL 4.4, mapped unsynchronized per frame otherwise.
+// Shaders fetch matrix (base + gl_InstanceID * boneCount + bone), see skinning.vert.
+//
+// per frame: BeginFrame(), Allocate()/Upload() for every instance, Commit(), draws, EndFrame()
+class BonePaletteBuffer
+{
+public:
+	BonePaletteBuffer(uint32_t matricesPerFrame);
+	~BonePaletteBuffer();
+
+	void BeginFrame();
+
+	// reserves count matrices in this frame's segment, returns the index of the first
+	uint32_t Allocate(uint32_t count, aiMatrix4x4** ppMatrices);
+	uint32_t Upload(const aiMatrix4x4* pMatrices, uint32_t count);
+
+	// makes this frame's matrices visible to the GPU, call before the draws
+	void Commit();
+	void EndFrame();
+
+	// binds the texture buffer and points gBonePalette at it, the program has to be in use
+	void Bind(ShaderProgram& shader);
+
+	uint32_t Capacity() const { return mMatricesPerFrame; }
+	bool IsPersistent() const { return mpPersistent != nullptr; }
+
+private:
+	uint32_t mMatricesPerFrame;
+	uint32_t mFrame = 0;
+	uint32_t mUsed = 0;
+	uint32_t mBuffer = 0;
+	uint32_t mTexture = 0;
+	GLsync mFences[BONE_PALETTE_FRAMES] = {};
+	uint8_t* mpPersistent = nullptr;
+	uint8_t* mpMapped = nullptr;
+};
+
+
+/////////////////////
+// BAKED ANIMATION
+#define BAKED_ANIMATION_TEXTURE_UNIT 14
+
+// One clip of a skinned mesh sampled offline into a float texture, so background crowds
+// animate without any per instance CPU work. Row f holds frame f's bone palette, three
+// texels per bone (the top rows of the aiMatrix4x4), the first frame is repeated as the last
+// row so the shader can always lerp towards the next one. See baked_skinning.vert.
+//
+// Instances are drawn with the mesh's instanced path, each instance's time offset in
+// seconds rides in the otherwise unused bottom row of its model matrix (PackInstance).
+class BakedAnimation
+{
+public:
+	BakedAnimation() {}
+	~BakedAnimation();
+
+	void Bake(const SkinnedMesh& mesh, uint32_t clip, float framesPerSecond = 30.0f);
+
+	// instance matrix for SkinnedMesh::instanceVBO, the shader clears the offset again
+	static glm::mat4 PackInstance(const glm::mat4& model, float timeOffset)
+	{
+		glm::mat4 packed = model;
+		packed[0][3] = timeOffset;
+		return packed;
+	}
+
+	// binds the texture and sets the bake uniforms, the program has to be in use
+	void Bind(ShaderProgram& shader);
+
+	uint32_t FrameCount() const { return mFrameCount; }
+	uint32_t BoneCount() const { return mBoneCount; }
+
+private:
+	uint32_t mTexture = 0;
+	uint32_t mBoneCount = 0;
+	uint32_t mFrameCount = 0;
+	float mFrameRate = 0.0f; // frames per second of clip time, fits the loop exactly, 0 for a single frame clip
+};
+
+
+/////////////////////
+// ASSET LOADER
+#define ASSET_LOADER_BUDGET_MS 2.0f
+
+// Loads meshes and their textures without stalling the frame. Reading, importing and decoding
+// run as jobs; what they produce waits until Update(), called once per frame on the render
+// thread, uploads it until the frame's budget is spent. A mesh draws as soon as its buffers
+// are up and its textures fill in over the next frames. Textures already in gTextureRegistry
+// are shared straight away, the others are decoded once however many meshes wait on them.
+//
+// Give the loader a JobSystem of its own, a Wait() on a shared one would pick up decode jobs
+// on the render thread. Meshes have to stay alive until IsIdle().
+class AssetLoader
+{
+public:
+	struct Stats
+	{
+		AssetTimings meshes;
+		AssetTimings textures;
+		uint32_t meshCount = 0;
+		uint32_t textureCount = 0;
+		uint32_t frames = 0;	 // Update calls that uploaded something
+		double maxFrameMs = 0.0; // longest of them
+		double wallMs = 0.0;	 // first request to the last upload
+	};
+
+	AssetLoader(JobSystem* pJobSystem);
+	~AssetLoader(); // waits for the jobs in flight
+
+	// the mesh is filled in over the next Update calls, see SkinnedMesh::IsLoaded
+	void LoadMesh(SkinnedMesh* pMesh, const std::string& Filename, uint32_t instanceCount = 0);
+
+	// render thread, once per frame, uploads at least one asset per call so loading always moves on
+	void Update(float budgetMs = ASSET_LOADER_BUDGET_MS);
+
+	// render thread, forgets the mesh in whatever is still queued for it, ~SkinnedMesh calls it
+	void Cancel(SkinnedMesh* pMesh);
+
+	bool IsIdle() const
+	{
+		return mPending == 0;
+	}
+
+	const Stats& GetStats() const
+	{
+		return mStats;
+	}
+
+	void PrintStats() const;
 
-	const aiScene* m_pScene;
-	Assimp::Importer m_Importer;
+private:
+	struct Item;
+
+	static void loadJob(void* pData, uint32 index);
+	void schedule(Item* pItem);
+	void upload(Item* pItem);
+	void release(SkinnedMesh* pMesh);
+
+	JobSystem* mpJobSystem;
+	JobCounter mCounter;
+
+	std::mutex mReadyMutex;
+	std::vector<Item*> mReady; // loaded on a worker, not yet seen by Update
+
+	// render thread only from here on
+	std::deque<Item*> mUploads;
+	std::unordered_map<std::string, Item*> mTextures; // in flight by full path, with every mesh waiting on them
+	std::vector<Item*> mMeshes; // mesh items not uploaded yet
+	std::unordered_map<SkinnedMesh*, uint32_t> mWaiting; // items each mesh is still waiting for
+	uint32_t mPending = 0;
+	Stats mStats;
+	Clock::time_point mStart;
 };
 
 
@@ -249,6 +500,78 @@ private:
 
 uint32_t LoadTexture(const char*, bool isHDR = false);
 
+// LoadTexture in two halves, see AssetLoader
+struct TextureImage
+{
+	TextureImage() {}
+	~TextureImage();
+
+	TextureImage(const TextureImage&) = delete;
+	TextureImage& operator=(const TextureImage&) = delete;
+
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	const unsigned char* pPixels = NULL; // into cached or pDecoded
+
+	CookedMeshFile cached;
+	unsigned char* pDecoded = NULL;
+};
+
+// reads and decodes, or maps the decoded pixels from the asset cache, any thread
+bool DecodeTexture(const char* path, TextureImage& image, AssetTimings* pTimings = NULL);
+// render thread
+uint32_t UploadTexture(const TextureImage& image, bool isHDR = false);
+
+// DecodeTexture keeps decoded pixels in the asset cache, see CookedMesh.h
+extern bool gUseTextureCache;
+
+// Textures shared by every model and material in the process, so a file referenced twice is
+// decoded and uploaded once. Keyed on the canonical path plus the settings that give a different
+// GL texture, counted per reference and deleted with the last one. Render thread only.
+// LoadTexture stays an unshared load owned by the caller.
+class TextureRegistry
+{
+public:
+	// loads on the first reference
+	uint32_t Acquire(const char* path, bool isHDR = false);
+	// adds a reference when the texture is resident, 0 otherwise
+	uint32_t Find(const char* path, bool isHDR = false);
+	// registers a texture uploaded by the caller, who holds the first reference. When the key
+	// became resident in the meantime the new texture is deleted and the resident one returned
+	uint32_t Add(const char* path, uint32_t id, bool isHDR = false);
+
+	void AddRef(uint32_t id);
+	// ignores textures the registry doesn't own
+	void Release(uint32_t id);
+
+	static std::string Key(const char* path, bool isHDR = false);
+
+	uint32_t ResidentCount() const
+	{
+		return (uint32_t)mEntries.size();
+	}
+
+	// references served without loading anything
+	uint32_t SharedCount() const
+	{
+		return mShared;
+	}
+
+private:
+	struct Entry
+	{
+		uint32_t id;
+		uint32_t refs;
+	};
+
+	std::unordered_map<std::string, Entry> mEntries;
+	std::unordered_map<uint32_t, std::string> mKeys; // id back to its key, for Release
+	uint32_t mShared = 0;
+};
+
+extern TextureRegistry gTextureRegistry;
+
 struct InstanceData
 {
 	glm::mat4 model;
@@ -269,6 +592,7 @@ struct PBRMat_Tex
 #define INVALID_TEXTURE_ID -1
 
 	~PBRMat_Tex();
+	// shared through gTextureRegistry with every other material using the file
 	void LoadPBRTexture(const char* filepath, PBRTextureType type);
 	void BindTextures();
 
@@ -330,6 +654,10 @@ public:
 	void UpdateSphereInstanceBuffer(uint32_t size, void* data);
 	void RenderSphereInstanced(int numOfInstances);
 
+	// every instance of mesh (loaded with an instance count) plays the baked clip at
+	// time + its own offset, CPU cost is the same for ten or ten thousand instances
+	void RenderBakedInstanced(SkinnedMesh& mesh, BakedAnimation& animation, ShaderProgram& shader, float time);
+
 	glm::mat4 ModelMatForLineBWTwoPoints(glm::vec3 A, glm::vec3 B);
 
 private: